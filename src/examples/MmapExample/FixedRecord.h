@@ -0,0 +1,20 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <cstdint>
+
+/// One event's worth of raw data, laid out in memory exactly as it is laid out in the file. Because the layout
+/// matches, FixedRecordSource never decodes anything: it points each event at its record inside the mapped file.
+/// (Files are assumed to come from a machine with the same endianness.)
+struct FixedRecord {
+    static constexpr uint32_t MaxHits = 8;
+
+    uint64_t event_number;
+    uint32_t run_number;
+    uint32_t hit_count;             // Number of valid entries in hit_energy
+    float hit_energy[MaxHits];      // Energy loss in GeV
+};
+
+static_assert(sizeof(FixedRecord) == 48, "FixedRecord must not contain padding, since it mirrors the file format");
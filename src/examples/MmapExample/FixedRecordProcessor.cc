@@ -0,0 +1,36 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "FixedRecordProcessor.h"
+#include "FixedRecord.h"
+
+#include <JANA/JEvent.h>
+#include <JANA/JEventSourceMmap.h>
+#include <JANA/JLogger.h>
+
+
+FixedRecordProcessor::FixedRecordProcessor() {
+    SetTypeName(NAME_OF_THIS);
+    SetCallbackStyle(CallbackStyle::ExpertMode);
+}
+
+void FixedRecordProcessor::Process(const JEvent& event) {
+
+    auto record = event.GetSingle<JMappedView>()->As<FixedRecord>();
+
+    double energy = 0;
+    for (uint32_t i=0; i<record->hit_count && i<FixedRecord::MaxHits; ++i) {
+        energy += record->hit_energy[i];
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_event_count += 1;
+    m_hit_count += record->hit_count;
+    m_total_energy += energy;
+}
+
+void FixedRecordProcessor::Finish() {
+    LOG << "FixedRecordProcessor: " << m_event_count << " events, " << m_hit_count << " hits, "
+        << m_total_energy << " GeV in total" << LOG_END;
+}
@@ -0,0 +1,23 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JEventProcessor.h>
+
+#include <mutex>
+
+/// Sums the hit energies of every FixedRecord, reading them directly out of the mapped file
+class FixedRecordProcessor : public JEventProcessor {
+
+    std::mutex m_mutex;
+    size_t m_event_count = 0;
+    size_t m_hit_count = 0;
+    double m_total_energy = 0;
+
+public:
+    FixedRecordProcessor();
+
+    void Process(const JEvent&) override;
+    void Finish() override;
+};
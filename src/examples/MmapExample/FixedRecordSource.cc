@@ -0,0 +1,56 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "FixedRecordSource.h"
+#include "FixedRecord.h"
+
+#include <JANA/JEvent.h>
+
+
+FixedRecordSource::FixedRecordSource(std::string resource_name, JApplication* app)
+    : JEventSourceMmap(std::move(resource_name), app) {
+    SetTypeName(NAME_OF_THIS);
+    SetCallbackStyle(CallbackStyle::ExpertMode);
+}
+
+void FixedRecordSource::Open() {
+    /// By the time Open() is called, JEventSourceMmap has already mapped the file, so we can sanity-check it here
+    if (GetMappedSize() % sizeof(FixedRecord) != 0) {
+        throw JException("'%s' is not a whole number of FixedRecords", GetResourceName().c_str());
+    }
+    m_offset = 0;
+}
+
+JEventSource::Result FixedRecordSource::Emit(JEvent& event) {
+
+    if (m_offset + sizeof(FixedRecord) > GetMappedSize()) {
+        return Result::FailureFinished;
+    }
+
+    /// The view points straight into the mapping; no bytes are copied. The event keeps the mapping alive until it
+    /// gets recycled, even if the source has already closed by then.
+    auto view = AttachView(event, m_offset, sizeof(FixedRecord));
+    auto record = view->As<FixedRecord>();
+    event.SetEventNumber(record->event_number);
+    event.SetRunNumber(record->run_number);
+
+    m_offset += sizeof(FixedRecord);
+    return Result::Success;
+}
+
+std::string FixedRecordSource::GetDescription() {
+    return "Memory-mapped file of FixedRecords";
+}
+
+
+template <>
+double JEventSourceGeneratorT<FixedRecordSource>::CheckOpenable(std::string resource_name) {
+    /// Claim anything ending in '.rec'
+    const std::string extension = ".rec";
+    if (resource_name.size() >= extension.size() &&
+        resource_name.compare(resource_name.size() - extension.size(), extension.size(), extension) == 0) {
+        return 0.5;
+    }
+    return 0.0;
+}
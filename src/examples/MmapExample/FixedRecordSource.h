@@ -0,0 +1,26 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JEventSourceMmap.h>
+#include <JANA/JEventSourceGeneratorT.h>
+
+/// Reads files consisting of nothing but back-to-back FixedRecords. Each event receives a JMappedView of its own
+/// record, which downstream code reinterprets in place via JMappedView::As<FixedRecord>().
+class FixedRecordSource : public JEventSourceMmap {
+
+    size_t m_offset = 0;
+
+public:
+    FixedRecordSource(std::string resource_name, JApplication* app);
+
+    void Open() override;
+
+    Result Emit(JEvent&) override;
+
+    static std::string GetDescription();
+};
+
+template <>
+double JEventSourceGeneratorT<FixedRecordSource>::CheckOpenable(std::string);
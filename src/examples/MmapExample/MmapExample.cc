@@ -0,0 +1,51 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <JANA/JApplication.h>
+
+#include "FixedRecord.h"
+#include "FixedRecordProcessor.h"
+#include "FixedRecordSource.h"
+
+#include <fstream>
+
+
+/// Writes `nrecords` FixedRecords to `path`, so that the example has something to read
+void WriteSampleFile(const std::string& path, size_t nrecords) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw JException("Unable to write sample file '%s'", path.c_str());
+    }
+    for (size_t i=0; i<nrecords; ++i) {
+        FixedRecord record {};
+        record.event_number = i + 1;
+        record.run_number = 22 + i / 1000;
+        record.hit_count = i % (FixedRecord::MaxHits + 1);
+        for (uint32_t h=0; h<record.hit_count; ++h) {
+            record.hit_energy[h] = 0.1f * (h + 1);
+        }
+        file.write(reinterpret_cast<const char*>(&record), sizeof(FixedRecord));
+    }
+}
+
+
+extern "C" {
+void InitPlugin(JApplication* app) {
+
+    InitJANAPlugin(app);
+
+    LOG << "Loading MmapExample" << LOG_END;
+    app->Add(new JEventSourceGeneratorT<FixedRecordSource>);   // Opens any '*.rec' file given on the command line
+    app->Add(new FixedRecordProcessor);
+
+    std::string sample_file;
+    size_t sample_records = 10000;
+    app->SetDefaultParameter("mmap_example:write_sample", sample_file, "If set, write a sample file of FixedRecords to this path and read it");
+    app->SetDefaultParameter("mmap_example:sample_records", sample_records, "Number of FixedRecords in the sample file");
+    if (!sample_file.empty()) {
+        WriteSampleFile(sample_file, sample_records);
+        app->Add(sample_file);
+    }
+}
+}
@@ -0,0 +1,23 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+
+#ifndef _HitSchema_h_
+#define _HitSchema_h_
+
+#include <array>
+#include <tuple>
+
+/// The same data as Hit, but laid out as columns in a JSoA<HitSchema> table instead of as individual JObjects.
+/// Each column lives in its own contiguous array, so a loop over (say) every hit's energy can be vectorized.
+/// The enum gives each column a name for use with JSoA::column<HitSchema::E>() and friends.
+
+struct HitSchema {
+    using Columns = std::tuple<int, int, double, double>;
+    enum Column { x, y, E, t };
+    static constexpr std::array<const char*, 4> names {"x", "y", "E", "t"};
+};
+
+
+#endif // _HitSchema_h_
@@ -10,6 +10,7 @@
 
 /// Include headers to any JObjects you wish to associate with each event
 #include "Hit.h"
+#include "HitSchema.h"
 
 /// There are two different ways of instantiating JEventSources
 /// 1. Creating them manually and registering them with the JApplication
@@ -69,6 +70,13 @@ JEventSource::Result RandomSource::Emit(JEvent& event) {
     hits.push_back(new Hit(1, 1, 1.0, 0));
     event.Insert(hits);
 
+    /// The same hits again, as a columnar table for SimpleClusterSoAFactory
+    auto hit_table = new JSoA<HitSchema>;
+    for (const Hit* hit : hits) {
+        hit_table->push_back(hit->x, hit->y, hit->E, hit->t);
+    }
+    event.Insert(hit_table);
+
     /// If you are reading a file of events and have reached the end
     /// Note that you should close the file handle in Close(), not here.
     // return Result::FailureFinished;
@@ -0,0 +1,63 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "SimpleClusterSoAFactory.h"
+#include "HitSchema.h"
+
+#include <JANA/JEvent.h>
+
+SimpleClusterSoAFactory::SimpleClusterSoAFactory() {
+    SetTag("soa");
+}
+
+void SimpleClusterSoAFactory::Process(const std::shared_ptr<const JEvent> &event) {
+
+    /// Acquire the hits as columns. This is a single table, no matter how many hits there are.
+    const auto& hits = event->GetSoA<HitSchema>();
+    const size_t n = hits.size();
+    const int* x = hits.data<HitSchema::x>();
+    const int* y = hits.data<HitSchema::y>();
+    const double* E = hits.data<HitSchema::E>();
+    const double* t = hits.data<HitSchema::t>();
+
+    /// The loop streams through contiguous arrays with no pointer chasing. Keeping L independent
+    /// accumulators per quantity lets the compiler put them in SIMD registers without having to
+    /// reorder any floating-point additions, which it is otherwise not allowed to do.
+    constexpr size_t L = 4;
+    long x_sum[L] = {}, y_sum[L] = {};
+    double E_tot[L] = {}, t_begin[L] = {}, t_end[L] = {};
+    size_t i = 0;
+    for (; i+L<=n; i+=L) {
+        for (size_t l=0; l<L; ++l) {
+            x_sum[l] += x[i+l];
+            y_sum[l] += y[i+l];
+            E_tot[l] += E[i+l];
+            t_begin[l] = (t[i+l] < t_begin[l]) ? t[i+l] : t_begin[l];
+            t_end[l] = (t[i+l] > t_end[l]) ? t[i+l] : t_end[l];
+        }
+    }
+    for (; i<n; ++i) {
+        x_sum[0] += x[i];
+        y_sum[0] += y[i];
+        E_tot[0] += E[i];
+        t_begin[0] = (t[i] < t_begin[0]) ? t[i] : t_begin[0];
+        t_end[0] = (t[i] > t_end[0]) ? t[i] : t_end[0];
+    }
+
+    /// Combine the lanes
+    auto cluster = new Cluster(0, 0, 0, t_begin[0], t_end[0]);
+    for (size_t l=0; l<L; ++l) {
+        cluster->x_center += x_sum[l];
+        cluster->y_center += y_sum[l];
+        cluster->E_tot += E_tot[l];
+        if (cluster->t_begin > t_begin[l]) cluster->t_begin = t_begin[l];
+        if (cluster->t_end < t_end[l]) cluster->t_end = t_end[l];
+    }
+    cluster->x_center /= n;
+    cluster->y_center /= n;
+
+    /// Publish outputs
+    Insert(cluster);
+}
+
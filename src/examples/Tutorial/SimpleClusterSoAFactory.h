@@ -0,0 +1,23 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef _SimpleClusterSoAFactory_h_
+#define _SimpleClusterSoAFactory_h_
+
+#include <JANA/JFactoryT.h>
+
+#include "Cluster.h"
+
+/// SimpleClusterSoAFactory computes the same Cluster as SimpleClusterFactory, but from the columnar
+/// JSoA<HitSchema> table instead of from individual Hit objects. Its output has the tag "soa".
+
+class SimpleClusterSoAFactory : public JFactoryT<Cluster> {
+
+public:
+    SimpleClusterSoAFactory();
+    void Process(const std::shared_ptr<const JEvent> &event) override;
+
+};
+
+#endif // _SimpleClusterSoAFactory_h_
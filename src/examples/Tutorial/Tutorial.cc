@@ -11,6 +11,7 @@
 #include "RandomSource.h"
 #include "Hit.h"
 #include "SimpleClusterFactory.h"
+#include "SimpleClusterSoAFactory.h"
 
 extern "C" {
 void InitPlugin(JApplication* app) {
@@ -21,6 +22,7 @@ void InitPlugin(JApplication* app) {
     app->Add(new TutorialProcessor);
     app->Add(new JCsvWriter<Hit>);
     app->Add(new JFactoryGeneratorT<SimpleClusterFactory>);
+    app->Add(new JFactoryGeneratorT<SimpleClusterSoAFactory>);
 
     app->Add(new RandomSource("random", app));            // Always use RandomSource
     //app->Add(new JEventSourceGeneratorT<RandomSource>); // Only use RandomSource when
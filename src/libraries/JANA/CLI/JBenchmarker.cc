@@ -4,10 +4,15 @@
 
 #include "JBenchmarker.h"
 
+#include <JANA/JEventSource.h>
 #include <JANA/Utils/JCpuInfo.h>
+#include <JANA/Utils/JTablePrinter.h>
+#include <JANA/Services/JComponentManager.h>
 #include <JANA/Services/JLoggingService.h>
 
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <cmath>
 #include <sys/stat.h>
 #include <iostream>
@@ -71,6 +76,7 @@ void JBenchmarker::RunUntilFinished() {
 
     m_app->SetTicker(false);
     m_app->Run(false);
+    auto start_time = std::chrono::steady_clock::now();
 
     // Wait for events to start flowing indicating the source is primed
     for (int i = 0; i < 5; i++) {
@@ -146,6 +152,8 @@ void JBenchmarker::RunUntilFinished() {
     }
     ofs2.close();
 
+    report_source_times(std::chrono::steady_clock::now() - start_time);
+
     if (m_copy_script) {
         copy_to_output_dir("${JANA_HOME}/bin/jana-plot-scaletest.py");
         LOG_INFO(m_logger)
@@ -220,3 +228,56 @@ void JBenchmarker::copy_to_output_dir(std::string filename) {
 
 
 
+
+
+/// Splits each source's time into the serial part (Emit, under the source's lock) and the parallel part (Preprocess),
+/// since the serial fraction bounds how far reading that source can scale. Also reports how busy the source's lock
+/// was over the whole benchmark: close to 100% means the source itself is the bottleneck.
+void JBenchmarker::report_source_times(std::chrono::steady_clock::duration elapsed) {
+
+    double elapsed_s = std::chrono::duration<double>(elapsed).count();
+
+    JTablePrinter table;
+    table.AddColumn("Source", JTablePrinter::Justify::Left);
+    table.AddColumn("Emit [s]", JTablePrinter::Justify::Right);
+    table.AddColumn("Preprocess [s]", JTablePrinter::Justify::Right);
+    table.AddColumn("Serial fraction", JTablePrinter::Justify::Right);
+    table.AddColumn("Max speedup", JTablePrinter::Justify::Right);
+    table.AddColumn("Lock busy", JTablePrinter::Justify::Right);
+
+    std::ofstream ofs(m_output_dir + "/sources.dat");
+    ofs << "# emit_s  preprocess_s  serial_fraction  lock_busy  source" << std::endl;
+
+    for (JEventSource* source : m_app->GetService<JComponentManager>()->get_evt_srces()) {
+        double emit_s = std::chrono::duration<double>(source->GetEmitTime()).count();
+        double preprocess_s = std::chrono::duration<double>(source->GetPreprocessTime()).count();
+        double total_s = emit_s + preprocess_s;
+        double serial_fraction = (total_s > 0) ? emit_s / total_s : 1.0;
+        double lock_busy = (elapsed_s > 0) ? emit_s / elapsed_s : 0.0;
+
+        // By Amdahl's law, no number of threads can read this source faster than 1/serial_fraction times its
+        // single-threaded speed
+        std::ostringstream max_speedup;
+        if (serial_fraction > 0) {
+            max_speedup << std::setprecision(1) << std::fixed << 1.0 / serial_fraction << "x";
+        }
+        else {
+            max_speedup << "unbounded";
+        }
+        std::ostringstream emit_str, preprocess_str, serial_str, busy_str;
+        emit_str << std::setprecision(3) << std::fixed << emit_s;
+        preprocess_str << std::setprecision(3) << std::fixed << preprocess_s;
+        serial_str << std::setprecision(1) << std::fixed << 100.0 * serial_fraction << "%";
+        busy_str << std::setprecision(1) << std::fixed << 100.0 * lock_busy << "%";
+
+        std::string name = source->GetResourceName().empty() ? source->GetTypeName()
+                                                             : source->GetTypeName() + " (" + source->GetResourceName() + ")";
+        table | name | emit_str.str() | preprocess_str.str() | serial_str.str() | max_speedup.str() | busy_str.str();
+
+        ofs << std::setprecision(6) << std::fixed << emit_s << " " << preprocess_s << " "
+            << serial_fraction << " " << lock_busy << " " << name << std::endl;
+    }
+    ofs.close();
+
+    LOG_INFO(m_logger) << "Time spent reading each source, serial (Emit) vs parallel (Preprocess):\n" << table << LOG_END;
+}
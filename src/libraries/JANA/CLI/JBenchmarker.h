@@ -5,6 +5,8 @@
 #pragma once
 #include <JANA/JApplication.h>
 
+#include <chrono>
+
 class JBenchmarker {
 
     JApplication* m_app;
@@ -24,6 +26,7 @@ public:
 
 private:
     void copy_to_output_dir(std::string filename);
+    void report_source_times(std::chrono::steady_clock::duration elapsed);
 };
 
 
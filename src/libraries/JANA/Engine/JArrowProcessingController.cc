@@ -26,6 +26,10 @@ void JArrowProcessingController::acquire_services(JServiceLocator * sl) {
     params->SetDefaultParameter("jana:timeout", m_timeout_s, "Max time (in seconds) JANA will wait for a thread to update its heartbeat before hard-exiting. 0 to disable timeout completely.");
     params->SetDefaultParameter("jana:warmup_timeout", m_warmup_timeout_s, "Max time (in seconds) JANA will wait for 'initial' events to complete before hard-exiting.");
     // Originally "THREAD_TIMEOUT" and "THREAD_TIMEOUT_FIRST_EVENT"
+    params->SetDefaultParameter("jana:enable_worker_parking", m_enable_worker_parking, "Idle workers park on the queue or pool they are starved on and are woken when it is refilled, instead of sleeping through their backoff. Reduces latency at low event rates.")
+        ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:worker_park_spin_count", m_worker_park_spin_count, "Number of times a parking worker polls its queue or pool before blocking.")
+        ->SetIsAdvanced(true);
 }
 
 void JArrowProcessingController::initialize() {
@@ -52,16 +56,9 @@ void JArrowProcessingController::run(size_t nthreads) {
     // run_topology needs to happen _before_ threads are started so that threads don't quit due to lack of assignments
     m_scheduler->run_topology(nthreads);
 
-    bool pin_to_cpu = (m_topology->mapping.get_affinity() != JProcessorMapping::AffinityStrategy::None);
-
-    size_t next_worker_id = 0;
-    while (next_worker_id < nthreads) {
-        size_t next_cpu_id = m_topology->mapping.get_cpu_id(next_worker_id);
-        size_t next_loc_id = m_topology->mapping.get_loc_id(next_worker_id);
-        auto worker = new JWorker(this, m_scheduler, next_worker_id, next_cpu_id, next_loc_id, pin_to_cpu);
-        worker->logger = m_worker_logger;
-        m_workers.push_back(worker);
-        next_worker_id++;
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
+    while (m_workers.size() < nthreads) {
+        m_workers.push_back(create_worker(m_workers.size()));
     }
     for (size_t i=0; i<nthreads; ++i) {
         m_workers.at(i)->start();
@@ -71,9 +68,42 @@ void JArrowProcessingController::run(size_t nthreads) {
     // the supervisor thread waiting forever for workers to reach RunState::Running when they've already Stopped.
 }
 
+/// @brief Changes the number of worker threads.
+///
+/// If the topology is running, this happens without pausing it: scaling up starts additional JWorkers
+/// alongside the existing ones, and scaling down asks the highest-numbered workers to stop at their next
+/// check-in with the scheduler, handing their assignments back, and then joins them. Events in flight
+/// are unaffected either way. If the topology isn't running (e.g. it is paused), the workers are resized
+/// and the topology is (re)started, as before.
 void JArrowProcessingController::scale(size_t nthreads) {
 
-    LOG_INFO(m_logger) << "scale(): Stopping all running workers" << LOG_END;
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
+
+    if (m_scheduler->rescale_topology(nthreads, get_monotonic_event_count())) {
+        size_t old_nthreads = m_workers.size();
+        if (nthreads > old_nthreads) {
+            LOG_INFO(m_logger) << "scale(): Starting " << (nthreads - old_nthreads) << " additional workers" << LOG_END;
+            while (m_workers.size() < nthreads) {
+                JWorker* worker = create_worker(m_workers.size());
+                m_workers.push_back(worker);
+                worker->start();
+            }
+        }
+        else if (nthreads < old_nthreads) {
+            LOG_INFO(m_logger) << "scale(): Retiring " << (old_nthreads - nthreads) << " workers" << LOG_END;
+            for (size_t i=nthreads; i<old_nthreads; ++i) {
+                m_workers[i]->request_stop();
+            }
+            for (size_t i=nthreads; i<old_nthreads; ++i) {
+                m_workers[i]->wait_for_stop();
+                delete m_workers[i];
+            }
+            m_workers.resize(nthreads);
+        }
+        return;
+    }
+
+    LOG_INFO(m_logger) << "scale(): Topology is not running, so stopping all workers" << LOG_END;
     m_scheduler->request_topology_pause();
     for (JWorker* worker : m_workers) {
         worker->wait_for_stop();
@@ -81,29 +111,46 @@ void JArrowProcessingController::scale(size_t nthreads) {
     m_scheduler->achieve_topology_pause();
 
     LOG_INFO(m_logger) << "scale(): All workers are stopped" << LOG_END;
-    bool pin_to_cpu = (m_topology->mapping.get_affinity() != JProcessorMapping::AffinityStrategy::None);
-    size_t next_worker_id = m_workers.size();
-
-    while (next_worker_id < nthreads) {
-
-        size_t next_cpu_id = m_topology->mapping.get_cpu_id(next_worker_id);
-        size_t next_loc_id = m_topology->mapping.get_loc_id(next_worker_id);
-
-        auto worker = new JWorker(this, m_scheduler, next_worker_id, next_cpu_id, next_loc_id, pin_to_cpu);
-        worker->logger = m_worker_logger;
-        m_workers.push_back(worker);
-        next_worker_id++;
+    while (m_workers.size() > nthreads) {
+        delete m_workers.back();
+        m_workers.pop_back();
+    }
+    while (m_workers.size() < nthreads) {
+        m_workers.push_back(create_worker(m_workers.size()));
     }
 
     LOG_INFO(m_logger) << "scale(): Restarting " << nthreads << " workers" << LOG_END;
     // topology->run needs to happen _before_ threads are started so that threads don't quit due to lack of assignments
     m_scheduler->run_topology(nthreads);
 
-    for (size_t i=0; i<nthreads; ++i) {
-        m_workers.at(i)->start();
+    for (JWorker* worker : m_workers) {
+        worker->start();
     };
 }
 
+JWorker* JArrowProcessingController::create_worker(size_t worker_id) {
+    bool pin_to_cpu = (m_topology->mapping.get_affinity() != JProcessorMapping::AffinityStrategy::None);
+    size_t cpu_id = m_topology->mapping.get_cpu_id(worker_id);
+    size_t loc_id = m_topology->mapping.get_loc_id(worker_id);
+    auto worker = new JWorker(this, m_scheduler, worker_id, cpu_id, loc_id, pin_to_cpu);
+    worker->logger = m_worker_logger;
+    worker->set_parking(m_enable_worker_parking, m_worker_park_spin_count);
+    if (m_topology->m_enable_parallel_factories) {
+        worker->set_task_queue(&m_topology->task_queue);
+    }
+    return worker;
+}
+
+size_t JArrowProcessingController::get_monotonic_event_count() {
+    size_t monotonic_event_count = 0;
+    for (JArrow* arrow : m_topology->arrows) {
+        if (arrow->is_sink()) {
+            monotonic_event_count += arrow->get_metrics().get_total_message_count();
+        }
+    }
+    return monotonic_event_count;
+}
+
 void JArrowProcessingController::request_pause() {
     m_scheduler->request_topology_pause();
     // Or:
@@ -113,6 +160,7 @@ void JArrowProcessingController::request_pause() {
 }
 
 void JArrowProcessingController::wait_until_paused() {
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (JWorker* worker : m_workers) {
         worker->wait_for_stop();
     }
@@ -136,6 +184,7 @@ void JArrowProcessingController::request_stop() {
 
 void JArrowProcessingController::wait_until_stopped() {
     // Join all workers
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (JWorker* worker : m_workers) {
         worker->wait_for_stop();
     }
@@ -176,8 +225,9 @@ bool JArrowProcessingController::is_timed_out() {
     }
 
     // Find all workers whose last heartbeat exceeds timeout
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     bool found_timeout = false;
-    for (size_t i=0; i<metrics->workers.size(); ++i) {
+    for (size_t i=0; i<metrics->workers.size() && i<m_workers.size(); ++i) {
         if (metrics->workers[i].last_heartbeat_ms > (timeout_s * 1000)) {
             found_timeout = true;
             m_workers[i]->declare_timeout();
@@ -189,6 +239,7 @@ bool JArrowProcessingController::is_timed_out() {
 }
 
 bool JArrowProcessingController::is_excepted() {
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (auto worker : m_workers) {
         if (worker->get_runstate() == JWorker::RunState::Excepted) {
             return true;
@@ -199,6 +250,7 @@ bool JArrowProcessingController::is_excepted() {
 
 std::vector<JException> JArrowProcessingController::get_exceptions() const {
     std::vector<JException> exceptions;
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (auto worker : m_workers) {
         if (worker->get_runstate() == JWorker::RunState::Excepted) {
             exceptions.push_back(worker->get_exception());
@@ -244,20 +296,18 @@ std::unique_ptr<const JPerfSummary> JArrowProcessingController::measure_performa
 
     // Measure perf on all Workers first, as this will prompt them to publish
     // any ArrowMetrics they have collected
-    if (m_perf_summary.workers.size() != m_workers.size()) {
-        m_perf_summary.workers = std::vector<WorkerSummary>(m_workers.size());
-    }
-    for (size_t i=0; i<m_workers.size(); ++i) {
-        m_workers[i]->measure_perf(m_perf_summary.workers[i]);
-    }
-
-    size_t monotonic_event_count = 0;
-    for (JArrow* arrow : m_topology->arrows) {
-        if (arrow->is_sink()) {
-            monotonic_event_count += arrow->get_metrics().get_total_message_count();
+    {
+        std::lock_guard<std::mutex> lock(m_workers_mutex);
+        if (m_perf_summary.workers.size() != m_workers.size()) {
+            m_perf_summary.workers = std::vector<WorkerSummary>(m_workers.size());
+        }
+        for (size_t i=0; i<m_workers.size(); ++i) {
+            m_workers[i]->measure_perf(m_perf_summary.workers[i]);
         }
     }
 
+    size_t monotonic_event_count = get_monotonic_event_count();
+
     // Uptime
     m_topology->metrics.split(monotonic_event_count);
     m_topology->metrics.summarize(m_perf_summary);
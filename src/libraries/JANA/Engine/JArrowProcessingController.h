@@ -8,6 +8,7 @@
 #include <JANA/Engine/JWorker.h>
 #include <JANA/Engine/JPerfSummary.h>
 
+#include <mutex>
 #include <vector>
 
 class JArrowProcessingController : public JService {
@@ -48,14 +49,21 @@ private:
     using jclock_t = std::chrono::steady_clock;
     int m_timeout_s = 8;
     int m_warmup_timeout_s = 30;
+    bool m_enable_worker_parking = false;
+    size_t m_worker_park_spin_count = 100;
 
     JPerfSummary m_perf_summary;
     JScheduler* m_scheduler = nullptr;
 
+    // Guards m_workers itself, so that scale() can start and retire workers while the supervisor is looking at them
+    mutable std::mutex m_workers_mutex;
     std::vector<JWorker*> m_workers;
     JLogger m_logger;
     JLogger m_worker_logger;
     JLogger m_scheduler_logger;
 
+    JWorker* create_worker(size_t worker_id);
+    size_t get_monotonic_event_count();
+
 };
 
@@ -22,9 +22,9 @@ std::ostream& operator<<(std::ostream& os, const JPerfSummary& s) {
     os << "  Efficiency [0..1]:           " << std::setprecision(3) << s.avg_efficiency_frac << std::endl;
     os << std::endl;
 
-    os << "  +--------------------------+--------+-----+---------+-------+--------+---------+-------------+" << std::endl;
-    os << "  |           Name           |  Type  | Par | Threads | Chunk | Thresh | Pending |  Completed  |" << std::endl;
-    os << "  +--------------------------+--------+-----+---------+-------+--------+---------+-------------+" << std::endl;
+    os << "  +--------------------------+--------+-----+---------+-------+--------+---------+-------------+----------+" << std::endl;
+    os << "  |           Name           |  Type  | Par | Threads | Chunk | Thresh | Pending |  Completed  |  Stolen  |" << std::endl;
+    os << "  +--------------------------+--------+-----+---------+-------+--------+---------+-------------+----------+" << std::endl;
 
     for (auto as : s.arrows) {
         os << "  | "
@@ -44,9 +44,10 @@ std::ostream& operator<<(std::ostream& os, const JPerfSummary& s) {
             os << "      - |       - |";
         }
         os << std::setw(12) << as.total_messages_completed << " |"
+           << std::setw(9) << as.total_messages_stolen << " |"
            << std::endl;
     }
-    os << "  +--------------------------+--------+-----+---------+-------+--------+---------+-------------+" << std::endl;
+    os << "  +--------------------------+--------+-----+---------+-------+--------+---------+-------------+----------+" << std::endl;
 
 
     os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+" << std::endl;
@@ -27,6 +27,7 @@ struct ArrowSummary {
     double last_queue_latency_ms;
     double avg_queue_overhead_frac;
     size_t queue_visit_count;
+    size_t total_messages_stolen;
 };
 
 struct WorkerSummary {
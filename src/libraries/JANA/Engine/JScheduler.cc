@@ -2,8 +2,6 @@
 // Copyright 2020, Jefferson Science Associates, LLC.
 // Subject to the terms in the LICENSE file found in the top-level directory.
 
-#include <map>
-
 #include "JScheduler.h"
 #include <JANA/Engine/JScheduler.h>
 #include <JANA/Topology/JTopologyBuilder.h>
@@ -12,30 +10,50 @@
 
 JScheduler::JScheduler(std::shared_ptr<JTopologyBuilder> topology)
     : m_topology(topology)
+    , m_enable_lock_free(topology->m_enable_lockfree_scheduler)
+    , m_policy(JSchedulerPolicy::create(topology->m_scheduler_policy))
     {
         m_topology_state.next_arrow_index = 0;
 
         // Keep track of downstream arrows
-        std::map<JArrow*, size_t> arrow_map;
         size_t i=0;
         for (auto* arrow : topology->arrows) {
-            arrow_map[arrow] = i++;
+            m_arrow_indices[arrow] = i++;
         }
         m_topology_state.arrow_states = std::vector<ArrowState>(topology->arrows.size());
+        m_downstream_arrows.resize(topology->arrows.size());
 
         for (i=0; i<topology->arrows.size(); ++i) {
             auto& as = m_topology_state.arrow_states[i];
             JArrow* arrow = topology->arrows[i];
             as.arrow = arrow;
             for (JArrow* downstream : arrow->m_listeners) {
-                as.downstream_arrow_indices.push_back(arrow_map[downstream]);
+                as.downstream_arrow_indices.push_back(m_arrow_indices[downstream]);
+                m_downstream_arrows[i].push_back(downstream);
             }
         }
     }
 
 
+void JScheduler::set_policy(std::unique_ptr<JSchedulerPolicy> policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(policy != nullptr);
+    m_policy = std::move(policy);
+}
+
+
 JArrow* JScheduler::next_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status last_result) {
 
+    if (m_enable_lock_free) {
+        if (assignment != nullptr) {
+            checkin_lock_free(m_arrow_indices.at(assignment), last_result);
+        }
+        JArrow* next = checkout_lock_free();
+        LOG_TRACE(logger) << "Worker " << worker_id << " assigned: "
+                          << ((next == nullptr) ? "idle" : next->get_name()) << LOG_END;
+        return next;
+    }
+
     std::lock_guard<std::mutex> lock(m_mutex);
 
     LOG_DEBUG(logger) << "Worker " << worker_id << " checking in: "
@@ -57,6 +75,16 @@ JArrow* JScheduler::next_assignment(uint32_t worker_id, JArrow* assignment, JArr
 
 void JScheduler::last_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status last_result) {
 
+    if (m_enable_lock_free) {
+        LOG_DEBUG(logger) << "Worker " << worker_id << " checking in: "
+                          << ((assignment == nullptr) ? "idle" : assignment->get_name())
+                          << " -> " << to_string(last_result) << "). Shutting down!" << LOG_END;
+        if (assignment != nullptr) {
+            checkin_lock_free(m_arrow_indices.at(assignment), last_result);
+        }
+        return;
+    }
+
     std::lock_guard<std::mutex> lock(m_mutex);
 
     LOG_DEBUG(logger) << "Worker " << worker_id << " checking in: "
@@ -71,37 +99,57 @@ void JScheduler::last_assignment(uint32_t worker_id, JArrow* assignment, JArrowM
 
 
 void JScheduler::checkin_unprotected(JArrow* assignment, JArrowMetrics::Status last_result) {
-    // Find index of arrow
-    size_t index = 0;
-    while (m_topology_state.arrow_states[index].arrow != assignment) index++;
-    assert(index < m_topology_state.arrow_states.size());
+    size_t index = m_arrow_indices.at(assignment);
 
     // Decrement arrow's thread count
+    m_topology_state.arrow_states[index].thread_count -= 1;
+    update_arrow_status_unprotected(index, last_result);
+}
+
+
+void JScheduler::update_arrow_status_unprotected(size_t index, JArrowMetrics::Status last_result) {
+
     ArrowState& as = m_topology_state.arrow_states[index];
-    as.thread_count -= 1;
+    JArrow* assignment = as.arrow;
 
-    bool found_inactive_source = 
+    bool found_finished_source = 
         assignment->is_source() && 
         last_result == JArrowMetrics::Status::Finished &&           // Only Sources get to declare themselves finished!
         as.status == ArrowStatus::Active;                           // We only want to deactivate once
 
-
-    bool found_draining_stage_or_sink = 
-        !assignment->is_source() &&                                 // We aren't a source
-        as.active_or_draining_upstream_arrow_count == 0 &&          // All upstreams arrows are inactive
-        assignment->get_pending() == 0 &&                           // All upstream queues are empty
-        as.thread_count > 0 &&                                      // There are other workers still assigned to this arrow
-        as.status == ArrowStatus::Active;                           // We only want to deactivate once
+    if (found_finished_source) {
+        // Drain the source first, so that no new workers check it out. A parallel source may still have other workers
+        // holding events which they read before it ran dry, in which case whoever is last out finalizes it. As with
+        // stages below, we only look at the thread count once Draining is visible.
+        as.status = ArrowStatus::Draining;
+        LOG_DEBUG(logger) << "Draining arrow '" << assignment->get_name() << "' (" << m_topology_state.active_or_draining_arrow_count << " remaining)" << LOG_END;
+    }
+    bool found_inactive_source =
+        assignment->is_source() &&
+        as.status == ArrowStatus::Draining &&
+        as.thread_count <= 0;                                       // There are NO other workers still assigned to this arrow
 
 
-    bool found_inactive_stage_or_sink = 
+    bool found_drained_stage_or_sink = 
         !assignment->is_source() &&                                 // We aren't a source
         as.active_or_draining_upstream_arrow_count == 0 &&          // All upstreams arrows are inactive
         assignment->get_pending() == 0 &&                           // All upstream queues are empty
-        as.thread_count == 0 &&                                     // There are NO other workers still assigned to this arrow
         (as.status == ArrowStatus::Draining ||                      // We only want to deactivate once
             as.status == ArrowStatus::Active);
 
+    if (found_drained_stage_or_sink) {
+        // Drain arrow first, so that no new workers check it out. Only once that is visible do we
+        // look at the thread count; in lock-free mode a worker may have checked it out concurrently,
+        // in which case it will see Draining, hand it back, and finalize it itself.
+        if (as.status == ArrowStatus::Active) {
+            as.status = ArrowStatus::Draining;
+            LOG_DEBUG(logger) << "Draining arrow '" << assignment->get_name() << "' (" << m_topology_state.active_or_draining_arrow_count << " remaining)" << LOG_END;
+        }
+    }
+    bool found_inactive_stage_or_sink = 
+        found_drained_stage_or_sink &&
+        as.thread_count == 0;                                       // There are NO other workers still assigned to this arrow
+
 
     if (found_inactive_source || found_inactive_stage_or_sink) {
 
@@ -117,11 +165,6 @@ void JScheduler::checkin_unprotected(JArrow* assignment, JArrowMetrics::Status l
             m_topology_state.arrow_states[downstream].active_or_draining_upstream_arrow_count--;
         }
     }
-    else if (found_draining_stage_or_sink) {
-        // Drain arrow
-        as.status = ArrowStatus::Draining;
-        LOG_DEBUG(logger) << "Draining arrow '" << assignment->get_name() << "' (" << m_topology_state.active_or_draining_arrow_count << " remaining)" << LOG_END;
-    }
 
     // Test if this was the last arrow running
     if (m_topology_state.active_or_draining_arrow_count == 0) {
@@ -131,6 +174,123 @@ void JScheduler::checkin_unprotected(JArrow* assignment, JArrowMetrics::Status l
 }
 
 
+void JScheduler::checkin_lock_free(size_t index, JArrowMetrics::Status last_result) {
+
+    ArrowState& as = m_topology_state.arrow_states[index];
+    as.thread_count.fetch_sub(1);
+
+    // Almost every check-in leaves the arrow Active. Only take the lock when the arrow might need to
+    // change status: a source which has finished, a stage whose upstreams have all gone away, or a
+    // topology with nothing left running.
+    bool may_need_transition =
+        (as.arrow->is_source() && (last_result == JArrowMetrics::Status::Finished || as.status.load() == ArrowStatus::Draining)) ||
+        (!as.arrow->is_source() && as.active_or_draining_upstream_arrow_count.load() == 0) ||
+        m_topology_state.active_or_draining_arrow_count.load() == 0;
+
+    if (may_need_transition) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        update_arrow_status_unprotected(index, last_result);
+    }
+}
+
+
+bool JScheduler::try_checkout_lock_free(size_t index) {
+
+    ArrowState& candidate = m_topology_state.arrow_states[index];
+    if (candidate.status.load() != ArrowStatus::Active) return false;   // This excludes Draining arrows
+
+    if (candidate.arrow->is_parallel()) {
+        candidate.thread_count.fetch_add(1);
+    }
+    else {
+        // This excludes non-parallel arrows that are already assigned to a worker
+        int64_t expected = 0;
+        if (!candidate.thread_count.compare_exchange_strong(expected, 1)) return false;
+    }
+
+    // The arrow may have been drained or paused between our status check and our increment.
+    // If so, hand it straight back so that whoever is last out can finalize it.
+    if (candidate.status.load() != ArrowStatus::Active) {
+        checkin_lock_free(index, JArrowMetrics::Status::NotRunYet);
+        return false;
+    }
+    return true;
+}
+
+
+JArrow* JScheduler::checkout_lock_free() {
+
+    size_t arrow_count = m_topology_state.arrow_states.size();
+    if (arrow_count == 0) return nullptr;
+
+    if (m_policy->has_priorities()) {
+        // Try the policy's favorite first. If another worker beats us to it, fall back to round-robin.
+        size_t best_idx = find_highest_priority_arrow();
+        if (best_idx == arrow_count) return nullptr;
+        if (try_checkout_lock_free(best_idx)) {
+            m_topology_state.next_arrow_index.store((best_idx + 1) % arrow_count, std::memory_order_relaxed);
+            return m_topology_state.arrow_states[best_idx].arrow;
+        }
+    }
+
+    // Same round-robin policy as checkout_unprotected(). next_arrow_index is only a hint here, so
+    // concurrent workers racing on it is harmless.
+    size_t start_idx = m_topology_state.next_arrow_index.load(std::memory_order_relaxed) % arrow_count;
+    size_t current_idx = start_idx;
+    do {
+        size_t candidate_idx = current_idx;
+        current_idx += 1;
+        current_idx %= arrow_count;
+
+        if (try_checkout_lock_free(candidate_idx)) {
+            m_topology_state.next_arrow_index.store(current_idx, std::memory_order_relaxed); // Next time, continue right where we left off
+            return m_topology_state.arrow_states[candidate_idx].arrow;
+        }
+    } while (current_idx != start_idx);
+    return nullptr;  // We've looped through everything with no luck
+}
+
+
+size_t JScheduler::find_highest_priority_arrow() {
+
+    // Scan every eligible arrow, starting where we last left off so that ties are broken round-robin.
+    // Returns arrow_states.size() if nothing is eligible.
+    size_t arrow_count = m_topology_state.arrow_states.size();
+    size_t start_idx = m_topology_state.next_arrow_index.load(std::memory_order_relaxed) % arrow_count;
+    size_t best_idx = arrow_count;
+    double best_priority = 0;
+
+    for (size_t offset=0; offset<arrow_count; ++offset) {
+        size_t idx = (start_idx + offset) % arrow_count;
+        ArrowState& candidate = m_topology_state.arrow_states[idx];
+
+        if (candidate.status == ArrowStatus::Active &&                                // This excludes Draining arrows
+            (candidate.arrow->is_parallel() || candidate.thread_count == 0)) {      // This excludes non-parallel arrows that are already assigned to a worker
+
+            double priority = m_policy->get_priority(candidate.arrow, m_downstream_arrows[idx]);
+            if (best_idx == arrow_count || priority > best_priority) {
+                best_idx = idx;
+                best_priority = priority;
+            }
+        }
+    }
+    return best_idx;
+}
+
+
+JArrow* JScheduler::checkout_prioritized_unprotected() {
+
+    size_t arrow_count = m_topology_state.arrow_states.size();
+    size_t best_idx = find_highest_priority_arrow();
+    if (best_idx == arrow_count) return nullptr;
+
+    ArrowState& chosen = m_topology_state.arrow_states[best_idx];
+    m_topology_state.next_arrow_index = (best_idx + 1) % arrow_count;
+    chosen.thread_count += 1;
+    return chosen.arrow;
+}
+
+
 JArrow* JScheduler::checkout(int arrow_index) {
     // Note that this lets us check out Inactive arrows, whereas checkout_unprotected() does not. This because we are called by JApplicationInspector
     // whereas checkout_unprotected is called by JWorker. This is because JArrowProcessingController::request_pause shuts off the topology
@@ -155,6 +315,10 @@ JArrow* JScheduler::checkout(int arrow_index) {
 
 JArrow* JScheduler::checkout_unprotected() {
 
+    if (m_policy->has_priorities()) {
+        return checkout_prioritized_unprotected();
+    }
+
     // Choose a new arrow. Loop over all arrows, starting at where we last left off, and pick the first arrow that works
     size_t current_idx = m_topology_state.next_arrow_index;
     do {
@@ -243,6 +407,22 @@ void JScheduler::run_topology(int nthreads) {
     m_topology_state.current_topology_status = TopologyStatus::Running;
 }
 
+/// rescale_topology() lets the caller change the number of workers while the topology keeps running. If the topology
+/// is Running, it restarts the throughput stopwatch at the new thread count and returns true; the caller is then free
+/// to start or retire workers. Otherwise it returns false and the caller has to go through a pause instead.
+bool JScheduler::rescale_topology(size_t nthreads, size_t current_event_count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TopologyStatus current_status = m_topology_state.current_topology_status;
+    if (current_status != TopologyStatus::Running) {
+        LOG_DEBUG(logger) << "JScheduler: rescale_topology() : " << current_status << " is not Running" << LOG_END;
+        return false;
+    }
+    LOG_DEBUG(logger) << "JScheduler: rescale_topology() : Running with " << nthreads << " threads" << LOG_END;
+    m_topology->metrics.reset();
+    m_topology->metrics.start(current_event_count, nthreads);
+    return true;
+}
+
 void JScheduler::request_topology_pause() {
     std::lock_guard<std::mutex> lock(m_mutex);
     // This sets all Running arrows to Paused, which prevents Workers from picking up any additional assignments
@@ -449,6 +629,7 @@ void JScheduler::summarize_arrows(std::vector<ArrowSummary>& summaries) {
         summary.total_messages_completed = total_message_count;
         summary.last_messages_completed = last_message_count;
         summary.queue_visit_count = total_queue_visits;
+        summary.total_messages_stolen = as.arrow->get_metrics().get_total_steal_count();
 
         summary.avg_queue_latency_ms = (total_queue_visits == 0)
                                        ? std::numeric_limits<double>::infinity()
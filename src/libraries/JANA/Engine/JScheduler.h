@@ -3,18 +3,30 @@
 // Subject to the terms in the LICENSE file found in the top-level directory.
 
 #pragma once
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include <JANA/Topology/JArrow.h>
 #include <JANA/Topology/JTopologyBuilder.h>
 #include <JANA/Engine/JPerfSummary.h>
+#include <JANA/Engine/JSchedulerPolicy.h>
+#include <JANA/Utils/JCpuInfo.h>
 
 
 struct JArrowTopology;
 
 /// Scheduler assigns Arrows to Workers in a first-come-first-serve manner,
 /// not unlike OpenMP's `schedule dynamic`.
+///
+/// By default, every worker check-in takes a single scheduler-wide mutex. If the topology has
+/// m_enable_lockfree_scheduler set, workers instead check arrows in and out using only the per-arrow
+/// atomics below, and the mutex is taken only when an arrow or the topology might change status
+/// (a source finishing, a stage draining, a pause being achieved).
+///
+/// Which eligible arrow a worker receives is up to the JSchedulerPolicy, chosen via
+/// jana:scheduler_policy. The default is plain round-robin.
 class JScheduler {
 public:
     enum class TopologyStatus { 
@@ -33,26 +45,54 @@ public:
                              Finalized        // Arrow should not be scheduled, and has been finalized(), so it may not be re-activated
                             };
 
-    struct ArrowState {
+    /// Each ArrowState gets its own cache line so that workers hammering on one arrow's thread_count
+    /// don't slow down workers checking out its neighbors. Copying an ArrowState takes a snapshot.
+    struct alignas(JANA2_CACHE_LINE_BYTES) ArrowState {
         JArrow* arrow = nullptr;
-        ArrowStatus status = ArrowStatus::Uninitialized;
-        int64_t thread_count = 0;                  // Current number of threads assigned to this arrow
-        int64_t active_or_draining_upstream_arrow_count = 0;        // Current number of active or draining arrows immediately upstream
+        std::atomic<ArrowStatus> status {ArrowStatus::Uninitialized};
+        std::atomic<int64_t> thread_count {0};                  // Current number of threads assigned to this arrow
+        std::atomic<int64_t> active_or_draining_upstream_arrow_count {0};        // Current number of active or draining arrows immediately upstream
         std::vector<size_t> downstream_arrow_indices; 
+
+        ArrowState() = default;
+        ArrowState(const ArrowState& other) { *this = other; }
+        ArrowState& operator=(const ArrowState& other) {
+            arrow = other.arrow;
+            status = other.status.load();
+            thread_count = other.thread_count.load();
+            active_or_draining_upstream_arrow_count = other.active_or_draining_upstream_arrow_count.load();
+            downstream_arrow_indices = other.downstream_arrow_indices;
+            return *this;
+        }
     };
 
     struct TopologyState {
         std::vector<ArrowState> arrow_states;
         TopologyStatus current_topology_status = TopologyStatus::Uninitialized;
-        int64_t active_or_draining_arrow_count = 0;  // Detects when the topology has paused
-        size_t next_arrow_index;
+        std::atomic<int64_t> active_or_draining_arrow_count {0};  // Detects when the topology has paused
+        std::atomic<size_t> next_arrow_index {0};
+
+        TopologyState() = default;
+        TopologyState(const TopologyState& other) { *this = other; }
+        TopologyState& operator=(const TopologyState& other) {
+            arrow_states = other.arrow_states;
+            current_topology_status = other.current_topology_status;
+            active_or_draining_arrow_count = other.active_or_draining_arrow_count.load();
+            next_arrow_index = other.next_arrow_index.load();
+            return *this;
+        }
     };
 
 private:
-    // This mutex controls ALL scheduler state
+    // This mutex controls ALL scheduler state, unless m_enable_lock_free is set, in which case it
+    // only controls arrow and topology status transitions
     std::mutex m_mutex;
 
     std::shared_ptr<JTopologyBuilder> m_topology;
+    bool m_enable_lock_free = false;
+    std::unordered_map<JArrow*, size_t> m_arrow_indices;  // Immutable after construction
+    std::vector<std::vector<JArrow*>> m_downstream_arrows; // Immutable after construction
+    std::unique_ptr<JSchedulerPolicy> m_policy;
 
     // Protected state
     TopologyState m_topology_state;
@@ -87,6 +127,7 @@ public:
     void initialize_topology();
     void drain_topology();
     void run_topology(int nthreads);
+    bool rescale_topology(size_t nthreads, size_t current_event_count);
     void request_topology_pause();
     void achieve_topology_pause();
     void finish_topology();
@@ -94,6 +135,11 @@ public:
     TopologyStatus get_topology_status(); 
     TopologyState get_topology_state();
     void summarize_arrows(std::vector<ArrowSummary>& summaries);
+    bool is_lock_free_enabled() const { return m_enable_lock_free; }
+
+    /// Replaces the scheduling policy. Call this before the topology starts running.
+    void set_policy(std::unique_ptr<JSchedulerPolicy> policy);
+    JSchedulerPolicy* get_policy() { return m_policy.get(); }
 
 
 private:
@@ -102,7 +148,13 @@ private:
     void pause_arrow_unprotected(size_t index);
     void finish_arrow_unprotected(size_t index);
     void checkin_unprotected(JArrow* arrow, JArrowMetrics::Status last_result);
+    void update_arrow_status_unprotected(size_t index, JArrowMetrics::Status last_result);
     JArrow* checkout_unprotected();
+    JArrow* checkout_prioritized_unprotected();
+    void checkin_lock_free(size_t index, JArrowMetrics::Status last_result);
+    bool try_checkout_lock_free(size_t index);
+    JArrow* checkout_lock_free();
+    size_t find_highest_priority_arrow();
 
 };
 
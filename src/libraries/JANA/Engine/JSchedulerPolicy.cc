@@ -0,0 +1,52 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <JANA/Engine/JSchedulerPolicy.h>
+#include <JANA/Topology/JArrow.h>
+#include <JANA/JException.h>
+
+#include <algorithm>
+
+
+std::unique_ptr<JSchedulerPolicy> JSchedulerPolicy::create(const std::string& name) {
+    if (name == "round_robin") {
+        return std::make_unique<JRoundRobinPolicy>();
+    }
+    if (name == "drain_first") {
+        return std::make_unique<JDrainFirstPolicy>();
+    }
+    throw JException("Unknown scheduler policy '%s'. Expected 'round_robin' or 'drain_first'.", name.c_str());
+}
+
+
+double JDrainFirstPolicy::get_fill_fraction(JArrow* arrow) {
+    size_t pending = arrow->get_pending_hint();
+    if (pending == 0) {
+        return 0;
+    }
+    size_t threshold = arrow->get_threshold();
+    if (threshold == 0 || threshold == static_cast<size_t>(-1)) {
+        return 1; // Work is waiting, we just can't tell how much relative to the queue
+    }
+    return static_cast<double>(pending) / threshold;
+}
+
+
+double JDrainFirstPolicy::get_priority(JArrow* arrow, const std::vector<JArrow*>& downstreams) {
+
+    if (arrow->is_source()) {
+        double max_downstream_fill = 0;
+        for (JArrow* downstream : downstreams) {
+            max_downstream_fill = std::max(max_downstream_fill, get_fill_fraction(downstream));
+        }
+        // Maps [0, inf) onto (-1, 0], so that sources always rank between busy and idle stages
+        return -max_downstream_fill / (1 + max_downstream_fill);
+    }
+    double fill = get_fill_fraction(arrow);
+    if (fill == 0) {
+        // Idle stages stay eligible, because some (e.g. an unfolder holding a parent) can make progress without input
+        return -1;
+    }
+    return fill;
+}
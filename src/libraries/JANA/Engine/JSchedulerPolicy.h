@@ -0,0 +1,62 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+class JArrow;
+
+/// JSchedulerPolicy decides which arrow JScheduler hands to a worker next. JScheduler scans the
+/// arrows which are eligible for checkout, starting where the previous scan left off, and picks
+/// the one with the highest priority. Ties go to whichever arrow the scan reaches first, so a
+/// policy which gives every arrow the same priority reproduces plain round-robin.
+///
+/// get_priority() may be called concurrently from many workers when the lock-free scheduler is
+/// enabled, so implementations must be thread-safe.
+class JSchedulerPolicy {
+public:
+    virtual ~JSchedulerPolicy() = default;
+
+    virtual std::string get_name() const = 0;
+
+    /// Returns false if every arrow always has the same priority. This lets JScheduler skip
+    /// evaluating priorities (and touching every queue) on each checkout.
+    virtual bool has_priorities() const { return true; }
+
+    /// Larger means more urgent. `downstreams` are the arrows immediately downstream of `arrow`.
+    virtual double get_priority(JArrow* arrow, const std::vector<JArrow*>& downstreams) = 0;
+
+    /// Creates a policy from its parameter value ("round_robin" or "drain_first"). Throws a
+    /// JException for anything else.
+    static std::unique_ptr<JSchedulerPolicy> create(const std::string& name);
+};
+
+
+/// Visits arrows in a fixed cycle, regardless of how full their queues are. This is the default.
+class JRoundRobinPolicy : public JSchedulerPolicy {
+public:
+    std::string get_name() const override { return "round_robin"; }
+    bool has_priorities() const override { return false; }
+    double get_priority(JArrow*, const std::vector<JArrow*>&) override { return 0; }
+};
+
+
+/// Prefers whichever arrow has the most work waiting relative to its queue's threshold, so that
+/// events already in flight are finished before new ones are started. Sources rank below any arrow
+/// with work waiting, and further below the fuller their downstream queues get, but always above
+/// arrows with nothing waiting. This keeps both the number of events in flight and the per-event
+/// latency low. Queue sizes are read through get_pending_hint(), so no queue gets locked.
+class JDrainFirstPolicy : public JSchedulerPolicy {
+public:
+    std::string get_name() const override { return "drain_first"; }
+    double get_priority(JArrow* arrow, const std::vector<JArrow*>& downstreams) override;
+
+    /// Pending items on the arrow's input queues as a fraction of the queue threshold.
+    /// Arrows with nothing pending, including those that only read from a pool, report 0.
+    static double get_fill_fraction(JArrow* arrow);
+};
+
+
@@ -206,6 +206,12 @@ void JWorker::loop() {
                 uint32_t current_tries = 0;
                 auto backoff_duration = m_initial_backoff_time;
 
+                // If the arrow tells us which place it is starved on, we park there instead of sleeping,
+                // so that we wake up as soon as new input arrives rather than when the backoff expires
+                JWaitObject* wait_object = m_enable_parking ? m_assignment->get_wait_object() : nullptr;
+                bool is_wait_prepared = false;
+                uint64_t wait_epoch = 0;
+
                 while (current_tries <= m_backoff_tries &&
                        (last_result == JArrowMetrics::Status::KeepGoing || last_result == JArrowMetrics::Status::ComeBackLater || last_result == JArrowMetrics::Status::NotRunYet) &&
                        (m_run_state == RunState::Running) &&
@@ -219,12 +225,27 @@ void JWorker::loop() {
                     useful_duration += (jclock_t::now() - before_execute_time);
 
 
+                    if (is_wait_prepared && last_result != JArrowMetrics::Status::ComeBackLater) {
+                        wait_object->cancel_wait();
+                        is_wait_prepared = false;
+                    }
+
                     if (last_result == JArrowMetrics::Status::KeepGoing) {
                         LOG_DEBUG(logger) << "Worker " << m_worker_id << " succeeded at "
                                           << m_assignment->get_name() << LOG_END;
                         current_tries = 0;
                         backoff_duration = m_initial_backoff_time;
                     }
+                    else if (m_task_queue != nullptr && m_task_queue->size() != 0) {
+                        // Our own arrow is starved, but somebody else's event has work we can help with
+                        if (is_wait_prepared) {
+                            wait_object->cancel_wait();
+                            is_wait_prepared = false;
+                        }
+                        auto before_task_time = jclock_t::now();
+                        m_task_queue->try_run_one();
+                        useful_duration += (jclock_t::now() - before_task_time);
+                    }
                     else {
                         current_tries++;
                         if (m_backoff_tries > 0) {
@@ -238,11 +259,28 @@ void JWorker::loop() {
                                               << m_assignment->get_name() << ", tries = " << current_tries
                                               << LOG_END;
 
-                            std::this_thread::sleep_for(backoff_duration);
-                            retry_duration += backoff_duration;
+                            if (wait_object != nullptr && !is_wait_prepared) {
+                                // Register first and then retry right away, so that a push which lands after
+                                // the retry is guaranteed to wake us up
+                                wait_epoch = wait_object->prepare_wait();
+                                is_wait_prepared = true;
+                            }
+                            else if (wait_object != nullptr) {
+                                auto before_park_time = jclock_t::now();
+                                wait_object->commit_wait(wait_epoch, backoff_duration, m_park_spin_count);
+                                is_wait_prepared = false;
+                                retry_duration += (jclock_t::now() - before_park_time);
+                            }
+                            else {
+                                std::this_thread::sleep_for(backoff_duration);
+                                retry_duration += backoff_duration;
+                            }
                         }
                     }
                 }
+                if (is_wait_prepared) {
+                    wait_object->cancel_wait();
+                }
             }
             m_worker_metrics.update(start_time, 1, useful_duration, retry_duration, scheduler_duration, idle_duration);
             if (m_assignment != nullptr) {
@@ -8,6 +8,7 @@
 #include <JANA/Engine/JScheduler.h>
 #include <JANA/Engine/JWorkerMetrics.h>
 #include <JANA/Engine/JPerfSummary.h>
+#include <JANA/Utils/JTaskQueue.h>
 #include <atomic>
 
 
@@ -50,6 +51,9 @@ private:
     duration_t m_initial_backoff_time = std::chrono::microseconds(1);
     duration_t m_checkin_time = std::chrono::milliseconds(500);
     unsigned m_backoff_tries = 4;
+    bool m_enable_parking = false;
+    size_t m_park_spin_count = 100;
+    JTaskQueue* m_task_queue = nullptr;
 
 public:
     JWorker(JArrowProcessingController* japc, JScheduler* scheduler, unsigned worker_id, unsigned cpu_id, unsigned domain_id, bool pin_to_cpu);
@@ -93,5 +97,20 @@ public:
 
     inline void set_checkin_time(duration_t checkin_time) { m_checkin_time = checkin_time; }
 
+    /// When parking is enabled, a worker whose arrow comes back with ComeBackLater registers on the arrow's
+    /// input place, retries once, and then waits there (for at most the backoff time) instead of sleeping,
+    /// to be woken by the next push. It polls the place park_spin_count times before it blocks.
+    /// Off by default, because registered waiters make every push to that place bump a shared epoch.
+    inline void set_parking(bool enable_parking, size_t park_spin_count) {
+        m_enable_parking = enable_parking;
+        m_park_spin_count = park_spin_count;
+    }
+
+    inline bool is_parking_enabled() const { return m_enable_parking; }
+
+    /// If set, a worker whose arrow comes back with ComeBackLater runs a task from task_queue (e.g. a factory
+    /// from some other worker's event) before it considers backing off.
+    inline void set_task_queue(JTaskQueue* task_queue) { m_task_queue = task_queue; }
+
 };
 
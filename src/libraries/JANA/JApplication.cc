@@ -416,6 +416,7 @@ void JApplication::PrintStatus() {
 
 void JApplication::PrintFinalReport() {
     m_processing_controller->print_final_report();
+    m_component_manager->print_factory_usage_report();
 }
 
 /// Performs a new measurement if the time elapsed since the previous measurement exceeds some threshold
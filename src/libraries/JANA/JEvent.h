@@ -8,11 +8,13 @@
 #include <JANA/JException.h>
 #include <JANA/JFactoryT.h>
 #include <JANA/JFactorySet.h>
+#include <JANA/JSoA.h>
 #include <JANA/JLogger.h>
 
 #include <JANA/JVersion.h>
 
 #include <JANA/Utils/JEventLevel.h>
+#include <JANA/Utils/JFactoryHandle.h>
 #include <JANA/Utils/JTypeInfo.h>
 #include <JANA/Utils/JCpuInfo.h>
 #include <JANA/Utils/JCallGraphRecorder.h>
@@ -44,6 +46,7 @@ class JEvent : public std::enable_shared_from_this<JEvent>
         explicit JEvent(JApplication* aApplication=nullptr) : mInspector(&(*this)) {
             mApplication = aApplication;
             mFactorySet = new JFactorySet();
+            mFactorySet->SetArena(&mArena);
         }
         virtual ~JEvent() {
             if (mFactorySet != nullptr) mFactorySet->Release();
@@ -53,6 +56,7 @@ class JEvent : public std::enable_shared_from_this<JEvent>
         void SetFactorySet(JFactorySet* aFactorySet) {
             delete mFactorySet;
             mFactorySet = aFactorySet;
+            mFactorySet->SetArena(&mArena);
 #if JANA2_HAVE_PODIO
             // Maintain the index of PODIO factories
             for (JFactory* factory : mFactorySet->GetAllFactories()) {
@@ -70,9 +74,14 @@ class JEvent : public std::enable_shared_from_this<JEvent>
 
         JFactorySet* GetFactorySet() const { return mFactorySet; }
 
+        /// Memory which lives exactly as long as this pass of the event through the topology.
+        /// JEventPool resets it when the event is recycled. See JArena and JFactoryT::NewObject().
+        JArena& GetArena() const { return mArena; }
+
         JFactory* GetFactory(const std::string& object_name, const std::string& tag) const;
         std::vector<JFactory*> GetAllFactories() const;
         template<class T> JFactoryT<T>* GetFactory(const std::string& tag = "", bool throw_on_missing=false) const;
+        template<class T> JFactoryT<T>* GetFactory(const JFactoryHandle<T>& handle, bool throw_on_missing=false) const;
         template<class T> std::vector<JFactoryT<T>*> GetFactoryAll(bool throw_on_missing = false) const;
 
         template<class T> JMetadata<T> GetMetadata(const std::string& tag = "") const;
@@ -87,6 +96,11 @@ class JEvent : public std::enable_shared_from_this<JEvent>
         template<class T> const T* GetSingle(const std::string& tag = "") const;
         template<class T> const T* GetSingleStrict(const std::string& tag = "") const;
         template<class T> std::vector<const T*> Get(const std::string& tag = "", bool strict=true) const;
+        template<class T> std::vector<const T*> Get(const JFactoryHandle<T>& handle, bool strict=true) const;
+        template<class T> JSpan<T> GetSpan(const std::string& tag = "", bool strict=true) const;
+        template<class T> JSpan<T> GetSpan(const JFactoryHandle<T>& handle, bool strict=true) const;
+        template<class T> JConcatSpan<T> GetAllSpan() const;
+        template<class Schema> const JSoA<Schema>& GetSoA(const std::string& tag = "") const;
         template<class T> typename JFactoryT<T>::PairType GetIterators(const std::string& aTag = "") const;
         template<class T> std::vector<const T*> GetAll() const;
         template<class T> std::map<std::pair<std::string,std::string>,std::vector<T*>> GetAllChildren() const;
@@ -197,6 +211,7 @@ class JEvent : public std::enable_shared_from_this<JEvent>
         JApplication* mApplication = nullptr;
         int32_t mRunNumber = 0;
         uint64_t mEventNumber = 0;
+        mutable JArena mArena;
         mutable JFactorySet* mFactorySet = nullptr;
         mutable JCallGraphRecorder mCallGraph;
         mutable JInspector mInspector;
@@ -210,6 +225,7 @@ class JEvent : public std::enable_shared_from_this<JEvent>
         std::atomic_int mReferenceCount {1};
         int64_t mEventIndex = -1;
 
+        template<class T> const std::string& ResolveDefaultTag(const std::string& tag) const;
 
 
 #if JANA2_HAVE_PODIO
@@ -224,12 +240,13 @@ class JEvent : public std::enable_shared_from_this<JEvent>
 template <class T>
 inline JFactoryT<T>* JEvent::Insert(T* item, const std::string& tag) const {
 
-    std::string resolved_tag = tag;
+    const std::string* resolved_tag = &tag;
     if (mUseDefaultTags && tag.empty()) {
-        auto defaultTag = mDefaultTags.find(JTypeInfo::demangle<T>());
-        if (defaultTag != mDefaultTags.end()) resolved_tag = defaultTag->second;
+        static const std::string type_name = JTypeInfo::demangle<T>();
+        auto defaultTag = mDefaultTags.find(type_name);
+        if (defaultTag != mDefaultTags.end()) resolved_tag = &defaultTag->second;
     }
-    auto factory = mFactorySet->GetFactory<T>(resolved_tag);
+    auto factory = mFactorySet->GetFactory<T>(*resolved_tag);
     if (factory == nullptr) {
         factory = new JFactoryT<T>;
         factory->SetTag(tag);
@@ -244,12 +261,13 @@ inline JFactoryT<T>* JEvent::Insert(T* item, const std::string& tag) const {
 template <class T>
 inline JFactoryT<T>* JEvent::Insert(const std::vector<T*>& items, const std::string& tag) const {
 
-    std::string resolved_tag = tag;
+    const std::string* resolved_tag = &tag;
     if (mUseDefaultTags && tag.empty()) {
-        auto defaultTag = mDefaultTags.find(JTypeInfo::demangle<T>());
-        if (defaultTag != mDefaultTags.end()) resolved_tag = defaultTag->second;
+        static const std::string type_name = JTypeInfo::demangle<T>();
+        auto defaultTag = mDefaultTags.find(type_name);
+        if (defaultTag != mDefaultTags.end()) resolved_tag = &defaultTag->second;
     }
-    auto factory = mFactorySet->GetFactory<T>(resolved_tag);
+    auto factory = mFactorySet->GetFactory<T>(*resolved_tag);
     if (factory == nullptr) {
         factory = new JFactoryT<T>;
         factory->SetTag(tag);
@@ -277,17 +295,24 @@ inline std::vector<JFactory*> JEvent::GetAllFactories() const {
     return mFactorySet->GetAllFactories();
 }
 
+/// ResolveDefaultTag() swaps an empty tag for the user-configured default tag for T, if there is one
+template<class T>
+inline const std::string& JEvent::ResolveDefaultTag(const std::string& tag) const
+{
+    if (mUseDefaultTags && tag.empty()) {
+        static const std::string type_name = JTypeInfo::demangle<T>();
+        auto defaultTag = mDefaultTags.find(type_name);
+        if (defaultTag != mDefaultTags.end()) return defaultTag->second;
+    }
+    return tag;
+}
+
 /// GetFactory() should be used with extreme care because it subverts the JEvent abstraction.
 /// Most historical uses of GetFactory are far better served by GetMetadata.
 template<class T>
 inline JFactoryT<T>* JEvent::GetFactory(const std::string& tag, bool throw_on_missing) const
 {
-    std::string resolved_tag = tag;
-    if (mUseDefaultTags && tag.empty()) {
-        auto defaultTag = mDefaultTags.find(JTypeInfo::demangle<T>());
-        if (defaultTag != mDefaultTags.end()) resolved_tag = defaultTag->second;
-    }
-    auto factory = mFactorySet->GetFactory<T>(resolved_tag);
+    auto factory = mFactorySet->GetFactory<T>(ResolveDefaultTag<T>(tag));
     if (factory == nullptr) {
         if (throw_on_missing) {
             JException ex("Could not find JFactoryT<" + JTypeInfo::demangle<T>() + "> with tag=" + tag);
@@ -298,6 +323,23 @@ inline JFactoryT<T>* JEvent::GetFactory(const std::string& tag, bool throw_on_mi
     return factory;
 }
 
+/// Like GetFactory(tag), but once the handle has been resolved this skips all of the string lookups
+template<class T>
+inline JFactoryT<T>* JEvent::GetFactory(const JFactoryHandle<T>& handle, bool throw_on_missing) const
+{
+    const JFactoryIndex* index = mFactorySet->GetFactoryIndex();
+    if (index != nullptr) {
+        size_t slot;
+        if (!handle.GetCachedSlot(index, slot)) {
+            slot = index->GetSlot<T>(ResolveDefaultTag<T>(handle.GetTag()));
+            handle.CacheSlot(index, slot);
+        }
+        auto factory = mFactorySet->GetFactoryAtSlot<T>(slot);
+        if (factory != nullptr) return factory;
+    }
+    return GetFactory<T>(handle.GetTag(), throw_on_missing);
+}
+
 
 /// GetMetadata() provides access to any metadata generated by the underlying JFactory during Process()
 template<class T>
@@ -392,6 +434,13 @@ template<class T> const T* JEvent::GetSingleStrict(const std::string& tag) const
 }
 
 
+/// GetSoA returns the columnar table produced by a JFactorySoA<Schema>. Like GetSingleStrict, this throws if the
+/// factory is missing or didn't produce exactly one table.
+template<class Schema> const JSoA<Schema>& JEvent::GetSoA(const std::string& tag) const {
+    return *GetSingleStrict<JSoA<Schema>>(tag);
+}
+
+
 template<class T>
 std::vector<const T*> JEvent::Get(const std::string& tag, bool strict) const {
 
@@ -406,6 +455,30 @@ std::vector<const T*> JEvent::Get(const std::string& tag, bool strict) const {
     return vec; // Assumes RVO
 }
 
+template<class T>
+std::vector<const T*> JEvent::Get(const JFactoryHandle<T>& handle, bool strict) const {
+    return GetSpan<T>(handle, strict).to_vector();
+}
+
+/// GetSpan is like Get, except that it returns a view straight into the factory instead of copying the pointers into
+/// a new vector. The view is only valid until the factory's data changes, i.e. for the rest of this event unless
+/// somebody Insert()s more objects into the same collection.
+template<class T>
+JSpan<T> JEvent::GetSpan(const std::string& tag, bool strict) const {
+    auto factory = GetFactory<T>(tag, strict);
+    if (factory == nullptr) return {}; // Will have thrown already if strict==true
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    return factory->CreateAndGetSpan(this->shared_from_this());
+}
+
+template<class T>
+JSpan<T> JEvent::GetSpan(const JFactoryHandle<T>& handle, bool strict) const {
+    auto factory = GetFactory<T>(handle, strict);
+    if (factory == nullptr) return {}; // Will have thrown already if strict==true
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    return factory->CreateAndGetSpan(this->shared_from_this());
+}
+
 /// GetFactoryAll returns all JFactoryT's for type T (each corresponds to a different tag).
 /// This is useful when there are many different tags, or the tags are unknown, and the user
 /// wishes to examine them all together.
@@ -437,17 +510,28 @@ void JEvent::GetAll(std::vector<const T*>& destination) const {
 /// GetAll returns all JObjects of (child) type T, regardless of tag.
 template<class T>
 std::vector<const T*> JEvent::GetAll() const {
-    std::vector<const T*> vec;
-    auto factories = GetFactoryAll<T>(true);
+    return GetAllSpan<T>().to_vector();
+}
 
-    for (auto factory : factories) {
-        auto iters = factory->CreateAndGetData(this->shared_from_this());
-        std::vector<const T*> vec;
-        for (auto it = iters.first; it != iters.second; ++it) {
-            vec.push_back(*it);
-        }
+/// GetAllSpan is like GetAll, except that it returns a view which walks each factory's data in turn, instead of
+/// copying everything into a new vector. The same lifetime caveats as GetSpan apply.
+template<class T>
+JConcatSpan<T> JEvent::GetAllSpan() const {
+    auto range = mFactorySet->GetFactoryRange<T>();
+    bool found = false;
+    // Create() may add factories of other types to the map, possibly right after T's, so stop as soon as the type changes
+    for (auto it = range.first; it != range.second && it->first.first == std::type_index(typeid(T)); ++it) {
+        auto factory = static_cast<JFactoryT<T>*>(it->second);
+        if (factory->GetLevel() != mFactorySet->GetLevel()) continue;
+        factory->Create(this->shared_from_this());
+        found = true;
     }
-    return vec; // Assumes RVO
+    if (!found) {
+        JException ex("Could not find any JFactoryT<" + JTypeInfo::demangle<T>() + "> (from any tag)");
+        ex.show_stacktrace = false;
+        throw ex;
+    }
+    return JConcatSpan<T>(range.first, range.second, mFactorySet->GetLevel());
 }
 
 
@@ -8,6 +8,7 @@
 #include <JANA/Omni/JHasInputs.h>
 #include <JANA/Omni/JHasRunCallbacks.h>
 #include <JANA/JEvent.h>
+#include <JANA/Utils/JFactoryDag.h>
 
 class JApplication;
 
@@ -47,6 +48,21 @@ public:
 
     virtual void DoMap(const std::shared_ptr<const JEvent>& e) {
 
+        // If this event's factories may run in parallel, run everything our declared inputs depend on first.
+        // PrefetchCollection() then finds those already created, and lazily pulls whatever is left.
+        if (auto* dag = e->GetFactorySet()->GetFactoryDag()) {
+            dag->Prefetch(e, this, [&]() {
+                std::vector<JFactoryDag::Target> targets;
+                for (auto* input : m_inputs) {
+                    for (size_t i=0; i<input->names.size(); ++i) {
+                        JEventLevel level = (i < input->levels.size()) ? input->levels[i] : JEventLevel::None;
+                        targets.push_back({input->type_name, input->names[i], level});
+                    }
+                }
+                return targets;
+            });
+        }
+
         for (auto* input : m_inputs) {
             input->PrefetchCollection(*e);
         }
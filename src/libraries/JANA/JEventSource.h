@@ -10,6 +10,11 @@
 #include <JANA/JException.h>
 #include <JANA/JFactoryGenerator.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
 
 class JFactoryGenerator;
 class JApplication;
@@ -63,10 +68,30 @@ public:
     // Result::Success, at which point JANA pushes the JEvent onto the downstream queue. If there is no data waiting yet,
     // the user returns Result::FailureTryAgain, at which point JANA recycles the JEvent to the pool. If there is no more
     // data, the user returns Result::FailureFinished, at which point JANA recycles the JEvent to the pool and calls Close().
+    // Emit() runs serially, so any decoding which doesn't need the source's state belongs in Preprocess() instead.
 
     virtual Result Emit(JEvent&) { return Result::Success; };
 
 
+    /// `EmitBatch` is an optional alternative to Emit() for sources whose data naturally comes in blocks of events,
+    /// e.g. EVIO blocks. JANA only calls it if EnableEmitBatch() was called. It receives up to `count` fresh events,
+    /// which the user fills in order, setting `emitted_count` to how many they filled. The returned Result describes
+    /// what happened after the last one: Success means there may be more right away (stopping short, e.g. at the
+    /// end of a block, is fine), FailureTryAgain means there is no more data yet, and FailureFinished means there is
+    /// no more data at all. Events which weren't filled go back to the pool. This gets called with the source's lock
+    /// held, just like Emit(), so a whole block can be decoded in one pass without any locking in between.
+
+    virtual Result EmitBatch(JEvent** events, size_t count, size_t& emitted_count) {
+        emitted_count = 0;
+        while (emitted_count < count) {
+            auto result = Emit(*events[emitted_count]);
+            if (result != Result::Success) return result;
+            emitted_count += 1;
+        }
+        return Result::Success;
+    }
+
+
     /// `Close` is called by JANA when it is finished accepting events from this event source. Here is where you should
     /// cleanly close files, sockets, etc. Although GetEvent() knows when (for instance) there are no more events in a
     /// file, the logic for closing needs to live here because there are other ways a computation may end besides
@@ -95,6 +120,14 @@ public:
 
     virtual void GetEvent(std::shared_ptr<JEvent>) {};
 
+
+    /// `Preprocess` is the parallel half of reading an event. Emit() (and GetEvent()) run with the source's lock held,
+    /// one event at a time, so any unpacking done there caps the throughput of the whole application no matter how many
+    /// threads are available. Ideally Emit() only grabs the event's raw bytes (e.g. Inserts a buffer, or a JMappedView)
+    /// and sets the event and run numbers, while decoding those bytes into hits happens here. Preprocess() is called
+    /// concurrently on many events, after they leave the source and before any JEventProcessor or unfolder sees them,
+    /// and may Insert() whatever it decodes. JANA only schedules this stage if EnablePreprocess() was called.
+
     virtual void Preprocess(const JEvent&) {};
 
 
@@ -190,11 +223,132 @@ public:
             m_status = Status::Closed;
         }
     }
+
+    /// DoTeardown() is called by JComponentManager right before it deletes the source, while the whole object is
+    /// still alive. Sources which own helper threads that call back into the derived class stop them here, because
+    /// by the time the base class destructor runs, the derived part is already gone.
+    virtual void DoTeardown() {}
     
     Result DoNext(std::shared_ptr<JEvent> event) {
-
         std::lock_guard<std::mutex> lock(m_mutex); // In general, DoNext must be synchronized.
-        
+        auto start = std::chrono::steady_clock::now();
+        auto result = DoNextUnlocked(event);
+        m_emit_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    /// DoNextBatch is like DoNext, but fills up to `count` events under a single lock. If EnableEmitBatch() was called,
+    /// it hands them all to EmitBatch() at once; otherwise it calls Emit() (or GetEvent()) once per event. It returns
+    /// how many of the events it used up, and sets results[i] to whatever DoNext would have returned for events[i].
+    /// Only the last of these can be FailureFinished, or FailureTryAgain due to the source not being ready yet.
+    /// Events past the ones used up were not touched. There is always at least one.
+    size_t DoNextBatch(std::shared_ptr<JEvent>* const* events, size_t count, Result* results) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto start = std::chrono::steady_clock::now();
+        auto used = DoNextBatchUnlocked(events, count, results);
+        m_emit_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        return used;
+    }
+
+    /// Calls the user-provided Preprocess() if EnablePreprocess() was called, keeping track of the time spent there.
+    /// Called by JEventMapArrow, in parallel, without taking the source's lock.
+    void DoPreprocess(const JEvent& event) {
+        if (!m_enable_preprocess) return;
+        auto start = std::chrono::steady_clock::now();
+        CallWithJExceptionWrapper("JEventSource::Preprocess", [&](){
+            Preprocess(event);
+        });
+        m_preprocess_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        m_preprocess_count += 1;
+    }
+
+private:
+    size_t DoNextBatchUnlocked(std::shared_ptr<JEvent>* const* events, size_t count, Result* results) {
+
+        if (!m_enable_emit_batch || m_callback_style == CallbackStyle::LegacyMode) {
+            size_t i = 0;
+            do {
+                results[i] = DoNextUnlocked(*events[i]);
+            } while (results[i++] == Result::Success && i < count);
+            return i;
+        }
+
+        if (m_status == Status::Uninitialized) {
+            throw JException("JEventSource has not been initialized!");
+        }
+        if (m_status == Status::Initialized) {
+            DoOpen(false);
+        }
+        if (m_status != Status::Opened) {
+            results[0] = Result::FailureFinished;
+            return 1;
+        }
+
+        auto first_evt_nr = m_nskip;
+        auto last_evt_nr = m_nevents + m_nskip;
+        size_t limit = count;
+        if (m_nevents != 0) {
+            if (m_event_count == last_evt_nr) {
+                // We exit early (and recycle) because we hit our jana:nevents limit
+                DoClose(false);
+                results[0] = Result::FailureFinished;
+                return 1;
+            }
+            limit = std::min<size_t>(limit, last_evt_nr - m_event_count);
+        }
+
+        // We configure the events exactly as DoNext would
+        m_batch_events.clear();
+        m_batch_origins.clear();
+        for (size_t i=0; i<limit; ++i) {
+            JEvent* event = events[i]->get();
+            event->SetEventNumber(m_event_count + i); // Default event number to event count
+            event->SetJEventSource(this);
+            event->SetSequential(false);
+            event->GetJCallGraphRecorder()->Reset();
+            m_batch_origins.push_back(event->GetJCallGraphRecorder()->SetInsertDataOrigin(JCallGraphRecorder::ORIGIN_FROM_SOURCE));
+            m_batch_events.push_back(event);
+        }
+
+        size_t emitted_count = 0;
+        JEventSource::Result result;
+        CallWithJExceptionWrapper("JEventSource::EmitBatch", [&](){
+            result = EmitBatch(m_batch_events.data(), limit, emitted_count);
+        });
+        for (size_t i=0; i<limit; ++i) {
+            m_batch_events[i]->GetJCallGraphRecorder()->SetInsertDataOrigin(m_batch_origins[i]);
+        }
+        if (emitted_count > limit) {
+            throw JException("JEventSource::EmitBatch claims to have emitted %zu events, but was only given %zu", emitted_count, limit);
+        }
+
+        for (size_t i=0; i<emitted_count; ++i) {
+            m_event_count += 1;
+            for (auto* output : m_outputs) {
+                output->InsertCollection(*m_batch_events[i]);
+            }
+            // Events within nskip get thrown away, just like in DoNext
+            results[i] = (m_event_count <= first_evt_nr) ? Result::FailureTryAgain : Result::Success;
+        }
+
+        if (result == Result::FailureFinished) {
+            DoClose(false);
+        }
+        if (emitted_count < limit && result != Result::Success) {
+            // The event after the last one emitted is the one which reports what happened
+            results[emitted_count] = result;
+            return emitted_count + 1;
+        }
+        if (emitted_count == 0) {
+            // EmitBatch stopped short without emitting anything or saying why, so we don't spin on it
+            results[0] = Result::FailureTryAgain;
+            return 1;
+        }
+        return emitted_count;
+    }
+
+    Result DoNextUnlocked(std::shared_ptr<JEvent> event) {
+
         if (m_status == Status::Uninitialized) {
             throw JException("JEventSource has not been initialized!");
         }
@@ -265,6 +419,7 @@ public:
         }
     }
 
+public:
     Result DoNextCompatibility(std::shared_ptr<JEvent> event) {
 
         auto first_evt_nr = m_nskip;
@@ -396,6 +551,30 @@ public:
     /// which will hurt performance. Conceptually, FinishEvent isn't great, and so should be avoided when possible.
     void EnableFinishEvent() { m_enable_free_event = true; }
 
+    /// EnableEmitBatch() tells JANA to call EmitBatch() instead of Emit(), ideally from the constructor.
+    /// Only applies to CallbackStyle::ExpertMode.
+    void EnableEmitBatch(bool enable=true) { m_enable_emit_batch = enable; }
+    bool IsEmitBatchEnabled() const { return m_enable_emit_batch; }
+
+    /// EnablePreprocess() tells JANA that this source does part of its work in Preprocess(). JANA then inserts a
+    /// parallel stage between the source and everything downstream of it, which calls Preprocess() on each event this
+    /// source emits. This decides the shape of the topology, so it has to be called before JApplication::Initialize(),
+    /// e.g. from the constructor, rather than from Init().
+    /// This is opt-in rather than automatic because C++ gives JANA no portable way to tell whether a subclass
+    /// overrides Preprocess(), and inserting the stage for every source would add a queue hop to each event for
+    /// sources that don't need it. Calling Preprocess() from the source arrow instead would put it back in the
+    /// serial part.
+    void EnablePreprocess(bool enable=true) { m_enable_preprocess = enable; }
+    bool IsPreprocessEnabled() const { return m_enable_preprocess; }
+
+    /// Total time spent holding the source's lock while emitting events, including opening and closing. Only one
+    /// thread can be doing this at a time, so it is the serial part of reading this source.
+    std::chrono::nanoseconds GetEmitTime() const { return std::chrono::nanoseconds(m_emit_time_ns.load()); }
+
+    /// Total time spent in Preprocess(), summed over all threads. This is the parallel part of reading this source.
+    std::chrono::nanoseconds GetPreprocessTime() const { return std::chrono::nanoseconds(m_preprocess_time_ns.load()); }
+    uint64_t GetPreprocessCount() const { return m_preprocess_count; }
+
     // Meant to be called by JANA
     void SetNEvents(uint64_t nevents) { m_nevents = nevents; };
 
@@ -409,6 +588,13 @@ private:
     uint64_t m_nskip = 0;
     uint64_t m_nevents = 0;
     bool m_enable_free_event = false;
+    bool m_enable_emit_batch = false;
+    bool m_enable_preprocess = false;
+    std::atomic<uint64_t> m_emit_time_ns {0};
+    std::atomic<uint64_t> m_preprocess_time_ns {0};
+    std::atomic<uint64_t> m_preprocess_count {0};
+    std::vector<JEvent*> m_batch_events;       // Scratch space for DoNextBatch, only touched under m_mutex
+    std::vector<JCallGraphRecorder::JDataOrigin> m_batch_origins;
 
 };
 
@@ -0,0 +1,84 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JEventSourceMmap.h"
+#include <JANA/JApplication.h>
+#include <JANA/JEvent.h>
+
+#include <algorithm>
+
+
+void JEventSourceMmap::DoInit() {
+    JEventSource::DoInit();
+    // Registered after Init() so that whatever the implementor set there becomes the default
+    if (m_app != nullptr) {
+        auto prefix = GetPrefix();
+        if (prefix.empty()) prefix = "JEventSourceMmap";
+        m_app->SetDefaultParameter(prefix + ":mmap_willneed_bytes", m_willneed_bytes,
+                                   "How far [bytes] past the latest event the mapped file is prefetched. 0 disables")->SetIsAdvanced(true);
+    }
+}
+
+
+void JEventSourceMmap::DoOpen(bool with_lock) {
+    if (with_lock) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MapAndOpen();
+    }
+    else {
+        MapAndOpen();
+    }
+}
+
+
+void JEventSourceMmap::MapAndOpen() {
+    // Map first so that Open() can already look at the file, e.g. to parse a header
+    if (m_status == Status::Initialized && m_file == nullptr) {
+        m_file = JMappedFile::Open(GetResourceName());
+        m_file->Advise(0, m_file->GetSize(), JMappedFile::Advice::Sequential);
+        m_advised_until = 0;
+    }
+    JEventSource::DoOpen(false);
+}
+
+
+void JEventSourceMmap::DoClose(bool with_lock) {
+    JEventSource::DoClose(with_lock);
+    // Events still in flight keep the mapping alive through their JMappedViews
+    if (with_lock) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file = nullptr;
+    }
+    else {
+        m_file = nullptr;
+    }
+}
+
+
+const JMappedView* JEventSourceMmap::AttachView(JEvent& event, size_t offset, size_t size, const std::string& tag) {
+    if (m_file == nullptr) {
+        throw JException("JEventSourceMmap: AttachView() called while no file is mapped");
+    }
+    if (offset > m_file->GetSize() || size > m_file->GetSize() - offset) {
+        throw JException("JEventSourceMmap: View [%zu, %zu) lies outside '%s' (%zu bytes)",
+                         offset, offset + size, m_file->GetPath().c_str(), m_file->GetSize());
+    }
+
+    size_t end = offset + size;
+    if (m_willneed_bytes != 0 && end + m_willneed_bytes / 2 > m_advised_until) {
+        // Advise a whole window at a time, starting once the previous one is half used up
+        size_t window_begin = std::max(m_advised_until, offset);
+        m_file->Advise(window_begin, end + m_willneed_bytes - window_begin, JMappedFile::Advice::WillNeed);
+        m_advised_until = end + m_willneed_bytes;
+    }
+
+    auto view = new JMappedView;
+    view->file = m_file;
+    view->data = m_file->GetData() + offset;
+    view->size = size;
+    view->offset = offset;
+    event.Insert(view, tag);
+    return view;
+}
+
@@ -0,0 +1,68 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JEventSource.h>
+#include <JANA/JObject.h>
+#include <JANA/Utils/JMappedFile.h>
+
+/// JMappedView is a read-only window into a file mapped by JEventSourceMmap. It is inserted into the event like any
+/// other JObject, and holds a reference to the mapping, so the bytes stay valid for as long as the event holds on to
+/// the view, i.e. until the event gets recycled. Nothing is copied out of the file.
+struct JMappedView : public JObject {
+    JOBJECT_PUBLIC(JMappedView)
+
+    std::shared_ptr<const JMappedFile> file;
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t offset = 0;   // Position of `data` within the file
+
+    /// Reinterprets the bytes as a contiguous array of trivially copyable records, returning the one at `index`.
+    /// The caller is responsible for the record layout matching the file and for the view being suitably aligned.
+    template <typename T>
+    const T* As(size_t index=0) const { return reinterpret_cast<const T*>(data) + index; }
+
+    template <typename T>
+    size_t Count() const { return size / sizeof(T); }
+};
+
+
+/// JEventSourceMmap is a JEventSource for files of raw records. It maps the file named by GetResourceName() before
+/// calling Open(), and unmaps it after Close() once every event which still holds a JMappedView has been recycled.
+/// Implementors walk the mapping from Emit() using GetMappedData()/GetMappedSize(), and hand each event its bytes via
+/// AttachView().
+///
+/// The whole mapping is advised as sequential, and AttachView() keeps a window of `<prefix>:mmap_willneed_bytes`
+/// ahead of the furthest view advised as will-need, so that the kernel reads ahead of the events instead of faulting
+/// the pages in one at a time.
+class JEventSourceMmap : public JEventSource {
+public:
+    JEventSourceMmap() = default;
+    explicit JEventSourceMmap(std::string resource_name, JApplication* app = nullptr)
+        : JEventSource(std::move(resource_name), app) {}
+
+    void SetWillNeedBytes(size_t bytes) { m_willneed_bytes = bytes; }
+    size_t GetWillNeedBytes() const { return m_willneed_bytes; }
+
+    void DoInit() override;
+    void DoOpen(bool with_lock=true) override;
+    void DoClose(bool with_lock=true) override;
+
+protected:
+    const char* GetMappedData() const { return m_file == nullptr ? nullptr : m_file->GetData(); }
+    size_t GetMappedSize() const { return m_file == nullptr ? 0 : m_file->GetSize(); }
+    const std::shared_ptr<const JMappedFile>& GetMappedFile() const { return m_file; }
+
+    /// Inserts a JMappedView of [offset, offset+size) into the event under `tag` and returns it. Throws if the range
+    /// lies outside the file. Meant to be called from Emit().
+    const JMappedView* AttachView(JEvent& event, size_t offset, size_t size, const std::string& tag="");
+
+private:
+    void MapAndOpen();
+
+    std::shared_ptr<const JMappedFile> m_file;
+    size_t m_willneed_bytes = 16 << 20;
+    size_t m_advised_until = 0;
+};
+
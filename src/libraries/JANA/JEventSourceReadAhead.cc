@@ -0,0 +1,157 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JEventSourceReadAhead.h"
+#include <JANA/JApplication.h>
+
+#include <cassert>
+
+
+JEventSourceReadAhead::~JEventSourceReadAhead() {
+    // By now the derived class is gone, so a prefetch thread still running could call a pure virtual ReadBlock().
+    // If you hit this, the source was neither closed nor torn down, and its own destructor didn't stop the thread.
+    assert(!m_read_ahead_thread.joinable());
+    StopReadAhead(); // Better than std::terminate() from destroying a joinable thread
+}
+
+
+void JEventSourceReadAhead::SetReadAheadDepth(size_t depth) {
+    if (depth == 0) {
+        throw JException("JEventSourceReadAhead: read_ahead_depth must be at least 1");
+    }
+    m_read_ahead_depth = depth;
+}
+
+
+size_t JEventSourceReadAhead::GetReadAheadStallCount() const {
+    std::lock_guard<std::mutex> lock(m_ring_mutex);
+    return m_stall_count;
+}
+
+
+void JEventSourceReadAhead::DoInit() {
+    JEventSource::DoInit();
+    // Registered after Init() so that whatever the implementor set there becomes the default
+    if (m_app != nullptr) {
+        auto prefix = GetPrefix();
+        if (prefix.empty()) prefix = "JEventSourceReadAhead";
+        m_app->SetDefaultParameter(prefix + ":read_ahead_depth", m_read_ahead_depth,
+                                   "Number of raw blocks the prefetch thread reads ahead of Emit()")->SetIsAdvanced(true);
+        m_app->SetDefaultParameter(prefix + ":read_ahead_buffer_size", m_read_ahead_buffer_size,
+                                   "Initial capacity [bytes] of each read-ahead buffer")->SetIsAdvanced(true);
+    }
+    SetReadAheadDepth(m_read_ahead_depth);
+}
+
+
+void JEventSourceReadAhead::DoOpen(bool with_lock) {
+    JEventSource::DoOpen(with_lock);
+    StartReadAhead();
+}
+
+
+void JEventSourceReadAhead::DoClose(bool with_lock) {
+    // ReadBlock() must be finished before Close() releases whatever it reads from
+    StopReadAhead();
+    JEventSource::DoClose(with_lock);
+}
+
+
+void JEventSourceReadAhead::DoTeardown() {
+    StopReadAhead();
+    JEventSource::DoTeardown();
+}
+
+
+JEventSource::Result JEventSourceReadAhead::NextBlock(Buffer*& block) {
+    std::lock_guard<std::mutex> lock(m_ring_mutex);
+    if (m_current_slot != NoSlot) {
+        m_free_slots.push_back(m_current_slot);
+        m_current_slot = NoSlot;
+        m_slot_freed.notify_one();
+    }
+    if (m_filled_slots.empty()) {
+        block = nullptr;
+        if (!m_end_of_input) {
+            m_stall_count += 1;
+            return Result::FailureTryAgain;
+        }
+        if (m_read_error) {
+            auto error = m_read_error;
+            m_read_error = nullptr;
+            std::rethrow_exception(error);
+        }
+        return Result::FailureFinished;
+    }
+    m_current_slot = m_filled_slots.front();
+    m_filled_slots.pop_front();
+    block = &m_buffers[m_current_slot];
+    return Result::Success;
+}
+
+
+void JEventSourceReadAhead::StartReadAhead() {
+    if (m_read_ahead_thread.joinable()) return;
+
+    m_buffers.assign(m_read_ahead_depth, Buffer());
+    m_free_slots.clear();
+    m_filled_slots.clear();
+    for (size_t slot=0; slot<m_read_ahead_depth; ++slot) {
+        m_buffers[slot].reserve(m_read_ahead_buffer_size);
+        m_free_slots.push_back(slot);
+    }
+    m_current_slot = NoSlot;
+    m_end_of_input = false;
+    m_stop_requested = false;
+    m_read_error = nullptr;
+    m_read_ahead_thread = std::thread(&JEventSourceReadAhead::ReadAheadLoop, this);
+}
+
+
+void JEventSourceReadAhead::StopReadAhead() {
+    if (!m_read_ahead_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_ring_mutex);
+        m_stop_requested = true;
+    }
+    m_slot_freed.notify_all();
+    m_read_ahead_thread.join();
+}
+
+
+void JEventSourceReadAhead::ReadAheadLoop() {
+    while (true) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(m_ring_mutex);
+            m_slot_freed.wait(lock, [&]{ return m_stop_requested || !m_free_slots.empty(); });
+            if (m_stop_requested) return;
+            slot = m_free_slots.front();
+            m_free_slots.pop_front();
+        }
+
+        // The slot belongs to this thread until it gets pushed back, so the read itself happens without any lock
+        auto& buffer = m_buffers[slot];
+        buffer.clear();
+        bool has_block = false;
+        std::exception_ptr error;
+        try {
+            has_block = ReadBlock(buffer);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(m_ring_mutex);
+        if (has_block && !error) {
+            m_filled_slots.push_back(slot);
+            continue;
+        }
+        m_free_slots.push_back(slot);
+        m_read_error = error;
+        m_end_of_input = true;
+        return;
+    }
+}
+
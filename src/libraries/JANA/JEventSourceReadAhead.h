@@ -0,0 +1,88 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JEventSource.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// JEventSourceReadAhead is a JEventSource whose raw reads happen on a dedicated prefetch thread instead of on a JANA
+/// worker. Emit() normally runs with the source's lock held, so a slow read or decompression there stalls every worker
+/// that wants an event. Here the prefetch thread calls ReadBlock() into a bounded ring of reusable buffers, staying up
+/// to `read_ahead_depth` blocks ahead, and Emit() only picks up blocks that are already resident via NextBlock().
+///
+/// Implementors provide ReadBlock(), which only moves bytes from the resource into a buffer, and Emit(), which calls
+/// NextBlock() and unpacks one event from the block it returns. A block may hold several events: keep using the same
+/// block until it is exhausted, then call NextBlock() again. The prefetch thread starts once Open() has returned and stops before
+/// Close() is called, so ReadBlock() never overlaps either of them.
+///
+/// The prefetch thread must be stopped before the derived class is destroyed. Closing the source does this, and so does
+/// DoTeardown(), which JANA calls right before deleting the sources it owns. Sources which are destroyed any other way
+/// while still open must call StopReadAhead() from their own destructor.
+///
+/// The read-ahead depth and the initial buffer capacity are available as the parameters `<prefix>:read_ahead_depth`
+/// and `<prefix>:read_ahead_buffer_size`.
+class JEventSourceReadAhead : public JEventSource {
+public:
+    using Buffer = std::vector<char>;
+
+    JEventSourceReadAhead() = default;
+    ~JEventSourceReadAhead() override;
+
+    /// Runs on the prefetch thread. Fills `buffer` with the next raw block and returns true, or returns false once the
+    /// resource is exhausted. `buffer` arrives empty but keeps whatever capacity it had from earlier reads. Exceptions
+    /// are handed over to the next NextBlock() call which runs out of resident blocks.
+    virtual bool ReadBlock(Buffer& buffer) = 0;
+
+    void SetReadAheadDepth(size_t depth);
+    void SetReadAheadBufferSize(size_t bytes) { m_read_ahead_buffer_size = bytes; }
+    size_t GetReadAheadDepth() const { return m_read_ahead_depth; }
+    size_t GetReadAheadBufferSize() const { return m_read_ahead_buffer_size; }
+
+    /// How many times NextBlock() found no resident block and had to report FailureTryAgain
+    size_t GetReadAheadStallCount() const;
+
+    /// Stops and joins the prefetch thread. This happens automatically when the source closes or is torn down.
+    void StopReadAhead();
+
+    void DoInit() override;
+    void DoOpen(bool with_lock=true) override;
+    void DoClose(bool with_lock=true) override;
+    void DoTeardown() final;
+
+protected:
+    /// Called from Emit(). Returns Success and points `block` at the oldest resident block, FailureTryAgain if the
+    /// prefetch thread hasn't caught up yet, or FailureFinished once ReadBlock() has reported the end of the input and
+    /// every block has been handed out. Each call recycles the block returned by the previous call, so the pointer is
+    /// only valid until then.
+    Result NextBlock(Buffer*& block);
+
+private:
+    void StartReadAhead();
+    void ReadAheadLoop();
+
+    size_t m_read_ahead_depth = 4;
+    size_t m_read_ahead_buffer_size = 1 << 20;
+
+    std::vector<Buffer> m_buffers;
+    std::deque<size_t> m_free_slots;
+    std::deque<size_t> m_filled_slots;   // Oldest first
+    size_t m_current_slot = NoSlot;
+    bool m_end_of_input = false;
+    bool m_stop_requested = false;
+    std::exception_ptr m_read_error;
+    size_t m_stall_count = 0;
+
+    mutable std::mutex m_ring_mutex;
+    std::condition_variable m_slot_freed;
+    std::thread m_read_ahead_thread;
+
+    static constexpr size_t NoSlot = static_cast<size_t>(-1);
+};
+
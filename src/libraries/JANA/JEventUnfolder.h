@@ -52,6 +52,8 @@ public:
     void SetChildLevel(JEventLevel level) { m_child_level = level; }
 
     void SetCallPreprocessUpstream(bool call_upstream) { m_call_preprocess_upstream = call_upstream; }
+
+    bool GetCallPreprocessUpstream() const { return m_call_preprocess_upstream; }
     
     JEventLevel GetChildLevel() { return m_child_level; }
 
@@ -9,6 +9,26 @@
 
 void JFactory::Create(const std::shared_ptr<const JEvent>& event) {
 
+    if (!mConcurrentCreate) {
+        CreateUnsynchronized(event);
+        return;
+    }
+
+    // Fast path: somebody already created (or inserted) this factory's data for this event. The acquire pairs with
+    // the release store of mStatus, so the data itself is visible too.
+    auto is_done = [this](Status status) {
+        return status == Status::Processed || (status == Status::Inserted && !TestFactoryFlag(REGENERATE));
+    };
+    if (is_done(mStatus.load(std::memory_order_acquire))) return;
+
+    // If another thread got here first, we block until it is finished and then find nothing left to do
+    std::lock_guard<std::mutex> lock(GetCreateMutex());
+    if (is_done(mStatus.load(std::memory_order_acquire))) return;
+    CreateUnsynchronized(event);
+}
+
+void JFactory::CreateUnsynchronized(const std::shared_ptr<const JEvent>& event) {
+
     if (mStatus == Status::Uninitialized) {
         CallWithJExceptionWrapper("JFactory::Init", [&](){ Init(); });
         mStatus = Status::Unprocessed;
@@ -20,24 +40,48 @@ void JFactory::Create(const std::shared_ptr<const JEvent>& event) {
     }
 
     if (mStatus == Status::Unprocessed) {
-        auto run_number = event->GetRunNumber();
-        if (mPreviousRunNumber == -1) {
-            // This is the very first run
-            CallWithJExceptionWrapper("JFactory::ChangeRun", [&](){ ChangeRun(event); });
-            CallWithJExceptionWrapper("JFactory::BeginRun", [&](){ BeginRun(event); });
-            mPreviousRunNumber = run_number;
+        if (TestFactoryFlag(RUN_SCOPED) && mRunScopedStore != nullptr) {
+            CreateRunScoped(event);
         }
-        else if (mPreviousRunNumber != run_number) {
-            // This is a later run, and it has changed
-            CallWithJExceptionWrapper("JFactory::EndRun", [&](){ EndRun(); });
-            CallWithJExceptionWrapper("JFactory::ChangeRun", [&](){ ChangeRun(event); });
-            CallWithJExceptionWrapper("JFactory::BeginRun", [&](){ BeginRun(event); });
-            mPreviousRunNumber = run_number;
+        else {
+            CallProcess(event);
         }
-        CallWithJExceptionWrapper("JFactory::Process", [&](){ Process(event); });
-        mStatus = Status::Processed;
         mCreationStatus = CreationStatus::Created;
+        mStatus.store(Status::Processed, std::memory_order_release);
+    }
+}
+
+void JFactory::CreateRunScoped(const std::shared_ptr<const JEvent>& event) {
+
+    auto run_number = event->GetRunNumber();
+    if (mSharedRunData == nullptr || mSharedRunNumber != run_number) {
+        // Whoever gets to a run first computes it; everybody else waits and then shares the result
+        mSharedRunData = mRunScopedStore->GetOrCompute(GetObjectType(), mTag, run_number, [&]() {
+            CallProcess(event);
+            return ShareRunData();
+        });
+        mSharedRunNumber = run_number;
+    }
+    AdoptRunData(mSharedRunData);
+}
+
+void JFactory::CallProcess(const std::shared_ptr<const JEvent>& event) {
+
+    auto run_number = event->GetRunNumber();
+    if (mPreviousRunNumber == -1) {
+        // This is the very first run
+        CallWithJExceptionWrapper("JFactory::ChangeRun", [&](){ ChangeRun(event); });
+        CallWithJExceptionWrapper("JFactory::BeginRun", [&](){ BeginRun(event); });
+        mPreviousRunNumber = run_number;
+    }
+    else if (mPreviousRunNumber != run_number) {
+        // This is a later run, and it has changed
+        CallWithJExceptionWrapper("JFactory::EndRun", [&](){ EndRun(); });
+        CallWithJExceptionWrapper("JFactory::ChangeRun", [&](){ ChangeRun(event); });
+        CallWithJExceptionWrapper("JFactory::BeginRun", [&](){ BeginRun(event); });
+        mPreviousRunNumber = run_number;
     }
+    CallWithJExceptionWrapper("JFactory::Process", [&](){ Process(event); });
 }
 
 void JFactory::DoInit() {
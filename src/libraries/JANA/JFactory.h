@@ -6,6 +6,8 @@
 
 #include <JANA/JException.h>
 #include <JANA/Utils/JAny.h>
+#include <JANA/Utils/JArena.h>
+#include <JANA/Utils/JRunScopedStore.h>
 #include <JANA/Utils/JEventLevel.h>
 #include <JANA/Utils/JCallGraphRecorder.h>
 #include <JANA/Omni/JComponent.h>
@@ -36,7 +38,9 @@ public:
         PERSISTENT = 0x01,       // Used heavily. Possibly better served by JServices, hierarchical events, or event groups. 
         WRITE_TO_OUTPUT = 0x02,  // Set in halld_recon but not read except by JANA1 janaroot and janacontrol plugins
         NOT_OBJECT_OWNER = 0x04, // Used heavily. Small conflict with PODIO subset collections, which do the same thing at a different level
-        REGENERATE = 0x08        // Replaces JANA1 JFactory_base::use_factory and JFactory::GetCheckSourceFirst()
+        REGENERATE = 0x08,       // Replaces JANA1 JFactory_base::use_factory and JFactory::GetCheckSourceFirst()
+        RECYCLE_OBJECTS = 0x10,  // ClearData() keeps owned objects on a free list for JFactoryT::Make() to hand out again
+        RUN_SCOPED = 0x20        // Output depends only on the run, so it is computed once per run and shared by all pooled events
     };
 
     JFactory(std::string aName, std::string aTag = "")
@@ -54,7 +58,7 @@ public:
     std::string GetTag() const { return mTag; }
     std::string GetObjectName() const { return mObjectName; }
     std::string GetFactoryName() const { return m_type_name; }
-    Status GetStatus() const { return mStatus; }
+    Status GetStatus() const { return mStatus.load(std::memory_order_acquire); }
     CreationStatus GetCreationStatus() const { return mCreationStatus; }
     JCallGraphRecorder::JDataOrigin GetInsertOrigin() const { return m_insert_origin; } ///< If objects were placed here by JEvent::Insert() this records whether that call was made from a source or factory.
 
@@ -67,7 +71,7 @@ public:
     void SetObjectName(std::string objectName) { mObjectName = std::move(objectName); }
     void SetFactoryName(std::string factoryName) { SetTypeName(factoryName); }
 
-    void SetStatus(Status status){ mStatus = status; }
+    void SetStatus(Status status){ mStatus.store(status, std::memory_order_release); }
     void SetCreationStatus(CreationStatus status){ mCreationStatus = status; }
     void SetInsertOrigin(JCallGraphRecorder::JDataOrigin origin) { m_insert_origin = origin; } ///< Called automatically by JEvent::Insert() to records whether that call was made by a source or factory.
 
@@ -113,6 +117,20 @@ public:
             ClearFactoryFlag(REGENERATE); }
     }
 
+    inline void SetRecycleFlag(bool recycle) {
+        if (recycle) {
+            SetFactoryFlag(RECYCLE_OBJECTS); }
+        else {
+            ClearFactoryFlag(RECYCLE_OBJECTS); }
+    }
+
+    inline void SetRunScopedFlag(bool run_scoped) {
+        if(run_scoped) {
+            SetFactoryFlag(RUN_SCOPED); }
+        else {
+            ClearFactoryFlag(RUN_SCOPED); }
+    }
+
     inline void SetWriteToOutputFlag(bool write_to_output) { 
         if (write_to_output) {
             SetFactoryFlag(WRITE_TO_OUTPUT); }
@@ -174,6 +192,30 @@ public:
     /// type of object contained. In order to access these objects when all you have is a JFactory*, use JFactory::GetAs().
     virtual void Create(const std::shared_ptr<const JEvent>& event);
     void DoInit();
+
+    /// In concurrent-create mode, Create() runs Process() at most once per event even when several threads ask
+    /// for the same factory at once. Whoever gets there first runs it; everybody else blocks until it is done.
+    /// Once the factory has been processed, Create() costs a single acquire load, exactly like before.
+    /// This is off by default, because nothing touches an event from more than one thread unless asked to.
+    void SetConcurrentCreate(bool concurrent) { mConcurrentCreate = concurrent; }
+    bool GetConcurrentCreate() const { return mConcurrentCreate; }
+
+    /// The arena of the event this factory belongs to. JFactorySet sets this; ClearData() won't delete anything in it.
+    void SetArena(JArena* arena) { mArena = arena; }
+    JArena* GetArena() const { return mArena; }
+
+    /// Opt in to placing objects made via JFactoryT::NewObject() in the event's arena. Ignored for persistent factories,
+    /// since their data outlives the event. Only factories which opt in check their objects against the arena in
+    /// ClearData(), so objects from the arena must not be inserted into any other factory.
+    void SetUseArena(bool use_arena) { mUseArena = use_arena; }
+    bool GetUseArena() const { return mUseArena; }
+
+    /// Where RUN_SCOPED factories keep their shared output. JFactorySet sets this; without it, the flag does nothing.
+    /// For a run-scoped factory, ChangeRun(), BeginRun() and Process() only run on whichever pooled instance gets to
+    /// a new run first, using the first event of that run which it sees. Every other instance just gets handed the
+    /// resulting objects, which it must treat as read-only.
+    void SetRunScopedStore(JRunScopedStore* store) { mRunScopedStore = store; }
+    JRunScopedStore* GetRunScopedStore() const { return mRunScopedStore; }
     void Summarize(JComponentSummary& summary);
 
 
@@ -189,10 +231,31 @@ protected:
     int32_t mPreviousRunNumber = -1;
     std::unordered_map<std::type_index, std::unique_ptr<JAny>> mUpcastVTable;
 
-    mutable Status mStatus = Status::Uninitialized;
+    mutable std::atomic<Status> mStatus {Status::Uninitialized};
     mutable JCallGraphRecorder::JDataOrigin m_insert_origin = JCallGraphRecorder::ORIGIN_NOT_AVAILABLE; // (see note at top of JCallGraphRecorder.h)
 
     CreationStatus mCreationStatus = CreationStatus::NotCreatedYet;
+    bool mConcurrentCreate = false;
+    std::mutex mCreateMutex;
+    JArena* mArena = nullptr;
+    bool mUseArena = false;
+    JRunScopedStore* mRunScopedStore = nullptr;
+    std::shared_ptr<const void> mSharedRunData;   // This run's output, as held by mRunScopedStore
+    int32_t mSharedRunNumber = -1;
+
+    /// The mutex which concurrent Create() calls serialize on. JMultifactoryHelpers override this so that all
+    /// of a multifactory's outputs share one mutex, since creating any of them creates all of them.
+    virtual std::mutex& GetCreateMutex() { return mCreateMutex; }
+
+    /// Hands over the objects Process() just produced, for mRunScopedStore to keep. JFactoryT implements these.
+    virtual std::shared_ptr<const void> ShareRunData() { return nullptr; }
+    /// Points this factory at objects which some ShareRunData() handed over, without taking ownership
+    virtual void AdoptRunData(const std::shared_ptr<const void>&) {}
+
+private:
+    void CreateUnsynchronized(const std::shared_ptr<const JEvent>& event);
+    void CreateRunScoped(const std::shared_ptr<const JEvent>& event);
+    void CallProcess(const std::shared_ptr<const JEvent>& event);
 };
 
 // Because C++ doesn't support templated virtual functions, we implement our own dispatch table, mUpcastVTable.
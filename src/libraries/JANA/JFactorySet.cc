@@ -10,6 +10,7 @@
 #include "JFactory.h"
 #include "JMultifactory.h"
 #include "JFactoryGenerator.h"
+#include <JANA/Utils/JFactoryDag.h>
 
 //---------------------------------
 // JFactorySet    (Constructor)
@@ -68,6 +69,151 @@ JFactorySet::~JFactorySet()
 
 }
 
+//---------------------------------
+// EnableFactoryDag
+//---------------------------------
+void JFactorySet::EnableFactoryDag(JTaskQueue* task_queue)
+{
+    /// The DAG itself is built lazily, the first time a consumer prefetches through it,
+    /// so that it sees every factory added in the meantime.
+    /// Concurrent-create mode has to come first: nodes may lazily pull the same undeclared factory at once.
+    EnableConcurrentCreate();
+    mFactoryDag = std::make_unique<JFactoryDag>(this, task_queue);
+}
+
+//---------------------------------
+// EnableConcurrentCreate
+//---------------------------------
+void JFactorySet::EnableConcurrentCreate()
+{
+    /// Puts every factory, including any added later, into concurrent-create mode.
+    /// Lazy materialization isn't thread-safe, so everything gets materialized up front.
+    MaterializeAll();
+    mConcurrentCreate = true;
+    if (mArena != nullptr) {
+        // Factories running in parallel may allocate from the event's arena at the same time
+        mArena->SetThreadSafe(true);
+    }
+    for (auto& f : mFactories) {
+        f.second->SetConcurrentCreate(true);
+    }
+}
+
+//---------------------------------
+// SetArena
+//---------------------------------
+void JFactorySet::SetArena(JArena* arena)
+{
+    mArena = arena;
+    if (mArena != nullptr && mConcurrentCreate) {
+        mArena->SetThreadSafe(true);
+    }
+    for (auto& f : mFactories) {
+        f.second->SetArena(arena);
+    }
+}
+
+//---------------------------------
+// SetRunScopedStore
+//---------------------------------
+void JFactorySet::SetRunScopedStore(std::shared_ptr<JRunScopedStore> store)
+{
+    mRunScopedStore = std::move(store);
+    for (auto& f : mFactories) {
+        f.second->SetRunScopedStore(mRunScopedStore.get());
+    }
+}
+
+//---------------------------------
+// SetRegistry
+//---------------------------------
+void JFactorySet::SetRegistry(std::shared_ptr<const JFactoryRegistry> registry)
+{
+    mRegistry = std::move(registry);
+    mMaterialized.assign(mRegistry->GetGeneratorCount(), false);
+    for (size_t gen=0; gen<mRegistry->GetGeneratorCount(); ++gen) {
+        if (mRegistry->IsEager(gen) || mConcurrentCreate) {
+            Materialize(gen);
+        }
+    }
+}
+
+//---------------------------------
+// MaterializeAll
+//---------------------------------
+void JFactorySet::MaterializeAll()
+{
+    if (mRegistry == nullptr) return;
+    for (size_t gen=0; gen<mRegistry->GetGeneratorCount(); ++gen) {
+        Materialize(gen);
+    }
+}
+
+//---------------------------------
+// Materialize
+//---------------------------------
+bool JFactorySet::Materialize(size_t generator) const
+{
+    /// Runs one of the registry's generators, unless it already ran. Returns whether it did anything.
+    /// This is logically const: as far as callers can tell, the factories were there all along.
+    if (mRegistry == nullptr || generator == JFactoryRegistry::npos || mMaterialized[generator]) return false;
+    auto self = const_cast<JFactorySet*>(this);
+    self->mMaterialized[generator] = true;
+
+    // Earlier generators win collisions, so they have to go first
+    for (size_t predecessor : mRegistry->GetPredecessors(generator)) {
+        Materialize(predecessor);
+    }
+
+    JFactorySet temp_set;
+    mRegistry->GetGenerator(generator)->GenerateFactories(&temp_set);
+    auto generated = temp_set.GetAllFactories();
+    self->Merge(temp_set); // Shadowed factories stay in temp_set and get deleted along with it
+    for (JFactory* factory : generated) {
+        auto it = mFactories.find(std::make_pair(factory->GetObjectType(), factory->GetTag()));
+        if (it != mFactories.end() && it->second == factory) {
+            self->mRegisteredFactories.emplace_back(factory, mRegistry->FindFactory(factory->GetObjectType(), factory->GetTag()));
+        }
+    }
+    mRegistry->RecordMaterialized(generator);
+    return true;
+}
+
+//---------------------------------
+// MaterializeType
+//---------------------------------
+void JFactorySet::MaterializeType(std::type_index type) const
+{
+    if (mRegistry == nullptr) return;
+    for (size_t gen : mRegistry->FindGenerators(type)) {
+        Materialize(gen);
+    }
+}
+
+//---------------------------------
+// SetFactoryIndex
+//---------------------------------
+void JFactorySet::SetFactoryIndex(std::shared_ptr<const JFactoryIndex> index)
+{
+    mFactoryIndex = std::move(index);
+    mFactoriesBySlot.assign(mFactoryIndex->GetSlotCount(), nullptr);
+    for (auto& f : mFactories) {
+        AddToSlot(f.second);
+    }
+}
+
+//---------------------------------
+// AddToSlot
+//---------------------------------
+void JFactorySet::AddToSlot(JFactory* factory)
+{
+    if (mFactoryIndex == nullptr) return;
+    size_t slot = mFactoryIndex->GetSlot(factory->GetObjectType(), factory->GetTag());
+    if (slot < mFactoriesBySlot.size()) {
+        mFactoriesBySlot[slot] = factory;
+    }
+}
+
 //---------------------------------
 // Add
 //---------------------------------
@@ -92,8 +238,18 @@ bool JFactorySet::Add(JFactory* aFactory)
         // return false;
     }
 
+    if (mConcurrentCreate) {
+        aFactory->SetConcurrentCreate(true);
+    }
+    if (mArena != nullptr) {
+        aFactory->SetArena(mArena);
+    }
+    if (mRunScopedStore != nullptr) {
+        aFactory->SetRunScopedStore(mRunScopedStore.get());
+    }
     mFactories[typed_key] = aFactory;
     mFactoriesFromString[untyped_key] = aFactory;
+    AddToSlot(aFactory);
     return true;
 }
 
@@ -129,6 +285,9 @@ JFactory* JFactorySet::GetFactory(const std::string& object_name, const std::str
         }
         return it->second;
     }
+    if (mRegistry != nullptr && Materialize(mRegistry->FindGenerator(object_name, tag))) {
+        return GetFactory(object_name, tag);
+    }
     return nullptr;
 }
 
@@ -185,12 +344,19 @@ void JFactorySet::Merge(JFactorySet &aFactorySet)
         else {
             mFactories[typed_key] = factory;
             mFactoriesFromString[untyped_key] = factory;
+            AddToSlot(factory);
+            if (mArena != nullptr) factory->SetArena(mArena);
+            if (mRunScopedStore != nullptr) factory->SetRunScopedStore(mRunScopedStore.get());
+            if (mConcurrentCreate) factory->SetConcurrentCreate(true);
         }
     }
 
     // Copy duplicates back to aFactorySet
     aFactorySet.mFactories.swap( tmpSet.mFactories );
     tmpSet.mFactories.clear(); // prevent ~JFactorySet from deleting any factories
+    if (aFactorySet.mFactoryIndex != nullptr) {
+        aFactorySet.SetFactoryIndex(aFactorySet.mFactoryIndex);
+    }
 
     // Move ownership of multifactory pointers over.
     for (auto* mf : aFactorySet.mMultifactories) {
@@ -226,6 +392,14 @@ void JFactorySet::Print() const
 /// Release() loops over all contained factories, clearing their data
 void JFactorySet::Release() {
 
+    // Tell the registry which of the lazily materialized factories got used, before ClearData() forgets
+    for (const auto& entry : mRegisteredFactories) {
+        auto status = entry.first->GetStatus();
+        if (entry.second != JFactoryRegistry::npos && (status == JFactory::Status::Processed || status == JFactory::Status::Inserted)) {
+            mRegistry->RecordUsed(entry.second);
+        }
+    }
+
     for (const auto& sFactoryPair : mFactories) {
         auto sFactory = sFactoryPair.second;
         sFactory->ClearData();
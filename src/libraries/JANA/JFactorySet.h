@@ -7,15 +7,20 @@
 #include <string>
 #include <typeindex>
 #include <map>
+#include <memory>
 
 #include <JANA/JFactoryT.h>
 #include <JANA/Utils/JEventLevel.h>
+#include <JANA/Utils/JFactoryIndex.h>
+#include <JANA/Utils/JFactoryRegistry.h>
 #include <JANA/Utils/JResettable.h>
 #include <JANA/Status/JComponentSummary.h>
 
 class JFactoryGenerator;
 class JFactory;
 class JMultifactory;
+class JFactoryDag;
+class JTaskQueue;
 
 
 class JFactorySet : public JResettable
@@ -34,51 +39,131 @@ class JFactorySet : public JResettable
 
         JFactory* GetFactory(const std::string& object_name, const std::string& tag="") const;
         template<typename T> JFactoryT<T>* GetFactory(const std::string& tag = "") const;
+        /// In lazy mode (see SetRegistry), this only returns the factories which have been materialized so far
         std::vector<JFactory*> GetAllFactories() const;
         std::vector<JMultifactory*> GetAllMultifactories() const;
         template<typename T> std::vector<JFactoryT<T>*> GetAllFactories() const;
+        /// Like GetAllFactories<T>(), but without building a vector. Returns T's first factory and the end of the whole map.
+        /// Walk until the type changes rather than up to a fixed end, since factories of other types may be added
+        /// in the meantime (e.g. by Insert() or a lazy materialization). Factories from other levels are not filtered out.
+        template<typename T> std::pair<typename JConcatSpan<T>::FactoryIt, typename JConcatSpan<T>::FactoryIt> GetFactoryRange() const;
 
         JEventLevel GetLevel() const { return mLevel; }
         void SetLevel(JEventLevel level) { mLevel = level; }
 
+        /// Lets declared factories run in parallel via a JFactoryDag, whose tasks go onto task_queue
+        void EnableFactoryDag(JTaskQueue* task_queue);
+        /// nullptr unless EnableFactoryDag() has been called
+        JFactoryDag* GetFactoryDag() const { return mFactoryDag.get(); }
+
+        /// Lets several threads Create() the same factory for the same event. See JFactory::SetConcurrentCreate.
+        /// EnableFactoryDag() turns this on automatically.
+        void EnableConcurrentCreate();
+        bool IsConcurrentCreateEnabled() const { return mConcurrentCreate; }
+
+        /// The arena of the event owning this set. Every factory, including any added later, gets pointed at it.
+        void SetArena(JArena* arena);
+        JArena* GetArena() const { return mArena; }
+
+        /// Where RUN_SCOPED factories share their output with the other pooled events. Like the arena, every factory
+        /// gets pointed at it, including any added later.
+        void SetRunScopedStore(std::shared_ptr<JRunScopedStore> store);
+        JRunScopedStore* GetRunScopedStore() const { return mRunScopedStore.get(); }
+
+        /// Stores factories in a flat vector, at the slots given by index, so that GetFactory<T>() can skip
+        /// the map lookups. Factories which the index doesn't know about are still found via the maps.
+        void SetFactoryIndex(std::shared_ptr<const JFactoryIndex> index);
+        const JFactoryIndex* GetFactoryIndex() const { return mFactoryIndex.get(); }
+        /// The factory at a slot of GetFactoryIndex(), or nullptr if this set doesn't have one there
+        template<typename T> JFactoryT<T>* GetFactoryAtSlot(size_t slot) const;
+
+        /// Puts this (empty) set into lazy mode: each of the registry's generators only runs once something looks up
+        /// one of its factories, instead of up front like JFactorySet(generators) does. Factories which were looked up
+        /// get reported back to the registry in Release(). Lookups never materialize anything concurrently, so
+        /// EnableConcurrentCreate() materializes everything.
+        void SetRegistry(std::shared_ptr<const JFactoryRegistry> registry);
+        const JFactoryRegistry* GetRegistry() const { return mRegistry.get(); }
+        /// Runs every generator which hasn't run yet. Does nothing unless SetRegistry() was called.
+        void MaterializeAll();
+
     protected:
         std::map<std::pair<std::type_index, std::string>, JFactory*> mFactories;        // {(typeid, tag) : factory}
         std::map<std::pair<std::string, std::string>, JFactory*> mFactoriesFromString;  // {(objname, tag) : factory}
         std::vector<JMultifactory*> mMultifactories;
         bool mIsFactoryOwner = true;
         JEventLevel mLevel = JEventLevel::PhysicsEvent;
-        
+        std::unique_ptr<JFactoryDag> mFactoryDag;
+        bool mConcurrentCreate = false;
+        std::shared_ptr<const JFactoryIndex> mFactoryIndex;
+        std::vector<JFactory*> mFactoriesBySlot;   // Indexed by mFactoryIndex slot, nullptr if not present
+        JArena* mArena = nullptr;
+        std::shared_ptr<JRunScopedStore> mRunScopedStore;
+        std::shared_ptr<const JFactoryRegistry> mRegistry;
+        std::vector<bool> mMaterialized;                                    // Indexed by registry generator
+        std::vector<std::pair<JFactory*, size_t>> mRegisteredFactories;     // (factory, registry factory index)
+
+        void AddToSlot(JFactory* factory);
+        bool Materialize(size_t generator) const;
+        void MaterializeType(std::type_index type) const;
+        template<typename T> JFactoryT<T>* CheckLevel(JFactory* factory) const;
+
 };
 
 
+template<typename T>
+JFactoryT<T>* JFactorySet::CheckLevel(JFactory* factory) const {
+    JEventLevel found_level = factory->GetLevel();
+    if (found_level != mLevel) {
+        throw JException("Factory belongs to a different level on the event hierarchy. Expected: %s, Found: %s", toString(mLevel).c_str(), toString(found_level).c_str());
+    }
+    return static_cast<JFactoryT<T>*>(factory);
+}
+
+template<typename T>
+JFactoryT<T>* JFactorySet::GetFactoryAtSlot(size_t slot) const {
+    if (slot >= mFactoriesBySlot.size() || mFactoriesBySlot[slot] == nullptr) return nullptr;
+    return CheckLevel<T>(mFactoriesBySlot[slot]);
+}
+
 template<typename T>
 JFactoryT<T>* JFactorySet::GetFactory(const std::string& tag) const {
 
+    if (mFactoryIndex != nullptr) {
+        auto factory = GetFactoryAtSlot<T>(mFactoryIndex->GetSlot<T>(tag));
+        if (factory != nullptr) return factory;
+    }
+
     auto typed_key = std::make_pair(std::type_index(typeid(T)), tag);
     auto typed_iter = mFactories.find(typed_key);
     if (typed_iter != std::end(mFactories)) {
-        JEventLevel found_level = typed_iter->second->GetLevel();
-        if (found_level != mLevel) {
-            throw JException("Factory belongs to a different level on the event hierarchy. Expected: %s, Found: %s", toString(mLevel).c_str(), toString(found_level).c_str());
-        }
-        return static_cast<JFactoryT<T>*>(typed_iter->second);
+        return CheckLevel<T>(typed_iter->second);
     }
 
-    auto untyped_key = std::make_pair(JTypeInfo::demangle<T>(), tag);
+    static const std::string type_name = JTypeInfo::demangle<T>();
+    auto untyped_key = std::make_pair(type_name, tag);
     auto untyped_iter = mFactoriesFromString.find(untyped_key);
     if (untyped_iter != std::end(mFactoriesFromString)) {
-        JEventLevel found_level = untyped_iter->second->GetLevel();
-        if (found_level != mLevel) {
-            throw JException("Factory belongs to a different level on the event hierarchy. Expected: %s, Found: %s", toString(mLevel).c_str(), toString(found_level).c_str());
-        }
-        return static_cast<JFactoryT<T>*>(untyped_iter->second);
+        return CheckLevel<T>(untyped_iter->second);
+    }
+    if (mRegistry != nullptr && Materialize(mRegistry->FindGenerator(std::type_index(typeid(T)), tag))) {
+        return GetFactory<T>(tag);
     }
     return nullptr;
 }
 
+template<typename T>
+std::pair<typename JConcatSpan<T>::FactoryIt, typename JConcatSpan<T>::FactoryIt> JFactorySet::GetFactoryRange() const {
+    // mFactories is sorted by (type, tag), so all of T's factories sit next to each other, starting at tag ""
+    auto sKey = std::type_index(typeid(T));
+    MaterializeType(sKey);
+    auto first = mFactories.lower_bound(std::make_pair(sKey, std::string()));
+    return {first, mFactories.end()};
+}
+
 template<typename T>
 std::vector<JFactoryT<T>*> JFactorySet::GetAllFactories() const {
     auto sKey = std::type_index(typeid(T));
+    MaterializeType(sKey);
     std::vector<JFactoryT<T>*> data;
     for (auto it=std::begin(mFactories);it!=std::end(mFactories);it++){
         if (it->first.first==sKey){
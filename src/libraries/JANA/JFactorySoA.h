@@ -0,0 +1,51 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JFactoryT.h>
+#include <JANA/JSoA.h>
+
+
+/// Lets JFactory::GetAs<JObject>() see each row of a factory's JSoA tables, for JInspector and friends. The views
+/// are rebuilt on every call, which invalidates the ones handed out previously.
+template <typename Schema>
+void EnableJObjectViews(JFactoryT<JSoA<Schema>>& factory) {
+    auto views = std::make_shared<std::vector<std::unique_ptr<JSoARowView<Schema>>>>();
+    factory.template EnableGetAs<JObject>(std::function<std::vector<JObject*>()>([&factory, views]() {
+        views->clear();
+        std::vector<JObject*> results;
+        for (const JSoA<Schema>* table : factory.GetSpan()) {
+            for (size_t row=0; row<table->size(); ++row) {
+                views->push_back(std::make_unique<JSoARowView<Schema>>(table, row));
+                results.push_back(views->back().get());
+            }
+        }
+        return results;
+    }));
+}
+
+
+/// JFactorySoA is a JFactoryT whose output is a single columnar JSoA<Schema> table instead of a vector of
+/// individually allocated objects. Process() fills in the table returned by MakeTable(). Consumers get it via
+/// JEvent::GetSoA<Schema>(tag), or via a JHasInputs::SoAInput<Schema>.
+///
+/// Tables are recycled (see JFactory::RECYCLE_OBJECTS), so after the first few events the columns already have
+/// enough capacity and filling them doesn't allocate.
+template <typename Schema>
+class JFactorySoA : public JFactoryT<JSoA<Schema>> {
+public:
+    JFactorySoA() {
+        this->SetRecycleFlag(true);
+        EnableJObjectViews(*this);
+    }
+
+    /// Inserts an empty table for this event and returns it
+    JSoA<Schema>& MakeTable() {
+        auto* table = this->Make();
+        table->clear();
+        this->Insert(table);
+        return *table;
+    }
+};
+
@@ -11,6 +11,8 @@
 #include <JANA/JFactory.h>
 #include <JANA/JObject.h>
 #include <JANA/JVersion.h>
+#include <JANA/Utils/JResettable.h>
+#include <JANA/Utils/JSpan.h>
 #include <JANA/Utils/JTypeInfo.h>
 
 #if JANA2_HAVE_ROOT
@@ -57,7 +59,9 @@ public:
 #endif
     }
 
-    ~JFactoryT() override = default;
+    ~JFactoryT() override {
+        for (auto p : mRecycled) delete p;
+    }
 
     void Init() override {}
     void BeginRun(const std::shared_ptr<const JEvent>&) override {}
@@ -83,6 +87,15 @@ public:
         return std::make_pair(mData.cbegin(), mData.cend());
     }
 
+    /// A view of whatever data the factory currently holds. This does NOT call Create().
+    JSpan<T> GetSpan() const { return JSpan<T>(mData); }
+
+    /// Like CreateAndGetData, but returns a JSpan, which is a little easier to work with
+    JSpan<T> CreateAndGetSpan(const std::shared_ptr<const JEvent>& event) {
+        Create(event);
+        return JSpan<T>(mData);
+    }
+
 
     /// Please use the typed setters instead whenever possible
     // TODO: Deprecate this!
@@ -135,6 +148,36 @@ public:
     }
 
 
+    /// Constructs a T for this factory to Insert() or Set(). If the factory has opted in via SetUseArena(true), the
+    /// object lives in the event's arena and is destroyed in bulk once the event is recycled; otherwise this is plain new.
+    template <typename... Args>
+    T* NewObject(Args&&... args) {
+        if (mUseArena && mArena != nullptr && !TestFactoryFlag(JFactory_Flags_t::PERSISTENT) && !TestFactoryFlag(JFactory_Flags_t::RUN_SCOPED)) {
+            return mArena->Create<T>(std::forward<Args>(args)...);
+        }
+        return new T(std::forward<Args>(args)...);
+    }
+
+
+    /// Hands out an object previously recycled by ClearData() if the RECYCLE_OBJECTS flag is set and one is available,
+    /// keeping whatever capacity it had, and falls back to NewObject() otherwise. Because a factory belongs to exactly
+    /// one event, the free list is only ever touched by one thread at a time. Recycled objects come back exactly as
+    /// they were left, except that a T deriving from JResettable gets Release() on recycling and Reset() on reuse.
+    T* Make() {
+        if (mRecycled.empty()) {
+            return NewObject();
+        }
+        T* obj = mRecycled.back();
+        mRecycled.pop_back();
+        if constexpr (std::is_base_of<JResettable, T>::value) {
+            obj->Reset();
+        }
+        return obj;
+    }
+
+    std::size_t GetRecycledCount() const { return mRecycled.size(); }
+
+
     /// EnableGetAs generates a vtable entry so that users may extract the
     /// contents of this JFactoryT from the type-erased JFactory. The user has to manually specify which upcasts
     /// to allow, and they have to do so for each instance. It is recommended to do so in the constructor.
@@ -146,6 +189,13 @@ public:
     template <typename S> void EnableGetAs(std::true_type) { EnableGetAs<S>(); }
     template <typename S> void EnableGetAs(std::false_type) {}
 
+    /// Like EnableGetAs<S>(), but for a T which can't simply be cast to an S. For instance, each JSoA table
+    /// is viewed as one JObject per row.
+    template <typename S> void EnableGetAs(std::function<std::vector<S*>()> upcast_fn) {
+        using upcast_fn_t = std::function<std::vector<S*>()>;
+        mUpcastVTable[std::type_index(typeid(S))] = std::unique_ptr<JAny>(new JAnyT<upcast_fn_t>(std::move(upcast_fn)));
+    }
+
     void ClearData() override {
 
         // ClearData won't do anything if Init() hasn't been called
@@ -157,10 +207,28 @@ public:
         if (TestFactoryFlag(JFactory_Flags_t::PERSISTENT)) {
             return;
         }
+        // Run-scoped data belongs to the JRunScopedStore, unless somebody inserted their own
+        if (mSharedRunData != nullptr && mCreationStatus == CreationStatus::Created) {
+            mData.clear();
+            mStatus = Status::Unprocessed;
+            mCreationStatus = CreationStatus::NotCreatedYet;
+            return;
+        }
 
-        // Assuming we _are_ the object owner, delete the underlying jobjects
+        // Assuming we _are_ the object owner, delete the underlying jobjects.
+        // If we opted in to the event's arena, anything living there gets destroyed when the arena is reset instead.
         if (!TestFactoryFlag(JFactory_Flags_t::NOT_OBJECT_OWNER)) {
-            for (auto p : mData) delete p;
+            if (TestFactoryFlag(JFactory_Flags_t::RECYCLE_OBJECTS)) {
+                for (auto p : mData) Recycle(p);
+            }
+            else if (mUseArena && mArena != nullptr && mArena->GetChunkCount() != 0) {
+                for (auto p : mData) {
+                    if (!mArena->Owns(p)) delete p;
+                }
+            }
+            else {
+                for (auto p : mData) delete p;
+            }
         }
         mData.clear();
         mStatus = Status::Unprocessed;
@@ -179,7 +247,43 @@ public:
 
 protected:
     std::vector<T*> mData;
+    std::vector<T*> mRecycled;   // Free list for Make(), only used with RECYCLE_OBJECTS
     JMetadata<T> mMetadata;
+
+    /// What a RUN_SCOPED factory shares with its counterparts in the other pooled events
+    struct SharedRunData {
+        std::vector<T*> data;
+        JMetadata<T> metadata;
+        bool is_owner = true;
+        ~SharedRunData() {
+            if (is_owner) for (auto p : data) delete p;
+        }
+    };
+
+    std::shared_ptr<const void> ShareRunData() override {
+        auto shared = std::make_shared<SharedRunData>();
+        shared->data = std::move(mData);
+        shared->metadata = mMetadata;
+        shared->is_owner = !TestFactoryFlag(JFactory_Flags_t::NOT_OBJECT_OWNER);
+        mData.clear();
+        return shared;
+    }
+
+    void AdoptRunData(const std::shared_ptr<const void>& data) override {
+        auto shared = static_cast<const SharedRunData*>(data.get());
+        mData = shared->data;
+        mMetadata = shared->metadata;
+    }
+
+private:
+    void Recycle(T* obj) {
+        // Arena objects are destroyed by the arena, so we can't hang on to them
+        if (mUseArena && mArena != nullptr && mArena->GetChunkCount() != 0 && mArena->Owns(obj)) return;
+        if constexpr (std::is_base_of<JResettable, T>::value) {
+            obj->Release();
+        }
+        mRecycled.push_back(obj);
+    }
 };
 
 template<typename T>
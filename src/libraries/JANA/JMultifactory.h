@@ -32,6 +32,9 @@ public:
     // It might make more sense to (1) put Create() back on JFactory, (2) make Create() virtual, (3) override Create()
     // Alternatively, we could move all the JMultiFactoryHelper functionality into JFactoryT directly
 
+    std::mutex& GetCreateMutex() override;
+    // Creating any one helper runs the whole multifactory, so concurrent Create() calls on its siblings must wait too
+
     JMultifactory* GetMultifactory() { return mMultiFactory; }
 };
 
@@ -53,6 +56,9 @@ public:
     // It might make more sense to (1) put Create() back on JFactory, (2) make Create() virtual, (3) override Create()
     // Alternatively, we could move all of the JMultiFactoryHelper functionality into JFactoryT directly
 
+    std::mutex& GetCreateMutex() override;
+    // Creating any one helper runs the whole multifactory, so concurrent Create() calls on its siblings must wait too
+
     JMultifactory* GetMultifactory() { return mMultiFactory; }
 };
 #endif // JANA2_HAVE_PODIO
@@ -71,6 +77,9 @@ class JMultifactory : public jana::omni::JComponent,
                               // This can be used for parameter and collection name prefixing, though at a higher level
     std::string mFactoryName; // So we can propagate this to the JMultifactoryHelpers, so we can have useful error messages
 
+    std::mutex mCreateMutex;  // Shared by all the JMultifactoryHelpers when they are in concurrent-create mode.
+                              // This is separate from m_mutex, which Execute() takes while the helper holds this one.
+
 #if JANA2_HAVE_PODIO
     bool mNeedPodio = false;      // Whether we need to retrieve the podio::Frame
     podio::Frame* mPodioFrame = nullptr;  // To provide the podio::Frame to SetPodioData, SetCollection
@@ -127,11 +136,19 @@ public:
     // This is meant to be called from JFactorySet, which will take ownership of the helpers while leaving the pointers
     // in place. This method is only supposed to be called by JFactorySet::Add(JMultifactory).
 
+    std::mutex& GetCreateMutex() { return mCreateMutex; }
+    // The JMultifactoryHelpers all lock this in concurrent-create mode, so that only one of them calls Execute()
+
     // These are set by JFactoryGeneratorT (just like JFactories) and get propagated to each of the JMultifactoryHelpers
     void SetTag(std::string tag) { mTag = std::move(tag); }
     void SetFactoryName(std::string factoryName) { mFactoryName = std::move(factoryName); }
     
     void Summarize(JComponentSummary& summary) override;
+
+    /// Whether Summarize() reports every input this multifactory will ask for. JOmniFactories declare their
+    /// inputs up front, which lets the JFactoryDag schedule them ahead of time. Plain JMultifactories only
+    /// find out what they need while they run, so they are left to be pulled lazily.
+    virtual bool AreInputsDeclared() const { return false; }
 };
 
 
@@ -246,12 +263,22 @@ void JMultifactoryHelper<T>::Process(const std::shared_ptr<const JEvent> &event)
     mMultiFactory->Execute(event);
 }
 
+template <typename T>
+std::mutex& JMultifactoryHelper<T>::GetCreateMutex() {
+    return mMultiFactory->GetCreateMutex();
+}
+
 #if JANA2_HAVE_PODIO
 template <typename T>
 void JMultifactoryHelperPodio<T>::Process(const std::shared_ptr<const JEvent> &event) {
     mMultiFactory->SetApplication(this->GetApplication());
     mMultiFactory->Execute(event);
 }
+
+template <typename T>
+std::mutex& JMultifactoryHelperPodio<T>::GetCreateMutex() {
+    return mMultiFactory->GetCreateMutex();
+}
 #endif // JANA2_HAVE_PODIO
 
 
@@ -0,0 +1,158 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JException.h>
+#include <JANA/JObject.h>
+#include <JANA/Utils/JResettable.h>
+#include <JANA/Utils/JTypeInfo.h>
+
+#include <memory>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+/// JSoA<Schema> is a table whose columns each live in their own contiguous std::vector, so that a loop over one
+/// field of every row touches nothing but that field. This is the "structure of arrays" layout which compilers can
+/// vectorize, as opposed to JFactoryT<T>'s vector of pointers to individually allocated objects.
+///
+/// A Schema is a plain struct which lists the column types, an enum naming the column indices, and the column
+/// names, in the same order:
+///
+///     struct HitSchema {
+///         using Columns = std::tuple<int, int, double, double>;
+///         enum Column { x, y, E, t };
+///         static constexpr std::array<const char*, 4> names {"x", "y", "E", "t"};
+///     };
+///
+/// Kernels should grab whole columns via column<HitSchema::E>(). Row-at-a-time code can use operator[], which
+/// returns a lightweight proxy, e.g. hits[i].get<HitSchema::E>().
+template <typename Schema>
+class JSoA : public JResettable {
+public:
+    using Columns = typename Schema::Columns;
+    static constexpr size_t ColumnCount = std::tuple_size<Columns>::value;
+    template <size_t I> using ColumnT = typename std::tuple_element<I, Columns>::type;
+
+    static_assert(std::tuple_size<decltype(Schema::names)>::value == ColumnCount,
+                  "Schema::names needs exactly one entry per column");
+
+private:
+    template <typename Tuple> struct VectorsOf;
+    template <typename... Ts> struct VectorsOf<std::tuple<Ts...>> { using type = std::tuple<std::vector<Ts>...>; };
+
+    typename VectorsOf<Columns>::type m_columns;
+    size_t m_size = 0;
+
+    template <typename Fn, size_t... Is>
+    void ForEachColumn(Fn&& fn, std::index_sequence<Is...>) {
+        (fn(std::get<Is>(m_columns)), ...);
+    }
+
+    template <typename Tuple, size_t... Is>
+    void PushBack(Tuple&& values, std::index_sequence<Is...>) {
+        (std::get<Is>(m_columns).push_back(std::get<Is>(std::forward<Tuple>(values))), ...);
+    }
+
+public:
+
+    /// A reference to one row. Only valid as long as the table isn't resized.
+    template <typename TableT>
+    class RowProxy {
+        TableT* m_table;
+        size_t m_row;
+    public:
+        RowProxy(TableT* table, size_t row) : m_table(table), m_row(row) {}
+        template <size_t I> decltype(auto) get() const { return m_table->template column<I>()[m_row]; }
+        size_t index() const { return m_row; }
+    };
+    using Row = RowProxy<JSoA>;
+    using ConstRow = RowProxy<const JSoA>;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    void reserve(size_t capacity) {
+        ForEachColumn([=](auto& col) { col.reserve(capacity); }, std::make_index_sequence<ColumnCount>());
+    }
+
+    void resize(size_t size) {
+        ForEachColumn([=](auto& col) { col.resize(size); }, std::make_index_sequence<ColumnCount>());
+        m_size = size;
+    }
+
+    /// Removes every row, but keeps the columns' capacity
+    void clear() {
+        ForEachColumn([](auto& col) { col.clear(); }, std::make_index_sequence<ColumnCount>());
+        m_size = 0;
+    }
+
+    /// Appends a row. Takes exactly one value per column, in column order.
+    template <typename... Args>
+    void push_back(Args&&... values) {
+        static_assert(sizeof...(Args) == ColumnCount, "push_back() needs exactly one value per column");
+        PushBack(std::forward_as_tuple(std::forward<Args>(values)...), std::make_index_sequence<ColumnCount>());
+        m_size += 1;
+    }
+
+    template <size_t I> std::vector<ColumnT<I>>& column() { return std::get<I>(m_columns); }
+    template <size_t I> const std::vector<ColumnT<I>>& column() const { return std::get<I>(m_columns); }
+
+    template <size_t I> ColumnT<I>* data() { return std::get<I>(m_columns).data(); }
+    template <size_t I> const ColumnT<I>* data() const { return std::get<I>(m_columns).data(); }
+
+    Row operator[](size_t row) { return Row(this, row); }
+    ConstRow operator[](size_t row) const { return ConstRow(this, row); }
+
+    Row at(size_t row) {
+        if (row >= m_size) throw JException("JSoA: Row %zu is out of range (size=%zu)", row, m_size);
+        return Row(this, row);
+    }
+    ConstRow at(size_t row) const {
+        if (row >= m_size) throw JException("JSoA: Row %zu is out of range (size=%zu)", row, m_size);
+        return ConstRow(this, row);
+    }
+
+    /// Called by JFactoryT when the table gets recycled (see JFactory::RECYCLE_OBJECTS)
+    void Release() override { clear(); }
+};
+
+
+/// Presents one row of a JSoA as a JObject, so that JInspector, janaview, JCsvWriter etc. can display it.
+/// These are built on demand, one allocation per row, so keep them out of performance-critical code.
+template <typename Schema>
+class JSoARowView : public JObject {
+    const JSoA<Schema>* m_table;
+    size_t m_row;
+
+    template <size_t... Is>
+    void SummarizeColumns(JObjectSummary& summary, std::index_sequence<Is...>) const {
+        (SummarizeColumn<Is>(summary), ...);
+    }
+
+    template <size_t I>
+    void SummarizeColumn(JObjectSummary& summary) const {
+        using T = typename JSoA<Schema>::template ColumnT<I>;
+        std::ostringstream value;
+        value << m_table->template column<I>()[m_row];
+        summary.add({Schema::names[I], JTypeInfo::builtin_typename<T>(), value.str(), ""});
+    }
+
+public:
+    JSoARowView(const JSoA<Schema>* table, size_t row) : m_table(table), m_row(row) {}
+
+    const std::string className() const override {
+        return JTypeInfo::demangle<Schema>();
+    }
+
+    void Summarize(JObjectSummary& summary) const override {
+        SummarizeColumns(summary, std::make_index_sequence<JSoA<Schema>::ColumnCount>());
+    }
+
+    size_t GetRow() const { return m_row; }
+};
+
+
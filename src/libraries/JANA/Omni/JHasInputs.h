@@ -4,6 +4,7 @@
 
 #pragma once
 #include <JANA/JEvent.h>
+#include <mutex>
 
 namespace jana {
 namespace omni {
@@ -81,7 +82,11 @@ protected:
     template <typename T>
     class Input : public InputBase {
 
-        std::vector<const T*> m_data;
+        JSpan<T> m_span;    // Points straight into the factory, so this is only valid for the current event
+        std::vector<const T*> m_data;  // Only filled in from m_span once somebody asks for the vector
+        bool m_is_data_filled = false;
+        JFactoryHandle<T> m_handle;
+        std::once_flag m_handle_once;
 
     public:
 
@@ -96,32 +101,68 @@ protected:
             Configure(options);
         }
 
-        const std::vector<const T*>& operator()() { return m_data; }
+        const std::vector<const T*>& operator()() {
+            if (!m_is_data_filled) {
+                m_data.assign(m_span.begin(), m_span.end());
+                m_is_data_filled = true;
+            }
+            return m_data;
+        }
+
+        /// Same contents as operator(), but without copying the pointers into a vector
+        const JSpan<T>& GetSpan() const { return m_span; }
 
 
     private:
         friend class JComponentT;
 
+        /// The collection name is fixed by the time the first event arrives, so we bind the handle then.
+        /// Prefetch may run on several threads at once, hence the once_flag.
+        const JFactoryHandle<T>& GetHandle() {
+            std::call_once(m_handle_once, [this]() { m_handle = JFactoryHandle<T>(this->names[0]); });
+            return m_handle;
+        }
+
         void GetCollection(const JEvent& event) {
+            // Never leave a view into the previous event lying around. The vector keeps its capacity.
+            m_span = {};
+            m_data.clear();
+            m_is_data_filled = false;
             auto& level = this->levels[0];
             if (level == event.GetLevel() || level == JEventLevel::None) {
-                m_data = event.Get<T>(this->names[0], !this->is_optional);
+                m_span = event.GetSpan(GetHandle(), !this->is_optional);
             }
             else {
                 if (this->is_optional && !event.HasParent(level)) return;
-                m_data = event.GetParent(level).template Get<T>(this->names[0], !this->is_optional);
+                m_span = event.GetParent(level).GetSpan(GetHandle(), !this->is_optional);
             }
         }
         void PrefetchCollection(const JEvent& event) {
             auto& level = this->levels[0];
-            auto& name = this->names[0];
             if (level == event.GetLevel() || level == JEventLevel::None) {
-                event.Get<T>(name, !this->is_optional);
+                event.GetSpan(GetHandle(), !this->is_optional);
             }
             else {
                 if (this->is_optional && !event.HasParent(level)) return;
-                event.GetParent(level).template Get<T>(name, !this->is_optional);
+                event.GetParent(level).GetSpan(GetHandle(), !this->is_optional);
+            }
+        }
+    };
+
+    /// An Input for the columnar table produced by a JFactorySoA<Schema>
+    template <typename Schema>
+    class SoAInput : public Input<JSoA<Schema>> {
+    public:
+        using Input<JSoA<Schema>>::Input;
+
+        /// The table for the current event. Empty if an optional input is missing.
+        const JSoA<Schema>& operator()() {
+            auto& tables = Input<JSoA<Schema>>::operator()();
+            if (tables.empty()) {
+                static const JSoA<Schema> empty;
+                return empty;
             }
+            return *tables[0];
         }
     };
 
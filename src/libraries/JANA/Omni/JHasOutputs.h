@@ -49,6 +49,34 @@ protected:
     };
 
 
+    /// An Output which inserts a single columnar JSoA<Schema> table, retrievable via JEvent::GetSoA<Schema>()
+    template <typename Schema>
+    class SoAOutput : public OutputBase {
+        std::unique_ptr<JSoA<Schema>> m_data;
+
+    public:
+        SoAOutput(JHasOutputs* owner, std::string default_tag_name="") {
+            owner->RegisterOutput(this);
+            this->collection_names.push_back(default_tag_name);
+            this->type_name = JTypeInfo::demangle<JSoA<Schema>>();
+        }
+
+        JSoA<Schema>& operator()() {
+            if (m_data == nullptr) m_data = std::make_unique<JSoA<Schema>>();
+            return *m_data;
+        }
+
+    protected:
+        void InsertCollection(JEvent& event) override {
+            event.Insert(&operator()(), this->collection_names[0]);
+            m_data.release(); // The event owns it now
+        }
+        void Reset() override {
+            m_data = std::make_unique<JSoA<Schema>>();
+        }
+    };
+
+
 #if JANA2_HAVE_PODIO
     template <typename PodioT>
     class PodioOutput : public OutputBase {
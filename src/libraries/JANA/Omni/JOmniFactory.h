@@ -11,6 +11,7 @@
  */
 
 #include <JANA/JEvent.h>
+#include <JANA/JFactorySoA.h>
 #include <JANA/JMultifactory.h>
 #include <JANA/JVersion.h>
 #include <JANA/Omni/JHasInputs.h>
@@ -70,6 +71,47 @@ public:
     };
 
 
+    /// An Output whose collection is a single columnar JSoA<Schema> table, retrievable via JEvent::GetSoA<Schema>()
+    /// or a SoAInput<Schema>. Tables are recycled, so once their columns have grown, filling them doesn't allocate.
+    template <typename Schema>
+    class SoAOutput : public OutputBase {
+        JFactoryT<JSoA<Schema>>* m_helper = nullptr;
+        JSoA<Schema>* m_data = nullptr;
+
+    public:
+        SoAOutput(JOmniFactory* owner, std::string default_tag_name="") {
+            owner->RegisterOutput(this);
+            this->collection_names.push_back(default_tag_name);
+            this->type_name = JTypeInfo::demangle<JSoA<Schema>>();
+        }
+
+        ~SoAOutput() { delete m_data; }
+
+        JSoA<Schema>& operator()() { return *m_data; }
+
+    private:
+        friend class JOmniFactory;
+
+        void CreateHelperFactory(JOmniFactory& fac) override {
+            fac.DeclareOutput<JSoA<Schema>>(this->collection_names[0]);
+            m_helper = fac.GetHelpers()->template GetFactory<JSoA<Schema>>(this->collection_names[0]);
+            m_helper->SetRecycleFlag(true);
+            EnableJObjectViews(*m_helper);
+        }
+
+        void SetCollection(JOmniFactory& fac) override {
+            fac.SetData<JSoA<Schema>>(this->collection_names[0], {m_data});
+            m_data = nullptr;
+        }
+
+        void Reset() override {
+            // If the last Execute() threw, we still have its table
+            if (m_data == nullptr) m_data = m_helper->Make();
+            m_data->clear();
+        }
+    };
+
+
 #if JANA2_HAVE_PODIO
     template <typename PodioT>
     class PodioOutput : public OutputBase {
@@ -346,4 +388,6 @@ public:
         summary.Add(mfs);
     }
 
+    bool AreInputsDeclared() const override { return true; }
+
 };
@@ -9,12 +9,14 @@
 #include <JANA/JFactoryGenerator.h>
 #include <JANA/JEventUnfolder.h>
 #include <JANA/Utils/JAutoActivator.h>
+#include <JANA/Utils/JTablePrinter.h>
 
 JComponentManager::JComponentManager() {}
 
 JComponentManager::~JComponentManager() {
 
     for (auto* src : m_evt_srces) {
+        src->DoTeardown();
         delete src;
     }
     for (auto* proc : m_evt_procs) {
@@ -38,6 +40,7 @@ void JComponentManager::Init() {
     m_params->SetDefaultParameter("jana:nevents", m_nevents, "Max number of events that sources can emit");
     m_params->SetDefaultParameter("jana:nskip", m_nskip, "Number of events that sources should skip before starting emitting");
     m_params->SetDefaultParameter("autoactivate", m_autoactivate, "List of factories to activate regardless of what the event processors request. Format is typename:tag,typename:tag");
+    m_params->SetDefaultParameter("jana:lazy_factories", m_lazy_factories, "Only instantiate each event's factories once something asks for them, and report which ones were used")->SetIsAdvanced(true);
     m_params->FilterParameters(m_default_tags, "DEFTAG:");
 
     // Look for factories to auto-activate
@@ -95,9 +98,15 @@ void JComponentManager::initialize_components() {
     JFactorySet dummy_fac_set(m_fac_gens);
 
     // Factories
+    auto factory_index = std::make_shared<JFactoryIndex>();
     for (auto* fac : dummy_fac_set.GetAllFactories()) {
         fac->DoInit();
         fac->Summarize(m_summary);
+        factory_index->Add(fac->GetObjectType(), fac->GetTag());
+    }
+    m_factory_index = factory_index;
+    if (m_lazy_factories) {
+        m_factory_registry = std::make_shared<JFactoryRegistry>(m_fac_gens);
     }
 
     // Multifactories
@@ -142,7 +151,14 @@ void JComponentManager::add(JEventUnfolder* unfolder) {
 }
 
 void JComponentManager::configure_event(JEvent& event) {
-    auto factory_set = new JFactorySet(m_fac_gens);
+    auto factory_set = (m_factory_registry == nullptr) ? new JFactorySet(m_fac_gens) : new JFactorySet;
+    if (m_factory_index != nullptr) {
+        factory_set->SetFactoryIndex(m_factory_index);
+    }
+    factory_set->SetRunScopedStore(m_run_scoped_store);
+    if (m_factory_registry != nullptr) {
+        factory_set->SetRegistry(m_factory_registry);
+    }
     event.SetFactorySet(factory_set);
     event.SetDefaultTags(m_default_tags);
     event.GetJCallGraphRecorder()->SetEnabled(m_enable_call_graph_recording);
@@ -150,6 +166,38 @@ void JComponentManager::configure_event(JEvent& event) {
 }
 
 
+void JComponentManager::print_factory_usage_report() {
+    if (m_factory_registry == nullptr) return;
+    const auto& factories = m_factory_registry->GetFactories();
+
+    JTablePrinter table;
+    table.AddColumn("Object name");
+    table.AddColumn("Tag");
+    table.AddColumn("Factory");
+    table.AddColumn("Plugin");
+    table.AddColumn("Used");
+    table.AddColumn("Instances", JTablePrinter::Justify::Right);
+
+    size_t used_count = 0;
+    for (size_t i=0; i<factories.size(); ++i) {
+        const auto& factory = factories[i];
+        bool used = m_factory_registry->IsUsed(i);
+        if (used) used_count += 1;
+        table | factory.object_name | factory.tag | factory.factory_name | factory.plugin_name
+              | (used ? "yes" : "no") | m_factory_registry->GetMaterializedCount(factory.generator);
+    }
+
+    size_t unmaterialized_count = 0;
+    for (size_t gen=0; gen<m_factory_registry->GetGeneratorCount(); ++gen) {
+        if (m_factory_registry->GetMaterializedCount(gen) == 0) unmaterialized_count += 1;
+    }
+
+    auto logger = m_logging->get_logger("JComponentManager");
+    LOG_INFO(logger) << "Factory usage: " << used_count << " of " << factories.size() << " factories were used; "
+                     << unmaterialized_count << " of " << m_factory_registry->GetGeneratorCount()
+                     << " factory generators were never instantiated\n" << table << LOG_END;
+}
+
 
 void JComponentManager::resolve_event_sources() {
 
@@ -9,7 +9,11 @@
 #include <JANA/Services/JParameterManager.h>
 #include <JANA/Status/JComponentSummary.h>
 #include <JANA/Services/JServiceLocator.h>
+#include <JANA/Utils/JFactoryIndex.h>
+#include <JANA/Utils/JFactoryRegistry.h>
+#include <JANA/Utils/JRunScopedStore.h>
 
+#include <memory>
 #include <vector>
 
 class JEventProcessor;
@@ -48,6 +52,13 @@ public:
 
     void configure_event(JEvent& event);
 
+    /// Only set if jana:lazy_factories is enabled
+    std::shared_ptr<const JFactoryRegistry> get_factory_registry() const { return m_factory_registry; }
+    std::shared_ptr<JRunScopedStore> get_run_scoped_store() const { return m_run_scoped_store; }
+
+    /// Logs which factories were used over the course of the run, if jana:lazy_factories is enabled
+    void print_factory_usage_report();
+
 private:
     // Sources need:    { typename, pluginname, srcname, status, evtcnt }
     // Processors need: { typename, pluginname, mutexgroup, status, evtcnt }
@@ -74,6 +85,10 @@ private:
     JEventSourceGenerator* m_user_evt_src_gen = nullptr;
 
     JComponentSummary m_summary;
+    std::shared_ptr<const JFactoryIndex> m_factory_index;  // Shared by every event's JFactorySet
+    bool m_lazy_factories = false;
+    std::shared_ptr<const JFactoryRegistry> m_factory_registry;  // Shared by every event's JFactorySet, if lazy
+    std::shared_ptr<JRunScopedStore> m_run_scoped_store = std::make_shared<JRunScopedStore>();  // Shared by every event's JFactorySet
 };
 
 
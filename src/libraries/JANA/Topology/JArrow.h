@@ -59,7 +59,7 @@ public:
     }
 
     // TODO: Get rid of me
-    void set_chunksize(size_t chunksize) {
+    virtual void set_chunksize(size_t chunksize) {
         std::lock_guard<std::mutex> lock(m_arrow_mutex);
         m_chunksize = chunksize;
     }
@@ -93,11 +93,19 @@ public:
     // TODO: Make no longer virtual
     virtual size_t get_pending();
 
+    /// Like get_pending(), but never locks any queue, so the result may be slightly stale.
+    /// Meant for scheduling heuristics, which run on every checkout.
+    virtual size_t get_pending_hint();
+
     // TODO: Get rid of me
     virtual size_t get_threshold();
 
     virtual void set_threshold(size_t /* threshold */);
 
+    /// Returns something a worker can park on when this arrow comes back with ComeBackLater, so that
+    /// it wakes as soon as new input arrives. nullptr means the worker should just sleep instead.
+    virtual JWaitObject* get_wait_object();
+
     void attach(JArrow* downstream) {
         m_listeners.push_back(downstream);
     };
@@ -122,6 +130,7 @@ struct Data {
 };
 
 struct PlaceRefBase {
+    JArrow* parent = nullptr;
     void* place_ref = nullptr;
     bool is_queue = true;
     bool is_input = false;
@@ -129,8 +138,10 @@ struct PlaceRefBase {
     size_t max_item_count = 1;
 
     virtual size_t get_pending() { return 0; }
+    virtual size_t get_pending_hint() { return 0; }
     virtual size_t get_threshold() { return 0; }
     virtual void set_threshold(size_t) {}
+    virtual JWaitObject* get_wait_object() { return nullptr; }
 };
 
 template <typename T>
@@ -139,11 +150,13 @@ struct PlaceRef : public PlaceRefBase {
     PlaceRef(JArrow* parent) {
         assert(parent != nullptr);
         parent->attach(this);
+        this->parent = parent;
     }
 
     PlaceRef(JArrow* parent, bool is_input, size_t min_item_count, size_t max_item_count) {
         assert(parent != nullptr);
         parent->attach(this);
+        this->parent = parent;
         this->is_input = is_input;
         this->min_item_count = min_item_count;
         this->max_item_count = max_item_count;
@@ -153,6 +166,7 @@ struct PlaceRef : public PlaceRefBase {
         assert(parent != nullptr);
         assert(queue != nullptr);
         parent->attach(this);
+        this->parent = parent;
         this->place_ref = queue;
         this->is_queue = true;
         this->is_input = is_input;
@@ -164,6 +178,7 @@ struct PlaceRef : public PlaceRefBase {
         assert(parent != nullptr);
         assert(pool != nullptr);
         parent->attach(this);
+        this->parent = parent;
         this->place_ref = pool;
         this->is_queue = false;
         this->is_input = is_input;
@@ -192,6 +207,15 @@ struct PlaceRef : public PlaceRefBase {
         return 0;
     }
 
+    size_t get_pending_hint() override {
+        assert(place_ref != nullptr);
+        if (is_input && is_queue) {
+            auto queue = static_cast<JMailbox<T*>*>(place_ref);
+            return queue->size_hint();
+        }
+        return 0;
+    }
+
     size_t get_threshold() override {
         assert(place_ref != nullptr);
         if (is_input && is_queue) {
@@ -209,20 +233,42 @@ struct PlaceRef : public PlaceRefBase {
         }
     }
 
+    JWaitObject* get_wait_object() override {
+        if (place_ref == nullptr) return nullptr;
+        if (is_queue) {
+            return &static_cast<JMailbox<T*>*>(place_ref)->get_wait_object();
+        }
+        return &static_cast<JPool<T>*>(place_ref)->get_wait_object();
+    }
+
     bool pull(Data<T>& data) {
+        return pull(data, min_item_count, max_item_count);
+    }
+
+    /// Like pull(data), except that the item counts are supplied by the caller. This lets an arrow
+    /// size one side of its execute() to whatever the other side managed to obtain.
+    bool pull(Data<T>& data, size_t min_count, size_t max_count) {
         assert(place_ref != nullptr);
+        assert(max_count <= JANA2_ARROWDATA_MAX_SIZE);
         if (is_input) { // Actually pull the data
             if (is_queue) {
                 auto queue = static_cast<JMailbox<T*>*>(place_ref);
-                data.item_count = queue->pop_and_reserve(data.items.data(), min_item_count, max_item_count, data.location_id);
+                data.item_count = queue->pop_and_reserve(data.items.data(), min_count, max_count, data.location_id);
+                if (data.item_count < min_count && queue->is_work_stealing_enabled()) {
+                    // Local queue has run dry, so try to steal from a neighboring location
+                    data.item_count = queue->steal_and_reserve(data.items.data(), min_count, max_count, data.location_id);
+                    if (data.item_count > 0 && parent != nullptr) {
+                        parent->get_metrics().update_steal_count(data.item_count);
+                    }
+                }
                 data.reserve_count = data.item_count;
-                return (data.item_count >= min_item_count);
+                return (data.item_count >= min_count);
             }
             else {
                 auto pool = static_cast<JPool<T>*>(place_ref);
-                data.item_count = pool->pop(data.items.data(), min_item_count, max_item_count, data.location_id);
+                data.item_count = pool->pop(data.items.data(), min_count, max_count, data.location_id);
                 data.reserve_count = 0;
-                return (data.item_count >= min_item_count);
+                return (data.item_count >= min_count);
             }
         }
         else {
@@ -230,8 +276,8 @@ struct PlaceRef : public PlaceRefBase {
                 // Reserve a space on the output queue
                 data.item_count = 0;
                 auto queue = static_cast<JMailbox<T*>*>(place_ref);
-                data.reserve_count = queue->reserve(min_item_count, max_item_count, data.location_id);
-                return (data.reserve_count >= min_item_count);
+                data.reserve_count = queue->reserve(min_count, max_count, data.location_id);
+                return (data.reserve_count >= min_count);
             }
             else {
                 // No need to reserve on pool -- either there is space or limit_events_in_flight=false
@@ -283,6 +329,16 @@ inline size_t JArrow::get_pending() {
     return sum;
 }
 
+inline size_t JArrow::get_pending_hint() {
+    // Arrows which manage their own queues instead of registering places only have get_pending()
+    if (m_places.empty()) return get_pending();
+    size_t sum = 0;
+    for (PlaceRefBase* place : m_places) {
+        sum += place->get_pending_hint();
+    }
+    return sum;
+}
+
 inline size_t JArrow::get_threshold() {
     size_t result = -1;
     for (PlaceRefBase* place : m_places) {
@@ -298,4 +354,11 @@ inline void JArrow::set_threshold(size_t threshold) {
     }
 }
 
-
+inline JWaitObject* JArrow::get_wait_object() {
+    for (PlaceRefBase* place : m_places) {
+        if (place->is_input) {
+            return place->get_wait_object();
+        }
+    }
+    return nullptr;
+}
@@ -25,6 +25,7 @@ private:
     duration_t m_last_latency;
     duration_t m_total_queue_latency;
     duration_t m_last_queue_latency;
+    size_t m_total_steal_count;  // Messages this arrow pulled from another location's queue
 
 
     // TODO: We might want to add a timestamp, so that
@@ -44,6 +45,7 @@ public:
         m_last_latency = duration_t::zero();
         m_total_queue_latency = duration_t::zero();
         m_last_queue_latency = duration_t::zero();
+        m_total_steal_count = 0;
         m_mutex.unlock();
     }
 
@@ -64,6 +66,7 @@ public:
         m_total_latency += other.m_total_latency;
         m_total_queue_latency += other.m_total_queue_latency;
         m_last_queue_latency = other.m_last_queue_latency;
+        m_total_steal_count += other.m_total_steal_count;
 
         other.m_last_status = Status::NotRunYet;
         other.m_total_message_count = 0;
@@ -74,6 +77,7 @@ public:
         other.m_last_latency = duration_t::zero();
         other.m_total_queue_latency = duration_t::zero();
         other.m_last_queue_latency = duration_t::zero();
+        other.m_total_steal_count = 0;
         other.m_mutex.unlock();
         m_mutex.unlock();
     };
@@ -94,6 +98,7 @@ public:
         m_last_queue_visits = other.m_last_queue_visits;
         m_total_queue_latency += other.m_total_queue_latency;
         m_last_queue_latency = other.m_last_queue_latency;
+        m_total_steal_count += other.m_total_steal_count;
         other.m_mutex.unlock();
         m_mutex.unlock();
     };
@@ -153,6 +158,16 @@ public:
         m_mutex.unlock();
     }
 
+    void update_steal_count(size_t steal_count_delta) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_total_steal_count += steal_count_delta;
+    }
+
+    size_t get_total_steal_count() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_total_steal_count;
+    }
+
     size_t get_total_message_count() {
         std::lock_guard<std::mutex> lock(m_mutex);
         return m_total_message_count;
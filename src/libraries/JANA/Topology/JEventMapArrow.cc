@@ -32,13 +32,16 @@ void JEventMapArrow::process(Event* event, bool& success, JArrowMetrics::Status&
     
 
     LOG_DEBUG(m_logger) << "JEventMapArrow '" << get_name() << "': Starting event# " << (*event)->GetEventNumber() << LOG_END;
+    // Only the source which emitted this event gets to preprocess it
+    JEventSource* emitting_source = (*event)->GetJEventSource();
     for (JEventSource* source : m_sources) {
+        if (source != emitting_source) continue;
         JCallGraphEntryMaker cg_entry(*(*event)->GetJCallGraphRecorder(), source->GetTypeName()); // times execution until this goes out of scope
-        source->Preprocess(**event);
+        source->DoPreprocess(**event);
     }
     for (JEventUnfolder* unfolder : m_unfolders) {
         JCallGraphEntryMaker cg_entry(*(*event)->GetJCallGraphRecorder(), unfolder->GetTypeName()); // times execution until this goes out of scope
-        unfolder->Preprocess(**event);
+        unfolder->DoPreprocess(**event);
     }
     LOG_DEBUG(m_logger) << "JEventMapArrow '" << get_name() << "': Finished event# " << (*event)->GetEventNumber() << LOG_END;
     success = true;
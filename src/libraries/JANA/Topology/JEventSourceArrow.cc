@@ -8,52 +8,116 @@
 #include <JANA/Topology/JEventSourceArrow.h>
 #include <JANA/Utils/JEventPool.h>
 
+#include <algorithm>
+#include <array>
+
 
 
 JEventSourceArrow::JEventSourceArrow(std::string name,
                                      std::vector<JEventSource*> sources,
                                      EventQueue* output_queue,
-                                     JEventPool* pool
+                                     JEventPool* pool,
+                                     size_t max_concurrent_sources
                                      )
-    : JPipelineArrow(name, false, true, false, nullptr, output_queue, pool), m_sources(sources) {
+    : JPipelineArrow(name, max_concurrent_sources > 1, true, false, nullptr, output_queue, pool),
+      m_sources(sources),
+      m_max_concurrent_sources(std::max<size_t>(1, max_concurrent_sources)),
+      m_busy(sources.size(), false) {
 }
 
 
-void JEventSourceArrow::process(Event* event, bool& success, JArrowMetrics::Status& arrow_status) {
+size_t JEventSourceArrow::checkout_source(bool& finished) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    finished = false;
 
-    // If there are no sources available then we are automatically finished.
-    if (m_sources.empty()) {
-        success = false;
-        arrow_status = JArrowMetrics::Status::Finished;
-        return;
+    // Prefer a source which is already open and which nobody else is reading
+    for (size_t i=0; i<m_open_sources.size(); ++i) {
+        size_t candidate = m_open_sources[(m_next_open_source + i) % m_open_sources.size()];
+        if (!m_busy[candidate]) {
+            m_next_open_source = (m_next_open_source + i + 1) % m_open_sources.size();
+            m_busy[candidate] = true;
+            return candidate;
+        }
     }
+    // Otherwise open the next one, if we are allowed to
+    if (m_open_sources.size() < m_max_concurrent_sources && m_next_source < m_sources.size()) {
+        size_t source = m_next_source++;
+        m_open_sources.push_back(source);
+        m_busy[source] = true;
+        return source;
+    }
+    // Every open source is busy, or there are none left at all
+    finished = m_open_sources.empty();
+    return npos;
+}
+
+
+void JEventSourceArrow::checkin_source(size_t source, bool is_finished) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_busy[source] = false;
+    if (is_finished) {
+        auto it = std::find(m_open_sources.begin(), m_open_sources.end(), source);
+        if (it != m_open_sources.end()) {
+            m_open_sources.erase(it);
+        }
+        m_next_open_source = 0;
+    }
+}
 
-    while (m_current_source < m_sources.size()) {
 
-        auto source_status = m_sources[m_current_source]->DoNext(*event);
+size_t JEventSourceArrow::process_chunk(Event** events, size_t count, bool* successes, JArrowMetrics::Status& arrow_status) {
 
-        if (source_status == JEventSource::Result::FailureFinished) {
-            m_current_source++;
-            // TODO: Adjust nskip and nevents for the new source
+    std::array<JEventSource::Result, JANA2_ARROWDATA_MAX_SIZE> results;
+    size_t done = 0;
+
+    while (done < count) {
+
+        bool finished;
+        size_t source = checkout_source(finished);
+        if (finished) {
+            arrow_status = JArrowMetrics::Status::Finished;
+            return done;
+        }
+        if (source == npos) {
+            arrow_status = JArrowMetrics::Status::ComeBackLater;
+            return done;
+        }
+
+        size_t used;
+        try {
+            used = m_sources[source]->DoNextBatch(events + done, count - done, results.data());
+        }
+        catch (...) {
+            checkin_source(source, false);
+            throw;
+        }
+        auto last_result = results[used - 1];
+        checkin_source(source, last_result == JEventSource::Result::FailureFinished);
+
+        for (size_t i = 0; i < used; ++i) {
+            successes[done + i] = (results[i] == JEventSource::Result::Success);
+        }
+        if (last_result == JEventSource::Result::FailureFinished) {
+            // That last event is still empty, so move on to the next source with it
+            done += used - 1;
         }
-        else if (source_status == JEventSource::Result::FailureTryAgain){
-            // This JEventSource isn't finished yet, so we obtained either Success or TryAgainLater
-            success = false;
+        else if (last_result == JEventSource::Result::FailureTryAgain) {
+            // This JEventSource isn't finished yet, but it doesn't have anything for us right now
             arrow_status = JArrowMetrics::Status::ComeBackLater;
-            return;
+            return done + used;
         }
         else {
-            success = true;
-            arrow_status = JArrowMetrics::Status::KeepGoing;
-            return;
+            done += used;
         }
     }
-    success = false;
-    arrow_status = JArrowMetrics::Status::Finished;
+    arrow_status = JArrowMetrics::Status::KeepGoing;
+    return done;
 }
 
 void JEventSourceArrow::initialize() {
-    // We initialize everything immediately, but don't open any resources until we absolutely have to; see process(): source->DoNext()
+    // We initialize everything immediately, but don't open any resources until we absolutely have to; see process_chunk(): source->DoNextBatch()
     for (JEventSource* source : m_sources) {
         source->DoInit();
     }
@@ -1,24 +1,44 @@
-
 // Copyright 2020, Jefferson Science Associates, LLC.
 // Subject to the terms in the LICENSE file found in the top-level directory.
 
 #pragma once
 #include <JANA/Topology/JPipelineArrow.h>
+#include <mutex>
 
 using Event = std::shared_ptr<JEvent>;
 using EventQueue = JMailbox<Event*>;
 class JEventPool;
 
+/// JEventSourceArrow pulls events out of its JEventSources. With max_concurrent_sources == 1 (the default), it reads
+/// them one after another on a single worker, exactly as before. With more, the arrow is parallel: up to that many
+/// sources are open at once, and each worker grabs whichever open source isn't busy, opening the next one as the
+/// current ones run dry. Each source is still only ever read by one thread at a time. Events from different sources
+/// interleave arbitrarily.
+///
+/// A whole chunk of events is handed to one source at a time via JEventSource::DoNextBatch(), so that the source only
+/// gets locked once per chunk, and sources which implement EmitBatch() can decode a whole block in one go.
 class JEventSourceArrow : public JPipelineArrow<JEventSourceArrow, Event> {
 private:
     std::vector<JEventSource*> m_sources;
-    size_t m_current_source = 0;
+    size_t m_max_concurrent_sources = 1;
+
+    std::mutex m_mutex;                  // Protects everything below
+    size_t m_next_source = 0;            // The next source which hasn't been opened yet
+    std::vector<size_t> m_open_sources;  // Sources which have been opened and aren't finished
+    std::vector<bool> m_busy;            // Indexed like m_sources. Whether some worker is reading it right now.
+    size_t m_next_open_source = 0;       // Round-robin cursor into m_open_sources
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    size_t checkout_source(bool& finished);
+    void checkin_source(size_t source, bool is_finished);
 
 public:
-    JEventSourceArrow(std::string name, std::vector<JEventSource*> sources, EventQueue* output_queue, JEventPool* pool);
+    JEventSourceArrow(std::string name, std::vector<JEventSource*> sources, EventQueue* output_queue, JEventPool* pool,
+                      size_t max_concurrent_sources=1);
     void initialize() final;
     void finalize() final;
 
-    void process(Event* event, bool& success, JArrowMetrics::Status& status);
+    /// Hides JPipelineArrow::process_chunk(), so there is no per-event process(). Reads each chunk via DoNextBatch().
+    size_t process_chunk(Event** events, size_t count, bool* successes, JArrowMetrics::Status& status);
 };
 
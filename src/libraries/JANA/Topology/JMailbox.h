@@ -5,7 +5,13 @@
 #pragma once
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <vector>
 #include <JANA/Utils/JCpuInfo.h>
+#include <JANA/Topology/JRingBuffer.h>
+#include <JANA/Utils/JWaitObject.h>
 #include <JANA/Services/JLoggingService.h>
 #include <JANA/JEvent.h>
 
@@ -24,11 +30,20 @@
 /// the physical LocalQueue corresponding to their location. Locations prevent events from crossing 
 /// NUMA domains as they get picked up by different JWorker threads.
 ///
-/// \tparam T must be moveable. Usually this is unique_ptr<JEvent>.
+/// Each LocalQueue has two interchangeable backends, chosen when the JMailbox is constructed:
+///   - The default backend is a std::deque guarded by a mutex.
+///   - The lock-free backend is a bounded MPMC ring buffer (JRingBuffer) plus an atomic
+///     `occupancy` counter which tracks queue size + reserved count. Reservations become a
+///     single CAS on `occupancy`, and pushes/pops become a single CAS on the ring's cursors.
+///     Because nothing is locked, pop() never reports Status::Congested. Unreserved pushes
+///     may exceed the ring's physical capacity; whatever doesn't fit goes to a mutex-guarded
+///     overflow list, which pops drain once the ring can't satisfy them.
+/// Both backends honor the same reserve/push_and_unreserve/pop_and_reserve contract.
+///
+/// When work stealing is enabled, a worker whose LocalQueue is empty may call steal_and_reserve()
+/// to take items from the other locations, visiting the nearest (by NUMA distance) first.
 ///
-/// Improvements:
-///   1. Pad LocalQueue
-///   2. Enable work stealing
+/// \tparam T must be moveable. Usually this is unique_ptr<JEvent>.
 
 
 class JQueue {
@@ -36,29 +51,64 @@ protected:
     size_t m_capacity;
     size_t m_locations_count;
     bool m_enable_work_stealing = false;
+    bool m_enable_lock_free = false;
     int m_id = 0;
     JLogger m_logger;
+    std::vector<std::vector<size_t>> m_steal_order; // For each location, the other locations ordered nearest-first
+    JWaitObject m_wait_object; // Notified whenever items are pushed, so that starved workers can park on it
 
 public:
     inline size_t get_threshold() { return m_capacity; }
     inline size_t get_locations_count() { return m_locations_count; }
     inline bool is_work_stealing_enabled() { return m_enable_work_stealing; }
+    inline bool is_lock_free_enabled() { return m_enable_lock_free; }
     void set_logger(JLogger logger) { m_logger = logger; }
     void set_id(int id) { m_id = id; }
+    JWaitObject& get_wait_object() { return m_wait_object; }
 
 
-    inline JQueue(size_t threshold, size_t locations_count, bool enable_work_stealing)
-        : m_capacity(threshold), m_locations_count(locations_count), m_enable_work_stealing(enable_work_stealing) {}
+    inline JQueue(size_t threshold, size_t locations_count, bool enable_work_stealing, bool enable_lock_free=false)
+        : m_capacity(threshold), m_locations_count(locations_count), m_enable_work_stealing(enable_work_stealing), m_enable_lock_free(enable_lock_free) {
+
+        // Absent any distance information, each location steals from its successors in round-robin order
+        m_steal_order.resize(locations_count);
+        for (size_t loc=0; loc<locations_count; ++loc) {
+            for (size_t offset=1; offset<locations_count; ++offset) {
+                m_steal_order[loc].push_back((loc + offset) % locations_count);
+            }
+        }
+    }
     virtual ~JQueue() = default;
+
+    /// set_location_distances() reorders each location's steal victims so that the nearest ones are
+    /// visited first. distances[a][b] is any relative measure, e.g. the NUMA distance between the
+    /// domains that locations a and b live on. Ties keep round-robin order. Call before running.
+    void set_location_distances(const std::vector<std::vector<size_t>>& distances) {
+        if (distances.size() != m_locations_count) return;
+        for (size_t loc=0; loc<m_locations_count; ++loc) {
+            auto& victims = m_steal_order[loc];
+            const auto& row = distances[loc];
+            if (row.size() != m_locations_count) continue;
+            std::stable_sort(victims.begin(), victims.end(),
+                             [&](size_t lhs, size_t rhs) { return row[lhs] < row[rhs]; });
+        }
+    }
+
+    const std::vector<size_t>& get_steal_order(size_t location_id) const { return m_steal_order.at(location_id); }
 };
 
 template <typename T>
 class JMailbox : public JQueue {
 
-    struct LocalQueue {
+    struct alignas(JANA2_CACHE_LINE_BYTES) LocalQueue {
         std::mutex mutex;
         std::deque<T> queue;
         size_t reserved_count = 0;
+        std::atomic<size_t> queued_count {0}; // Copy of queue.size(), so that it can be read without the mutex
+
+        // Lock-free backend only. `queue`, `mutex`, and `queued_count` then hold the overflow
+        std::unique_ptr<JRingBuffer<T>> ring;
+        std::atomic<size_t> occupancy {0}; // = ring->size() + overflow size + reserved count
     };
 
     // TODO: Copy these params into DLMB for better locality
@@ -83,18 +133,31 @@ public:
     /// threshold: the (soft) maximum number of items in the queue at any time
     /// locations_count: the number of locations. More locations = better NUMA performance, worse load balancing
     /// enable_work_stealing: allow events to cross locations only when no other work is available. Improves aforementioned load balancing.
-    JMailbox(size_t threshold=100, size_t locations_count=1, bool enable_work_stealing=false)
-        : JQueue(threshold, locations_count, enable_work_stealing) {
+    /// enable_lock_free: use a lock-free ring buffer for each LocalQueue instead of a mutex-guarded deque.
+    JMailbox(size_t threshold=100, size_t locations_count=1, bool enable_work_stealing=false, bool enable_lock_free=false)
+        : JQueue(threshold, locations_count, enable_work_stealing, enable_lock_free) {
 
         m_queues = std::unique_ptr<LocalQueue[]>(new LocalQueue[locations_count]);
+        if (m_enable_lock_free) {
+            for (size_t i=0; i<locations_count; ++i) {
+                // Leave headroom so that callers who push without reserving don't immediately block
+                m_queues[i].ring = std::make_unique<JRingBuffer<T>>(2*threshold);
+            }
+        }
     }
 
     virtual ~JMailbox() {
         //delete [] m_queues;
     }
 
-    // We can do this (for now) because we use a deque underneath, so threshold is 'soft'
-    inline void set_threshold(size_t threshold) { m_capacity = threshold; }
+    // We can do this (for now) because we use a deque underneath, so threshold is 'soft'.
+    // The lock-free ring buffer can't grow, so there the threshold is clamped to its physical capacity.
+    inline void set_threshold(size_t threshold) {
+        if (m_enable_lock_free) {
+            threshold = std::min(threshold, m_queues[0].ring->capacity());
+        }
+        m_capacity = threshold;
+    }
 
     /// size() counts the number of items in the queue across all locations
     /// This should be used sparingly because it will mess up a bunch of caches.
@@ -102,6 +165,10 @@ public:
     size_t size() {
         size_t result = 0;
         for (size_t i = 0; i<m_locations_count; ++i) {
+            if (m_enable_lock_free) {
+                result += size_lock_free(m_queues[i]);
+                continue;
+            }
             std::lock_guard<std::mutex> lock(m_queues[i].mutex);
             result += m_queues[i].queue.size();
         }
@@ -111,9 +178,26 @@ public:
     /// size(location_id) counts the number of items in the queue for a particular location
     /// Meant to be used by Scheduler::next_assignment() and measure_perf(), eventually
     size_t size(size_t location_id) {
+        if (m_enable_lock_free) return size_lock_free(m_queues[location_id]);
+        std::lock_guard<std::mutex> lock(m_queues[location_id].mutex);
         return m_queues[location_id].queue.size();
     }
 
+    /// size_hint() is like size(), except that it never locks. The result may be slightly stale, so it is
+    /// only good for heuristics such as JSchedulerPolicy, not for deciding whether the queue is drained.
+    size_t size_hint() {
+        size_t result = 0;
+        for (size_t i = 0; i<m_locations_count; ++i) {
+            result += size_hint(i);
+        }
+        return result;
+    }
+
+    size_t size_hint(size_t location_id) {
+        if (m_enable_lock_free) return size_lock_free(m_queues[location_id]);
+        return m_queues[location_id].queued_count.load(std::memory_order_relaxed);
+    }
+
     /// reserve(requested_count) keeps our queues bounded in size. The caller should
     /// reserve their desired chunk size on the output queue first. The output
     /// queue will return a reservation which is less than or equal to requested_count.
@@ -124,6 +208,7 @@ public:
     size_t reserve(size_t requested_count, size_t location_id = 0) {
 
         LocalQueue& mb = m_queues[location_id];
+        if (m_enable_lock_free) return reserve_lock_free(mb, 0, requested_count);
         std::lock_guard<std::mutex> lock(mb.mutex);
         size_t doable_count = m_capacity - mb.queue.size() - mb.reserved_count;
         if (doable_count > 0) {
@@ -141,13 +226,28 @@ public:
     Status push(std::vector<T>& buffer, size_t reserved_count = 0, size_t location_id = 0) {
 
         auto& mb = m_queues[location_id];
-        std::lock_guard<std::mutex> lock(mb.mutex);
-        mb.reserved_count -= reserved_count;
-        for (const T& t : buffer) {
-             mb.queue.push_back(std::move(t));
+        if (m_enable_lock_free) {
+            size_t count = buffer.size();
+            push_lock_free(mb, buffer.data(), count);
+            buffer.clear();
+            adjust_occupancy(mb, count, reserved_count);
+            if (count > 0) m_wait_object.notify();
+            return (size_lock_free(mb) > m_capacity) ? Status::Full : Status::Ready;
+        }
+        size_t size;
+        bool pushed_any = !buffer.empty();
+        {
+            std::lock_guard<std::mutex> lock(mb.mutex);
+            mb.reserved_count -= reserved_count;
+            for (const T& t : buffer) {
+                 mb.queue.push_back(std::move(t));
+            }
+            size = mb.queue.size();
+            update_queued_count(mb);
         }
         buffer.clear();
-        if (mb.queue.size() > m_capacity) {
+        if (pushed_any) m_wait_object.notify();
+        if (size > m_capacity) {
             return Status::Full;
         }
         return Status::Ready;
@@ -160,6 +260,11 @@ public:
     Status pop(std::vector<T>& buffer, size_t requested_count, size_t location_id = 0) {
 
         auto& mb = m_queues[location_id];
+        if (m_enable_lock_free) {
+            size_t nitems = pop_lock_free(mb, 0, requested_count, [&](size_t, T&& t) { buffer.push_back(std::move(t)); });
+            mb.occupancy.fetch_sub(nitems, std::memory_order_acq_rel);
+            return status_from_size(size_lock_free(mb));
+        }
         if (!mb.mutex.try_lock()) {
             return Status::Congested;
         }
@@ -170,6 +275,7 @@ public:
             mb.queue.pop_front();
         }
         auto size = mb.queue.size();
+        update_queued_count(mb);
         mb.mutex.unlock();
         if (size >= m_capacity) {
             return Status::Full;
@@ -185,6 +291,14 @@ public:
 
         success = false;
         auto& mb = m_queues[location_id];
+        if (m_enable_lock_free) {
+            if (pop_lock_free(mb, 1, 1, [&](size_t, T&& t) { item = std::move(t); }) == 0) {
+                return Status::Empty;
+            }
+            success = true;
+            mb.occupancy.fetch_sub(1, std::memory_order_acq_rel);
+            return (size_lock_free(mb) > 0) ? Status::Ready : Status::Empty;
+        }
         if (!mb.mutex.try_lock()) {
             return Status::Congested;
         }
@@ -193,6 +307,7 @@ public:
             item = std::move(mb.queue.front());
             mb.queue.pop_front();
             success = true;
+            update_queued_count(mb);
             mb.mutex.unlock();
             return Status::Ready;
         }
@@ -200,6 +315,7 @@ public:
             item = std::move(mb.queue.front());
             mb.queue.pop_front();
             success = true;
+            update_queued_count(mb);
             mb.mutex.unlock();
             return Status::Empty;
         }
@@ -212,31 +328,57 @@ public:
 
     bool try_push(T* buffer, size_t count, size_t location_id = 0) {
         auto& mb = m_queues[location_id];
-        std::lock_guard<std::mutex> lock(mb.mutex);
-        if (mb.queue.size() + count > m_capacity) return false;
-        for (size_t i=0; i<count; ++i) {
-             mb.queue.push_back(buffer[i]);
-             buffer[i] = nullptr;
+        if (m_enable_lock_free) {
+            if (reserve_lock_free(mb, count, count) != count) return false;
+            push_lock_free(mb, buffer, count);
+            for (size_t i=0; i<count; ++i) {
+                buffer[i] = nullptr;
+            }
+            if (count > 0) m_wait_object.notify();
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mb.mutex);
+            if (mb.queue.size() + count > m_capacity) return false;
+            for (size_t i=0; i<count; ++i) {
+                 mb.queue.push_back(buffer[i]);
+                 buffer[i] = nullptr;
+            }
+            update_queued_count(mb);
         }
+        if (count > 0) m_wait_object.notify();
         return true;
     }
 
     void push_and_unreserve(T* buffer, size_t count, size_t reserved_count = 0, size_t location_id = 0) {
 
         auto& mb = m_queues[location_id];
-        std::lock_guard<std::mutex> lock(mb.mutex);
-        assert(reserved_count <= mb.reserved_count);
-        assert(mb.queue.size() + count <= m_capacity);
-        mb.reserved_count -= reserved_count;
-        for (size_t i=0; i<count; ++i) {
-             mb.queue.push_back(buffer[i]);
-             buffer[i] = nullptr;
+        if (m_enable_lock_free) {
+            push_and_unreserve_lock_free(mb, buffer, count, reserved_count);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mb.mutex);
+            assert(reserved_count <= mb.reserved_count);
+            assert(mb.queue.size() + count <= m_capacity);
+            mb.reserved_count -= reserved_count;
+            for (size_t i=0; i<count; ++i) {
+                 mb.queue.push_back(buffer[i]);
+                 buffer[i] = nullptr;
+            }
+            update_queued_count(mb);
         }
+        if (count > 0) m_wait_object.notify();
     }
 
     size_t pop(T* buffer, size_t min_requested_count, size_t max_requested_count, size_t location_id = 0) {
 
         auto& mb = m_queues[location_id];
+        if (m_enable_lock_free) {
+            size_t nitems = pop_lock_free(mb, min_requested_count, max_requested_count, [&](size_t i, T&& t) { buffer[i] = std::move(t); });
+            mb.occupancy.fetch_sub(nitems, std::memory_order_acq_rel);
+            return nitems;
+        }
         std::lock_guard<std::mutex> lock(mb.mutex);
 
         if (mb.queue.size() < min_requested_count) return 0;
@@ -247,12 +389,17 @@ public:
             buffer[i] = mb.queue.front();
             mb.queue.pop_front();
         }
+        update_queued_count(mb);
         return nitems;
     }
 
     size_t pop_and_reserve(T* buffer, size_t min_requested_count, size_t max_requested_count, size_t location_id = 0) {
 
         auto& mb = m_queues[location_id];
+        if (m_enable_lock_free) {
+            // Items move from 'queued' to 'reserved', so occupancy is unchanged
+            return pop_lock_free(mb, min_requested_count, max_requested_count, [&](size_t i, T&& t) { buffer[i] = std::move(t); });
+        }
         std::lock_guard<std::mutex> lock(mb.mutex);
 
         if (mb.queue.size() < min_requested_count) return 0;
@@ -264,12 +411,14 @@ public:
             buffer[i] = mb.queue.front();
             mb.queue.pop_front();
         }
+        update_queued_count(mb);
         return nitems;
     }
 
     size_t reserve(size_t min_requested_count, size_t max_requested_count, size_t location_id) {
 
         LocalQueue& mb = m_queues[location_id];
+        if (m_enable_lock_free) return reserve_lock_free(mb, min_requested_count, max_requested_count);
         std::lock_guard<std::mutex> lock(mb.mutex);
         size_t available_count = m_capacity - mb.queue.size() - mb.reserved_count;
         size_t count = std::min(available_count, max_requested_count);
@@ -280,35 +429,178 @@ public:
         return count;
     };
 
+    /// steal_and_reserve() is the work-stealing counterpart of pop_and_reserve(). It is meant to be called
+    /// only once the caller's own location has come up empty. It visits the other locations nearest-first and
+    /// pops from the first one that can satisfy min_requested_count. The reservation is taken on the caller's
+    /// own location, so the usual push_and_unreserve(..., location_id) afterwards keeps the books balanced.
+    /// Stolen items migrate to the thief's location from then on.
+    size_t steal_and_reserve(T* buffer, size_t min_requested_count, size_t max_requested_count, size_t location_id) {
+
+        if (!m_enable_work_stealing) return 0;
+        for (size_t victim : m_steal_order[location_id]) {
+            // Only a hint, so that we don't reserve for victims which are obviously empty.
+            // pop() checks again under the victim's lock.
+            size_t victim_size = size_hint(victim);
+            if (victim_size == 0 || victim_size < min_requested_count) continue;
+
+            size_t reserved_count = reserve(min_requested_count, max_requested_count, location_id);
+            if (reserved_count == 0) return 0; // No room to hold the stolen items locally
+
+            size_t nitems = pop(buffer, min_requested_count, reserved_count, victim);
+            if (nitems < reserved_count) {
+                unreserve(reserved_count - nitems, location_id);
+            }
+            if (nitems > 0) {
+                LOG_TRACE(m_logger) << "JMailbox: steal_and_reserve(): queue #" << m_id << ", location " << location_id
+                                    << " stole " << nitems << " items from location " << victim << LOG_END;
+                return nitems;
+            }
+        }
+        return 0;
+    }
+
     void unreserve(size_t reserved_count, size_t location_id) {
 
         LocalQueue& mb = m_queues[location_id];
+        if (m_enable_lock_free) {
+            mb.occupancy.fetch_sub(reserved_count, std::memory_order_acq_rel);
+            return;
+        }
         std::lock_guard<std::mutex> lock(mb.mutex);
         assert(reserved_count <= mb.reserved_count);
         mb.reserved_count -= reserved_count;
     };
 
+private:
+
+    /// Must be called with mb.mutex held, after every change to mb.queue
+    void update_queued_count(LocalQueue& mb) {
+        mb.queued_count.store(mb.queue.size(), std::memory_order_relaxed);
+    }
+
+    Status status_from_size(size_t size) {
+        if (size >= m_capacity) {
+            return Status::Full;
+        }
+        else if (size != 0) {
+            return Status::Ready;
+        }
+        return Status::Empty;
+    }
+
+    /// Claims between min_count and max_count slots of occupancy, or none at all
+    size_t reserve_lock_free(LocalQueue& mb, size_t min_count, size_t max_count) {
+        size_t occupancy = mb.occupancy.load(std::memory_order_relaxed);
+        while (true) {
+            size_t available_count = (occupancy < m_capacity) ? (m_capacity - occupancy) : 0;
+            size_t count = std::min(available_count, max_count);
+            if (count == 0 || count < min_count) {
+                return 0;
+            }
+            if (mb.occupancy.compare_exchange_weak(occupancy, occupancy + count, std::memory_order_acq_rel)) {
+                return count;
+            }
+        }
+    }
+
+    /// Pushed items are added to occupancy, released reservations are removed from it
+    void adjust_occupancy(LocalQueue& mb, size_t pushed_count, size_t reserved_count) {
+        if (pushed_count > reserved_count) {
+            mb.occupancy.fetch_add(pushed_count - reserved_count, std::memory_order_acq_rel);
+        }
+        else if (pushed_count < reserved_count) {
+            mb.occupancy.fetch_sub(reserved_count - pushed_count, std::memory_order_acq_rel);
+        }
+    }
+
+    size_t size_lock_free(LocalQueue& mb) {
+        return mb.ring->size() + mb.queued_count.load(std::memory_order_relaxed);
+    }
+
+    /// Moves all `count` items into the ring, or into the overflow list if the ring is physically full.
+    /// The latter only happens when callers push more than they reserved.
+    void push_lock_free(LocalQueue& mb, T* items, size_t count) {
+        while (!mb.ring->try_push(items, count)) {
+            if (mb.ring->size() + count > mb.ring->capacity()) {
+                std::lock_guard<std::mutex> lock(mb.mutex);
+                for (size_t i=0; i<count; ++i) {
+                    mb.queue.push_back(std::move(items[i]));
+                }
+                update_queued_count(mb);
+                return;
+            }
+            // The ring has room, we are just waiting for a consumer to finish moving an item out
+            std::this_thread::yield();
+        }
+    }
+
+    /// Pops from the ring first, and only takes the overflow lock if the ring came up short
+    template <typename SinkT>
+    size_t pop_lock_free(LocalQueue& mb, size_t min_count, size_t max_count, SinkT&& sink) {
+        size_t nitems = mb.ring->try_consume(min_count, max_count, sink);
+        if (nitems == max_count || mb.queued_count.load(std::memory_order_acquire) == 0) {
+            return nitems;
+        }
+        std::lock_guard<std::mutex> lock(mb.mutex);
+        size_t overflow_count = std::min(max_count - nitems, mb.queue.size());
+        if (nitems + overflow_count < min_count) {
+            return nitems;
+        }
+        for (size_t i=0; i<overflow_count; ++i) {
+            sink(nitems + i, std::move(mb.queue.front()));
+            mb.queue.pop_front();
+        }
+        update_queued_count(mb);
+        return nitems + overflow_count;
+    }
+
+    void push_and_unreserve_lock_free(LocalQueue& mb, T* buffer, size_t count, size_t reserved_count) {
+        push_lock_free(mb, buffer, count);
+        for (size_t i=0; i<count; ++i) {
+            buffer[i] = nullptr;
+        }
+        adjust_occupancy(mb, count, reserved_count);
+        if (count > 0) m_wait_object.notify();
+    }
 };
 
 template <>
 inline void JMailbox<std::shared_ptr<JEvent>*>::push_and_unreserve(std::shared_ptr<JEvent>** buffer, size_t count, size_t reserved_count, size_t location_id) {
 
     auto& mb = m_queues[location_id];
-    std::lock_guard<std::mutex> lock(mb.mutex);
-    assert(reserved_count <= mb.reserved_count);
-    assert(mb.queue.size() + count <= m_capacity);
-    mb.reserved_count -= reserved_count;
-    for (size_t i=0; i<count; ++i) {
-        LOG_TRACE(m_logger) << "JMailbox: push_and_unreserve(): queue #" << m_id << ", event #" << buffer[i]->get()->GetEventNumber() << LOG_END;
-        mb.queue.push_back(buffer[i]);
-        buffer[i] = nullptr;
+    if (m_enable_lock_free) {
+        for (size_t i=0; i<count; ++i) {
+            LOG_TRACE(m_logger) << "JMailbox: push_and_unreserve(): queue #" << m_id << ", event #" << buffer[i]->get()->GetEventNumber() << LOG_END;
+        }
+        push_and_unreserve_lock_free(mb, buffer, count, reserved_count);
+        return;
     }
+    {
+        std::lock_guard<std::mutex> lock(mb.mutex);
+        assert(reserved_count <= mb.reserved_count);
+        assert(mb.queue.size() + count <= m_capacity);
+        mb.reserved_count -= reserved_count;
+        for (size_t i=0; i<count; ++i) {
+            LOG_TRACE(m_logger) << "JMailbox: push_and_unreserve(): queue #" << m_id << ", event #" << buffer[i]->get()->GetEventNumber() << LOG_END;
+            mb.queue.push_back(buffer[i]);
+            buffer[i] = nullptr;
+        }
+        update_queued_count(mb);
+    }
+    if (count > 0) m_wait_object.notify();
 } 
 
 template <>
 inline size_t JMailbox<std::shared_ptr<JEvent>*>::pop_and_reserve(std::shared_ptr<JEvent>** buffer, size_t min_requested_count, size_t max_requested_count, size_t location_id) {
 
     auto& mb = m_queues[location_id];
+    if (m_enable_lock_free) {
+        size_t nitems = pop_lock_free(mb, min_requested_count, max_requested_count, [&](size_t i, std::shared_ptr<JEvent>*&& t) { buffer[i] = t; });
+        for (size_t i=0; i<nitems; ++i) {
+            LOG_TRACE(m_logger) << "JMailbox: pop_and_reserve(): queue #" << m_id << ", event #" << buffer[i]->get()->GetEventNumber() << LOG_END;
+        }
+        return nitems;
+    }
     std::lock_guard<std::mutex> lock(mb.mutex);
 
     if (mb.queue.size() < min_requested_count) return 0;
@@ -321,6 +613,7 @@ inline size_t JMailbox<std::shared_ptr<JEvent>*>::pop_and_reserve(std::shared_pt
         LOG_TRACE(m_logger) << "JMailbox: pop_and_reserve(): queue #" << m_id << ", event #" << buffer[i]->get()->GetEventNumber() << LOG_END;
         mb.queue.pop_front();
     }
+    update_queued_count(mb);
     return nitems;
 }
 
@@ -7,6 +7,8 @@
 #include <JANA/Topology/JArrow.h>
 #include <JANA/Topology/JMailbox.h>
 #include <JANA/Topology/JPool.h>
+#include <algorithm>
+#include <array>
 
 template <typename DerivedT, typename MessageT>
 class JPipelineArrow : public JArrow {
@@ -41,6 +43,27 @@ public:
         }
     }
 
+    /// Pipeline arrows move up to `chunksize` messages per execute(), bounded by JANA2_ARROWDATA_MAX_SIZE.
+    void set_chunksize(size_t chunksize) override {
+        JArrow::set_chunksize(chunksize);
+        size_t max_item_count = std::max<size_t>(1, std::min<size_t>(chunksize, JANA2_ARROWDATA_MAX_SIZE));
+        m_input.max_item_count = max_item_count;
+        m_output.max_item_count = max_item_count;
+    }
+
+    /// Calls process() on each message in turn until it asks us to stop. Returns how many messages it got to, and sets
+    /// successes[i] to whether message i goes downstream. Derived arrows can shadow this to handle a chunk all at once.
+    size_t process_chunk(MessageT** messages, size_t count, bool* successes, JArrowMetrics::Status& status) {
+        status = JArrowMetrics::Status::KeepGoing;
+        size_t i = 0;
+        for (; i < count && status == JArrowMetrics::Status::KeepGoing; ++i) {
+            bool process_succeeded = true;
+            static_cast<DerivedT*>(this)->process(messages[i], process_succeeded, status);
+            successes[i] = process_succeeded;
+        }
+        return i;
+    }
+
     void execute(JArrowMetrics& result, size_t location_id) final {
 
         auto start_total_time = std::chrono::steady_clock::now();
@@ -48,7 +71,13 @@ public:
         Data<MessageT> in_data {location_id};
         Data<MessageT> out_data {location_id};
 
-        bool success = m_input.pull(in_data) && m_output.pull(out_data);
+        // Reserve space downstream first, so that we never pull more messages than we can push.
+        // A pool doesn't need a reservation, so in that case the input is only bounded by the chunk size.
+        bool success = m_output.pull(out_data);
+        if (success) {
+            size_t max_input_count = m_output.is_queue ? out_data.reserve_count : m_input.max_item_count;
+            success = m_input.pull(in_data, m_input.min_item_count, std::min(max_input_count, m_input.max_item_count));
+        }
         if (!success) {
             m_input.revert(in_data);
             m_output.revert(out_data);
@@ -59,27 +88,42 @@ public:
             return;
         }
 
-        bool process_succeeded = true;
         JArrowMetrics::Status process_status = JArrowMetrics::Status::KeepGoing;
-        assert(in_data.item_count == 1);
-        MessageT* event = in_data.items[0];
+        size_t pulled_count = in_data.item_count;
+        size_t returned_count = 0; // Messages which go back to the input, compacted to the front of in_data
+        std::array<bool, JANA2_ARROWDATA_MAX_SIZE> successes;
 
         auto start_processing_time = std::chrono::steady_clock::now();
-        static_cast<DerivedT*>(this)->process(event, process_succeeded, process_status);
+        size_t i = static_cast<DerivedT*>(this)->process_chunk(in_data.items.data(), pulled_count, successes.data(), process_status);
+        for (size_t j = 0; j < i; ++j) {
+            if (successes[j]) {
+                out_data.items[out_data.item_count++] = in_data.items[j];
+            }
+            else {
+                in_data.items[returned_count++] = in_data.items[j];
+            }
+        }
+        // If process() asked us to stop early (e.g. the source is finished or needs to try again later),
+        // any messages we haven't touched go back to the input untouched
+        for (; i < pulled_count; ++i) {
+            in_data.items[returned_count++] = in_data.items[i];
+        }
+        in_data.item_count = returned_count;
         auto end_processing_time = std::chrono::steady_clock::now();
 
-        if (process_succeeded) {
-            in_data.item_count = 0;
-            out_data.item_count = 1;
-            out_data.items[0] = event;
-        }
+        size_t processed_count = out_data.item_count;
         m_input.push(in_data);
         m_output.push(out_data);
 
+        // A partially successful chunk still counts as progress, so don't make the worker back off
+        if (process_status == JArrowMetrics::Status::ComeBackLater && processed_count > 0) {
+            process_status = JArrowMetrics::Status::KeepGoing;
+        }
+
         // Publish metrics
         auto end_total_time = std::chrono::steady_clock::now();
         auto latency = (end_processing_time - start_processing_time);
         auto overhead = (end_total_time - start_total_time) - latency;
-        result.update(process_status, process_succeeded, 1, latency, overhead);
+        result.update(process_status, processed_count, 1, latency, overhead);
     }
 };
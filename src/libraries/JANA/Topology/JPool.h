@@ -3,15 +3,34 @@
 
 #pragma once
 #include <JANA/Utils/JCpuInfo.h>
+#include <JANA/Utils/JWaitObject.h>
 #include <JANA/JLogger.h>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
 
 
 class JPoolBase {
 protected:
     size_t m_pool_size;
     size_t m_location_count;
+    size_t m_location_pool_size; // Each location gets an equal share of m_pool_size, rounded up
     bool m_limit_total_events_in_flight;
+    size_t m_magazine_size = 0;
+    const size_t m_pool_id; // Globally unique, never reused. Used to find this pool's thread-local magazines.
+    JWaitObject m_wait_object; // Notified whenever items are returned, so that starved workers can park on it
+
+    static size_t next_pool_id() {
+        static std::atomic<size_t> next_id {0};
+        return next_id++;
+    }
+
 public:
     JPoolBase(
         size_t pool_size,
@@ -19,9 +38,31 @@ public:
         bool limit_total_events_in_flight)
       : m_pool_size(pool_size)
       , m_location_count(location_count)
-      , m_limit_total_events_in_flight(limit_total_events_in_flight) {}
+      , m_location_pool_size(location_count == 0 ? pool_size : (pool_size + location_count - 1) / location_count)
+      , m_limit_total_events_in_flight(limit_total_events_in_flight)
+      , m_pool_id(next_pool_id()) {}
 
     virtual ~JPoolBase() = default;
+
+    /// set_magazine_size() enables a per-thread cache ("magazine") of up to magazine_size free items
+    /// in front of each location's shared free list. Threads then only touch the shared free list
+    /// when refilling or flushing their magazine, in batches of magazine_size/2.
+    /// 0 disables magazines. Must be called before the pool is used.
+    void set_magazine_size(size_t magazine_size) { m_magazine_size = magazine_size; }
+    size_t get_magazine_size() const { return m_magazine_size; }
+
+    size_t get_location_count() const { return m_location_count; }
+
+    /// get_location_pool_size() is the number of items each location starts out with. The pool size is split
+    /// across the locations, so that adding locations doesn't multiply the number of items in flight. A location
+    /// which runs dry takes items from the others, so the whole pool stays usable from any one location.
+    size_t get_location_pool_size() const { return m_location_pool_size; }
+
+    JWaitObject& get_wait_object() { return m_wait_object; }
+
+    /// get_numa_node_histogram() reports how many of a location's pages live on each NUMA node
+    /// (-1 means unknown), as a way of verifying that first-touch placement worked.
+    virtual std::map<int, size_t> get_numa_node_histogram(size_t /*location*/) { return {}; }
 };
 
 template <typename T>
@@ -30,11 +71,30 @@ private:
     struct alignas(JANA2_CACHE_LINE_BYTES) LocalPool {
         std::mutex mutex;
         std::vector<T*> available_items;
-        std::vector<T> items;
+        size_t lock_count = 0; // Number of times the shared free list was locked. Protected by mutex.
+        size_t constructed_count = 0; // Number of items in this location's slab which have been constructed
+    };
+
+    /// A Magazine belongs to exactly one (thread, pool) pair. Its mutex is only ever contended when a
+    /// starving thread reclaims items from other threads' magazines, so locking it is cheap.
+    struct alignas(JANA2_CACHE_LINE_BYTES) Magazine {
+        std::mutex mutex;
+        std::thread::id owner;
+        size_t location;
+        std::vector<T*> items;
     };
 
     std::unique_ptr<LocalPool[]> m_pools;
 
+    // All pooled items live in one allocation, one page-aligned slab per location,
+    // so that the home location of any item can be computed in O(1) from its address.
+    static constexpr size_t PAGE_BYTES = 4096;
+    char* m_storage = nullptr;
+    size_t m_stride_bytes = 0;
+
+    std::mutex m_magazines_mutex;
+    std::vector<std::unique_ptr<Magazine>> m_magazines;
+
 public:
     JPool(size_t pool_size,
           size_t location_count,
@@ -44,20 +104,60 @@ public:
         assert(m_pool_size > 0 || !m_limit_total_events_in_flight);
     }
 
-    virtual ~JPool() = default;
+    virtual ~JPool() {
+        if (m_storage != nullptr) {
+            for (size_t loc=0; loc<m_location_count; ++loc) {
+                for (size_t i=0; i<m_pools[loc].constructed_count; ++i) {
+                    item_at(loc, i)->~T();
+                }
+            }
+            ::operator delete(m_storage, std::align_val_t(PAGE_BYTES));
+        }
+    }
 
     void init() {
-        m_pools = std::unique_ptr<LocalPool[]>(new LocalPool[m_location_count]());
-
+        allocate();
         for (size_t j=0; j<m_location_count; ++j) {
+            init_location(j);
+        }
+    }
 
-            m_pools[j].items = std::vector<T>(m_pool_size); // Default-construct everything in place
-
-            for (T& item : m_pools[j].items) {
-                configure_item(&item);
-                m_pools[j].available_items.push_back(&item);
+    /// init(location_cpus) is like init(), except that each location's items are constructed and configured
+    /// by a temporary thread pinned to location_cpus[location]. Linux places memory on the NUMA node of the
+    /// thread that first touches it, so this keeps each location's items (and everything configure_item()
+    /// allocates for them) local to the cpus that will process them. Locations are initialized one at a time,
+    /// so configure_item() never runs concurrently.
+    /// Returns the locations whose thread could not be pinned. Their items are still constructed, just without
+    /// any guarantee about which NUMA node they end up on.
+    std::vector<size_t> init(const std::vector<std::vector<size_t>>& location_cpus) {
+        std::vector<size_t> unpinned_locations;
+        if (location_cpus.size() != m_location_count) {
+            init();
+            for (size_t j=0; j<m_location_count; ++j) unpinned_locations.push_back(j);
+            return unpinned_locations;
+        }
+        allocate();
+        for (size_t j=0; j<m_location_count; ++j) {
+            std::exception_ptr exception;
+            bool pinned = false;
+            std::thread thread([&, j]() {
+                try {
+                    pinned = JCpuInfo::PinCurrentThreadToCpus(location_cpus[j]);
+                    init_location(j);
+                }
+                catch (...) {
+                    exception = std::current_exception();
+                }
+            });
+            thread.join();
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+            if (!pinned) {
+                unpinned_locations.push_back(j);
             }
         }
+        return unpinned_locations;
     }
 
     virtual void configure_item(T*) {
@@ -66,52 +166,90 @@ public:
     virtual void release_item(T*) {
     }
 
+    /// get_item_addresses() lists the memory owned by an item, for get_numa_node_histogram(). Subclasses whose items
+    /// own heap memory (e.g. JEventPool) should extend this.
+    virtual void get_item_addresses(T* item, std::vector<const void*>& addresses) {
+        addresses.push_back(item);
+    }
 
-    T* get(size_t location=0) {
-
-        assert(m_pools != nullptr); // If you hit this, you forgot to call init().
-        LocalPool& pool = m_pools[location % m_location_count];
-        std::lock_guard<std::mutex> lock(pool.mutex);
+    std::map<int, size_t> get_numa_node_histogram(size_t location) override {
+        std::map<int, size_t> histogram;
+        if (m_storage == nullptr || location >= m_location_count) return histogram;
+        std::vector<const void*> addresses;
+        for (size_t i=0; i<m_pools[location].constructed_count; ++i) {
+            get_item_addresses(item_at(location, i), addresses);
+        }
+        std::vector<int> nodes;
+        JCpuInfo::GetNumaNodes(addresses, nodes);
+        for (int node : nodes) {
+            histogram[node] += 1;
+        }
+        return histogram;
+    }
 
-        if (pool.available_items.empty()) {
-            if (m_limit_total_events_in_flight) {
-                return nullptr;
-            }
-            else {
-                auto t = new T;
-                configure_item(t);
-                return t;
-            }
+    /// Returns the location whose slab contains this item, or get_location_count() if the item was heap-allocated
+    size_t get_home_location(const T* item) const {
+        const char* p = reinterpret_cast<const char*>(item);
+        if (m_storage == nullptr || p < m_storage || p >= m_storage + m_stride_bytes * m_location_count) {
+            return m_location_count;
         }
-        else {
-            T* item = pool.available_items.back();
-            pool.available_items.pop_back();
-            return item;
+        return static_cast<size_t>(p - m_storage) / m_stride_bytes;
+    }
+
+    /// Total number of times any thread has locked a location's shared free list. Meant for tests and benchmarks.
+    size_t get_shared_lock_count() {
+        size_t result = 0;
+        for (size_t j=0; j<m_location_count; ++j) {
+            std::lock_guard<std::mutex> lock(m_pools[j].mutex);
+            result += m_pools[j].lock_count;
         }
+        return result;
+    }
+
+
+    /// get() takes one item, preferring the caller's own location. See pop().
+    T* get(size_t location=0) {
+        T* item = nullptr;
+        pop(&item, 1, 1, location);
+        return item;
     }
 
 
     void put(T* item, size_t location=0) {
 
         assert(m_pools != nullptr); // If you hit this, you forgot to call init().
-        
+
         // Do any necessary teardown within the item itself
         release_item(item);
 
-        // Consider each location starting with current one
-        for (size_t l = location; l<location+m_location_count; ++l) {
-            LocalPool& pool = m_pools[l % m_location_count];
+        size_t home = get_home_location(item);
+        if (home == m_location_count) {
+            // It was allocated on the heap
+            delete item;
+            return;
+        }
 
-            // Check if item came from this location
-            if ((item >= &(pool.items[0])) && (item <= &(pool.items[m_pool_size-1]))) {
-                std::lock_guard<std::mutex> lock(pool.mutex);
-                pool.available_items.push_back(item);
-                return;
+        if (m_magazine_size > 0 && home == location % m_location_count) {
+            Magazine& mag = get_magazine(location % m_location_count);
+            {
+                std::lock_guard<std::mutex> lock(mag.mutex);
+                mag.items.push_back(item);
+                if (mag.items.size() > m_magazine_size) {
+                    flush_magazine(mag, std::max<size_t>(1, m_magazine_size / 2));
+                }
             }
+            m_wait_object.notify();
+            return;
+        }
 
+        // Items always go back to the location they came from
+        LocalPool& pool = m_pools[home];
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.lock_count++;
+            pool.available_items.push_back(item);
         }
-        // Otherwise it was allocated on the heap
-        delete item;
+        m_wait_object.notify();
     }
 
     // TODO: This is wrong. Do we use this anywhere?
@@ -124,6 +262,7 @@ public:
 
         LocalPool& pool = m_pools[location % m_location_count];
         std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.lock_count++;
 
         if (m_limit_total_events_in_flight && pool.available_items.size() < count) {
             return false;
@@ -153,47 +292,56 @@ public:
     }
 
 
+    /// pop() takes between min_count and max_count items, or none at all if the pool is bounded and can't supply
+    /// min_count. Items come from the caller's own location first. Since the pool size is split across locations,
+    /// a location may only hold one or two items, so any shortfall up to max_count is taken from the other
+    /// locations' free lists. Those items still go back to their own location on put().
     size_t pop(T** dest, size_t min_count, size_t max_count, size_t location=0) {
 
         assert(m_pools != nullptr); // If you hit this, you forgot to call init().
+        location = location % m_location_count;
 
-        LocalPool& pool = m_pools[location % m_location_count];
-        std::lock_guard<std::mutex> lock(pool.mutex);
-
-        size_t available_count = pool.available_items.size();
-
-        if (m_limit_total_events_in_flight && available_count < min_count) {
-            // Exit immmediately if we can't reach the minimum
-            return 0;
+        size_t count = 0;
+        if (m_magazine_size > 0) {
+            count = pop_from_magazine(dest, min_count, max_count, location);
         }
-        if (m_limit_total_events_in_flight) {
-            // Return as many as we can. We aren't allowed to create any more
-            size_t count = std::min(available_count, max_count);
-            for (size_t i=0; i<count; ++i) {
-                T* t = pool.available_items.back();
-                pool.available_items.pop_back();
-                dest[i] = t;
+        else {
+            count = take_items(m_pools[location], dest, max_count);
+        }
+        for (size_t j=1; j<m_location_count && count<max_count; ++j) {
+            count += take_items(m_pools[(location + j) % m_location_count], dest + count, max_count - count);
+        }
+        if (count < min_count && m_limit_total_events_in_flight && m_magazine_size > 0 && m_location_count > 1) {
+            // The rest may be sitting in magazines at other locations
+            reclaim_magazines(nullptr);
+            for (size_t j=0; j<m_location_count && count<max_count; ++j) {
+                count += take_items(m_pools[(location + j) % m_location_count], dest + count, max_count - count);
             }
+        }
+
+        if (count >= min_count) {
             return count;
         }
-        else {
-            // Try to minimize number of allocations, as long as we meet min_count
-            size_t count = std::min(available_count, max_count);
-            size_t i=0;
-            for (i=0; i<count; ++i) {
-                // Pop the items already in the pool
-                T* t = pool.available_items.back();
-                pool.available_items.pop_back();
-                dest[i] = t;
+        if (m_limit_total_events_in_flight) {
+            // We can't reach the minimum, so give back what we took. Nobody has seen these items, so they skip
+            // release_item(), but starved threads may have looked at the pool in the meantime.
+            for (size_t i=0; i<count; ++i) {
+                LocalPool& pool = m_pools[get_home_location(dest[i])];
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                pool.available_items.push_back(dest[i]);
             }
-            for (; i<min_count; ++i) {
-                // If we haven't reached our min count yet, allocate just enough to reach it
-                auto t = new T;
-                configure_item(t);
-                dest[i] = t;
+            if (count > 0) {
+                m_wait_object.notify();
             }
-            return i;
+            return 0;
         }
+        for (; count<min_count; ++count) {
+            // If we haven't reached our min count yet, allocate just enough to reach it
+            auto t = new T;
+            configure_item(t);
+            dest[count] = t;
+        }
+        return count;
     }
 
     void push(T** source, size_t count, size_t location=0) {
@@ -202,6 +350,136 @@ public:
             source[i] = nullptr;
         }
     }
+
+private:
+
+    void allocate() {
+        m_pools = std::unique_ptr<LocalPool[]>(new LocalPool[m_location_count]());
+
+        m_stride_bytes = ((m_location_pool_size * sizeof(T) + PAGE_BYTES - 1) / PAGE_BYTES) * PAGE_BYTES;
+        if (m_stride_bytes > 0) {
+            m_storage = static_cast<char*>(::operator new(m_stride_bytes * m_location_count, std::align_val_t(PAGE_BYTES)));
+        }
+    }
+
+    void init_location(size_t location) {
+        for (size_t i=0; i<m_location_pool_size; ++i) {
+            T* item = new (item_at(location, i)) T; // Default-construct everything in place
+            m_pools[location].constructed_count += 1;
+            configure_item(item);
+            m_pools[location].available_items.push_back(item);
+        }
+    }
+
+    T* item_at(size_t location, size_t index) {
+        return reinterpret_cast<T*>(m_storage + location * m_stride_bytes) + index;
+    }
+
+    /// Finds (or lazily creates) the calling thread's magazine for this pool and location.
+    Magazine& get_magazine(size_t location) {
+        // Indexed by pool id. Pool ids are never reused, so entries belonging to destroyed pools are never read again.
+        thread_local std::vector<Magazine*> t_magazines;
+        if (m_pool_id >= t_magazines.size()) {
+            t_magazines.resize(m_pool_id + 1, nullptr);
+        }
+        Magazine* mag = t_magazines[m_pool_id];
+        if (mag == nullptr || mag->location != location) {
+            // A worker only ever has one location, so we only cache one magazine per thread. Other callers
+            // (e.g. JArrowProcessingController::execute_arrow) fall back to looking theirs up by thread id.
+            auto thread_id = std::this_thread::get_id();
+            std::lock_guard<std::mutex> lock(m_magazines_mutex);
+            mag = nullptr;
+            for (auto& candidate : m_magazines) {
+                if (candidate->owner == thread_id && candidate->location == location) {
+                    mag = candidate.get();
+                    break;
+                }
+            }
+            if (mag == nullptr) {
+                m_magazines.push_back(std::make_unique<Magazine>());
+                mag = m_magazines.back().get();
+                mag->owner = thread_id;
+                mag->location = location;
+                mag->items.reserve(m_magazine_size + 1);
+            }
+            t_magazines[m_pool_id] = mag;
+        }
+        return *mag;
+    }
+
+    /// Moves `count` items from the magazine back to its location's shared free list. Caller holds mag.mutex.
+    void flush_magazine(Magazine& mag, size_t count) {
+        count = std::min(count, mag.items.size());
+        LocalPool& pool = m_pools[mag.location];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.lock_count++;
+        for (size_t i=0; i<count; ++i) {
+            pool.available_items.push_back(mag.items.back());
+            mag.items.pop_back();
+        }
+    }
+
+    /// Moves up to `count` items from the location's shared free list into the magazine. Caller holds mag.mutex.
+    void refill_magazine(Magazine& mag, size_t count) {
+        LocalPool& pool = m_pools[mag.location];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.lock_count++;
+        count = std::min(count, pool.available_items.size());
+        for (size_t i=0; i<count; ++i) {
+            mag.items.push_back(pool.available_items.back());
+            pool.available_items.pop_back();
+        }
+    }
+
+    /// Moves up to `count` items from a location's shared free list into dest. Returns the number moved.
+    size_t take_items(LocalPool& pool, T** dest, size_t count) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.lock_count++;
+        count = std::min(count, pool.available_items.size());
+        for (size_t i=0; i<count; ++i) {
+            dest[i] = pool.available_items.back();
+            pool.available_items.pop_back();
+        }
+        return count;
+    }
+
+    /// Returns every item hoarded in other threads' magazines at this location to the shared free list.
+    /// This keeps a bounded pool from deadlocking when its free items are scattered across idle threads.
+    /// We only try_lock the other magazines because we are already holding our own. If mine is nullptr,
+    /// the magazines at every location are reclaimed instead.
+    void reclaim_magazines(Magazine* mine) {
+        std::lock_guard<std::mutex> lock(m_magazines_mutex);
+        for (auto& other : m_magazines) {
+            if (other.get() == mine || (mine != nullptr && other->location != mine->location)) continue;
+            if (other->mutex.try_lock()) {
+                flush_magazine(*other, other->items.size());
+                other->mutex.unlock();
+            }
+        }
+    }
+
+    /// Takes up to max_count items from this thread's magazine for the location, refilling it from the location's
+    /// shared free list (and if need be, other threads' magazines) first. Never allocates.
+    size_t pop_from_magazine(T** dest, size_t min_count, size_t max_count, size_t location) {
+
+        Magazine& mag = get_magazine(location);
+        std::lock_guard<std::mutex> lock(mag.mutex);
+
+        if (mag.items.size() < max_count) {
+            refill_magazine(mag, std::max(max_count, m_magazine_size / 2));
+        }
+        if (mag.items.size() < min_count && m_limit_total_events_in_flight) {
+            reclaim_magazines(&mag);
+            refill_magazine(mag, std::max(max_count, m_magazine_size / 2));
+        }
+
+        size_t count = std::min(mag.items.size(), max_count);
+        for (size_t i=0; i<count; ++i) {
+            dest[i] = mag.items.back();
+            mag.items.pop_back();
+        }
+        return count;
+    }
 };
 
 
@@ -0,0 +1,184 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/Utils/JCpuInfo.h>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <cstdint>
+
+/// JRingBuffer is a bounded, lock-free, multi-producer multi-consumer queue. It is the
+/// lock-free backend for JMailbox's LocalQueue. Each cell carries a sequence number which
+/// tells producers and consumers whether the cell is free for position `pos` (sequence == pos)
+/// or holds the item for position `pos` (sequence == pos+1). Producers and consumers claim
+/// contiguous runs of cells by CAS'ing the enqueue/dequeue cursors forward, so that a chunk
+/// of events costs a single atomic RMW instead of one per event.
+///
+/// The physical capacity is rounded up to the next power of two. JMailbox enforces its own
+/// (smaller) logical capacity via reservations, so the ring itself never needs to resize.
+///
+/// \tparam T must be moveable. It need not be default-constructible.
+
+template <typename T>
+class JRingBuffer {
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* data() { return std::launder(reinterpret_cast<T*>(&storage)); }
+    };
+
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    // Keep the cursors on separate cache lines so that producers and consumers don't false-share
+    alignas(JANA2_CACHE_LINE_BYTES) std::atomic<size_t> m_enqueue_pos {0};
+    alignas(JANA2_CACHE_LINE_BYTES) std::atomic<size_t> m_dequeue_pos {0};
+
+    static size_t round_up_to_power_of_two(size_t x) {
+        size_t result = 1;
+        while (result < x) result <<= 1;
+        return result;
+    }
+
+public:
+
+    explicit JRingBuffer(size_t min_capacity)
+        : m_capacity(round_up_to_power_of_two(min_capacity < 2 ? 2 : min_capacity))
+        , m_mask(m_capacity - 1)
+        , m_cells(new Cell[m_capacity]) {
+
+        for (size_t i=0; i<m_capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~JRingBuffer() {
+        // Destroy anything still sitting in the ring. Only safe once all producers and consumers are gone.
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        size_t end = m_enqueue_pos.load(std::memory_order_relaxed);
+        for (; pos != end; ++pos) {
+            m_cells[pos & m_mask].data()->~T();
+        }
+    }
+
+    JRingBuffer(const JRingBuffer&) = delete;
+    JRingBuffer& operator=(const JRingBuffer&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    /// size() is a snapshot. It includes items whose cells have been claimed but not yet published.
+    size_t size() const {
+        size_t dequeue_pos = m_dequeue_pos.load(std::memory_order_acquire);
+        size_t enqueue_pos = m_enqueue_pos.load(std::memory_order_acquire);
+        return (enqueue_pos > dequeue_pos) ? (enqueue_pos - dequeue_pos) : 0;
+    }
+
+    /// try_push() is all-or-nothing: either all `count` items are moved into the ring, or none are
+    /// and it returns false. This only fails when the ring is physically full (or a consumer is still
+    /// moving an item out of one of the cells we need).
+    bool try_push(T* items, size_t count) {
+        if (count == 0) return true;
+        if (count > m_capacity) return false;
+
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            bool stale = false;
+            for (size_t i=0; i<count; ++i) {
+                Cell& cell = m_cells[(pos + i) & m_mask];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t) seq - (intptr_t) (pos + i);
+                if (diff < 0) {
+                    return false; // Cell still holds an item from the previous lap
+                }
+                if (diff > 0) {
+                    stale = true; // Another producer claimed this position already
+                    break;
+                }
+            }
+            if (stale) {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (m_enqueue_pos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+            // CAS failure reloads pos for us
+        }
+        for (size_t i=0; i<count; ++i) {
+            Cell& cell = m_cells[(pos + i) & m_mask];
+            new (&cell.storage) T(std::move(items[i]));
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    /// push() waits until there is room for all `count` items. It spins for as long as the ring is full, so
+    /// it is only for callers which have bounded the number of items in flight themselves. JMailbox doesn't
+    /// use it, because unreserved pushes are allowed to exceed the ring; it uses try_push() and overflows.
+    void push(T* items, size_t count) {
+        while (!try_push(items, count)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /// try_pop() moves between min_count and max_count items into dest and returns how many it moved.
+    /// If fewer than min_count items are available, it moves nothing and returns 0.
+    size_t try_pop(T* dest, size_t min_count, size_t max_count) {
+        return try_consume(min_count, max_count, [&](size_t i, T&& item) { dest[i] = std::move(item); });
+    }
+
+    /// try_consume() is the same as try_pop(), except that each item is handed to `sink(index, T&&)`
+    /// instead of being assigned into an array. This lets callers append to containers of types
+    /// which aren't default-constructible.
+    template <typename SinkT>
+    size_t try_consume(size_t min_count, size_t max_count, SinkT&& sink) {
+        if (max_count == 0) return 0;
+
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (true) {
+            bool stale = false;
+            count = 0;
+            while (count < max_count && count < m_capacity) {
+                Cell& cell = m_cells[(pos + count) & m_mask];
+                size_t seq = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t) seq - (intptr_t) (pos + count + 1);
+                if (diff < 0) {
+                    break; // Not yet published
+                }
+                if (diff > 0) {
+                    stale = true; // Another consumer claimed this position already
+                    break;
+                }
+                count++;
+            }
+            if (stale) {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (count == 0 || count < min_count) {
+                return 0;
+            }
+            if (m_dequeue_pos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i=0; i<count; ++i) {
+            Cell& cell = m_cells[(pos + i) & m_mask];
+            T* item = cell.data();
+            sink(i, std::move(*item));
+            item->~T();
+            cell.sequence.store(pos + i + m_capacity, std::memory_order_release);
+        }
+        return count;
+    }
+};
+
+
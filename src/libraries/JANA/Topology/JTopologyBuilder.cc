@@ -89,11 +89,14 @@ void JTopologyBuilder::create_topology() {
     mapping.initialize(static_cast<JProcessorMapping::AffinityStrategy>(m_affinity),
                        static_cast<JProcessorMapping::LocalityStrategy>(m_locality));
 
+    // Event pools are split into the same locations as the queues, so that events never have to cross them
+    m_location_count = mapping.get_loc_count();
+
     event_pool = new JEventPool(m_components,
                                 m_event_pool_size,
                                 m_location_count,
                                 m_limit_total_events_in_flight);
-    event_pool->init();
+    init_event_pool(event_pool);
 
     if (m_configure_topology) {
         m_configure_topology(*this);
@@ -107,11 +110,70 @@ void JTopologyBuilder::create_topology() {
     for (auto* queue : queues) {
         queue->set_logger(m_queue_logger);
         queue->set_id(id);
+        queue->set_location_distances(mapping.get_loc_distances());
         id += 1;
     }
     for (auto* arrow : arrows) {
         arrow->set_logger(m_arrow_logger);
     }
+    if (m_verify_locality) {
+        LOG_INFO(GetLogger()) << "Event pool memory placement:\n" << print_pool_locality() << LOG_END;
+    }
+}
+
+
+/// init_event_pool() constructs the pool's events. When a locality strategy is in use, each location's events are
+/// constructed by a thread pinned to that location's cpus, so that first-touch puts their memory on the right NUMA node.
+/// The pool size is split evenly across the locations, so the total number of events in flight stays jana:event_pool_size.
+void JTopologyBuilder::init_event_pool(JEventPool* pool) {
+    pool->set_magazine_size(m_event_pool_magazine_size);
+    if (m_enable_parallel_factories) {
+        pool->set_task_queue(&task_queue);
+    }
+    if (mapping.get_locality() != JProcessorMapping::LocalityStrategy::Global) {
+        auto unpinned_locations = pool->init(mapping.get_loc_cpus());
+        for (size_t location : unpinned_locations) {
+            LOG_WARN(GetLogger()) << "Unable to pin the thread initializing event pool location " << location
+                                  << ", so its events may not live on that location's NUMA node" << LOG_END;
+        }
+    }
+    else {
+        pool->init();
+    }
+}
+
+
+/// print_pool_locality() reports which NUMA node actually holds each location's event memory.
+std::string JTopologyBuilder::print_pool_locality() {
+    JTablePrinter t;
+    t.AddColumn("Pool", JTablePrinter::Justify::Right, 0);
+    t.AddColumn("Location", JTablePrinter::Justify::Right, 0);
+    t.AddColumn("Expected NUMA domains", JTablePrinter::Justify::Left, 0);
+    t.AddColumn("Pages by NUMA domain", JTablePrinter::Justify::Left, 0);
+
+    auto expected_domains = mapping.get_loc_numa_domains();
+    std::vector<JPoolBase*> all_pools = pools;
+    if (event_pool != nullptr) all_pools.insert(all_pools.begin(), event_pool);
+
+    for (size_t p=0; p<all_pools.size(); ++p) {
+        for (size_t loc=0; loc<all_pools[p]->get_location_count(); ++loc) {
+            std::ostringstream expected;
+            if (loc < expected_domains.size()) {
+                for (size_t domain : expected_domains[loc]) expected << domain << " ";
+            }
+            else {
+                expected << "any";
+            }
+            std::ostringstream actual;
+            for (auto& pair : all_pools[p]->get_numa_node_histogram(loc)) {
+                if (pair.first < 0) actual << "unknown";
+                else actual << pair.first;
+                actual << ":" << pair.second << " ";
+            }
+            t | p | loc | expected.str() | actual.str();
+        }
+    }
+    return t.Render();
 }
 
 
@@ -135,11 +197,17 @@ void JTopologyBuilder::acquire_services(JServiceLocator *sl) {
     m_params->SetDefaultParameter("jana:limit_total_events_in_flight", m_limit_total_events_in_flight,
                                     "Controls whether the event pool is allowed to automatically grow beyond jana:event_pool_size")
             ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:event_pool_magazine_size", m_event_pool_magazine_size,
+                                    "Number of free events each worker thread caches locally in front of the event pool. Higher => fewer pool lock acquisitions; Lower => fewer idle events hoarded by each thread. 0 to disable.")
+            ->SetIsAdvanced(true);
     m_params->SetDefaultParameter("jana:event_queue_threshold", m_event_queue_threshold,
                                     "Max number of events allowed on the main event queue. Higher => Better load balancing; Lower => Fewer events in flight")
             ->SetIsAdvanced(true);
     m_params->SetDefaultParameter("jana:event_source_chunksize", m_event_source_chunksize,
-                                    "Max number of events that a JEventSource may enqueue at once. Higher => less queue contention; Lower => better load balancing")
+                                    "Max number of events that a JEventSource (and the map arrow after it) may move per work assignment, capped at JANA2_ARROWDATA_MAX_SIZE. Higher => less queue contention; Lower => better load balancing, lower first-event latency, and finer interleaving between sources")
+            ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:max_concurrent_sources", m_max_concurrent_sources,
+                                    "Max number of JEventSources at each level which may be open and read from at the same time, e.g. when reading many files from a parallel filesystem. 1 reads them one after another. Works best with a small jana:event_source_chunksize, so that one worker does not grab the whole event pool.")
             ->SetIsAdvanced(true);
     m_params->SetDefaultParameter("jana:event_processor_chunksize", m_event_processor_chunksize,
                                     "Max number of events that the JEventProcessors may dequeue at once. Higher => less queue contention; Lower => better load balancing")
@@ -147,16 +215,36 @@ void JTopologyBuilder::acquire_services(JServiceLocator *sl) {
     m_params->SetDefaultParameter("jana:enable_stealing", m_enable_stealing,
                                     "Enable work stealing. Improves load balancing when jana:locality != 0; otherwise does nothing.")
             ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:enable_lockfree_queues", m_enable_lockfree_queues,
+                                    "Use lock-free ring buffers for the event queues instead of mutex-guarded deques. Reduces queue contention at high thread counts.")
+            ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:enable_lockfree_scheduler", m_enable_lockfree_scheduler,
+                                    "Let workers check arrows in and out of the scheduler using per-arrow atomics, only locking on arrow/topology status changes. Reduces scheduler contention at high thread counts.")
+            ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:scheduler_policy", m_scheduler_policy,
+                                    "Which arrow a worker picks up next. 'round_robin' cycles through all runnable arrows. 'drain_first' prefers arrows with the fullest input queues and holds back sources while downstream queues are congested, which keeps fewer events in flight.")
+            ->SetIsAdvanced(true);
     m_params->SetDefaultParameter("jana:affinity", m_affinity,
-                                    "Constrain worker thread CPU affinity. 0=Let the OS decide. 1=Avoid extra memory movement at the expense of using hyperthreads. 2=Avoid hyperthreads at the expense of extra memory movement")
+                                    "Constrain worker thread CPU affinity. 0=Let the OS decide. 1=Avoid extra memory movement at the expense of using hyperthreads. 2=Avoid hyperthreads at the expense of extra memory movement, using performance cores before efficiency cores. 3=Pack workers onto as few shared L3 caches as possible")
             ->SetIsAdvanced(true);
     m_params->SetDefaultParameter("jana:locality", m_locality,
-                                    "Constrain memory locality. 0=No constraint. 1=Events stay on the same socket. 2=Events stay on the same NUMA domain. 3=Events stay on same core. 4=Events stay on same cpu/hyperthread.")
+                                    "Constrain memory locality. 0=No constraint. 1=Events stay on the same socket. 2=Events stay on the same NUMA domain. 3=Events stay on same core. 4=Events stay on same cpu/hyperthread. 5=Events stay on the same shared L3 cache.")
+            ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:verify_locality", m_verify_locality,
+                                    "Report which NUMA domain actually holds each location's event memory, to verify that jana:locality is being honored.")
+            ->SetIsAdvanced(true);
+    m_params->SetDefaultParameter("jana:enable_parallel_factories", m_enable_parallel_factories,
+                                    "Run independent JOmniFactories for the same event concurrently, as allowed by their declared inputs and outputs. Idle workers help out. Factories without declared inputs are still pulled lazily. Not compatible with record_call_stack.")
             ->SetIsAdvanced(true);
     m_params->SetDefaultParameter("record_call_stack", m_enable_call_graph_recording,
                                     "Records a trace of who called each factory. Reduces performance but necessary for plugins such as janadot.")
             ->SetIsAdvanced(true);
 
+    if (m_enable_parallel_factories && m_enable_call_graph_recording) {
+        LOG_WARN(m_logging->get_logger("JTopologyBuilder")) << "jana:enable_parallel_factories is not compatible with record_call_stack, so it has been disabled" << LOG_END;
+        m_enable_parallel_factories = false;
+    }
+
     m_arrow_logger = m_logging->get_logger("JArrow");
     m_queue_logger = m_logging->get_logger("JQueue");
 };
@@ -174,7 +262,7 @@ void JTopologyBuilder::attach_lower_level(JEventLevel current_level, JUnfoldArro
                                         m_location_count,
                                         m_limit_total_events_in_flight, 
                                         current_level);
-    pool->init();
+    init_event_pool(pool);
     pools.push_back(pool); // Transfers ownership
 
 
@@ -208,10 +296,10 @@ void JTopologyBuilder::attach_lower_level(JEventLevel current_level, JUnfoldArro
         throw JException("For now we require you to provide at least one JEventProcessor");
     }
 
-    auto q1 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing);
+    auto q1 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
     queues.push_back(q1);
 
-    auto q2 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing);
+    auto q2 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
     queues.push_back(q2);
 
     auto* proc_arrow = new JEventProcessorArrow(ss.str()+"Tap", q1, q2, nullptr);
@@ -266,7 +354,7 @@ void JTopologyBuilder::attach_top_level(JEventLevel current_level) {
                                                 m_location_count,
                                                 m_limit_total_events_in_flight, 
                                                 current_level);
-    pool_at_level->init();
+    init_event_pool(pool_at_level);
     pools.push_back(pool_at_level); // Hand over ownership of the pool to the topology
 
     // There are two possibilities at this point:
@@ -291,6 +379,15 @@ void JTopologyBuilder::attach_top_level(JEventLevel current_level) {
         }
     }
 
+    // Sources which do their unpacking in Preprocess() get a parallel JEventMapArrow right after the source arrow.
+    // Sources have to say so via EnablePreprocess(), since we can't detect whether Preprocess() was overridden.
+    std::vector<JEventSource*> preprocessing_sources_at_level;
+    for (JEventSource* source : sources_at_level) {
+        if (source->IsPreprocessEnabled()) {
+            preprocessing_sources_at_level.push_back(source);
+        }
+    }
+
     if (unfolders_at_level.size() == 0) {
         // No unfolders, so this is the only level
         // Attach the source to the map/tap just like before
@@ -301,40 +398,62 @@ void JTopologyBuilder::attach_top_level(JEventLevel current_level) {
 
         LOG_DEBUG(GetLogger()) << "JTopologyBuilder: No unfolders found at level " << current_level << ", finishing here." << LOG_END;
 
-        auto queue = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing);
+        auto queue = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
         queues.push_back(queue);
 
-        auto* src_arrow = new JEventSourceArrow(level_str+"Source", sources_at_level, queue, pool_at_level);
+        auto* src_arrow = new JEventSourceArrow(level_str+"Source", sources_at_level, queue, pool_at_level, m_max_concurrent_sources);
         arrows.push_back(src_arrow);
         src_arrow->set_chunksize(m_event_source_chunksize);
 
-        auto* proc_arrow = new JEventProcessorArrow(level_str+"Tap", queue, nullptr, pool_at_level);
+        JArrow* upstream_arrow = src_arrow;
+        EventQueue* proc_queue = queue;
+        if (preprocessing_sources_at_level.size() != 0) {
+            proc_queue = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
+            queues.push_back(proc_queue);
+
+            auto* map_arrow = new JEventMapArrow(level_str+"Map", queue, proc_queue);
+            arrows.push_back(map_arrow);
+            map_arrow->set_chunksize(m_event_source_chunksize);
+            for (auto source : preprocessing_sources_at_level) {
+                map_arrow->add_source(source);
+            }
+            src_arrow->attach(map_arrow);
+            upstream_arrow = map_arrow;
+        }
+
+        auto* proc_arrow = new JEventProcessorArrow(level_str+"Tap", proc_queue, nullptr, pool_at_level);
         arrows.push_back(proc_arrow);
         proc_arrow->set_chunksize(m_event_processor_chunksize);
 
         for (auto proc: procs_at_level) {
             proc_arrow->add_processor(proc);
         }
-        src_arrow->attach(proc_arrow);
+        upstream_arrow->attach(proc_arrow);
     }
     else if (unfolders_at_level.size() != 1) {
         throw JException("At most one unfolder must be provided for each level in the event hierarchy!");
     }
     else {
         
-        auto q1 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing);
-        auto q2 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing);
+        auto q1 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
+        auto q2 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
 
         queues.push_back(q1);
         queues.push_back(q2);
 
-        auto *src_arrow = new JEventSourceArrow(level_str+"Source", sources_at_level, q1, pool_at_level);
+        auto *src_arrow = new JEventSourceArrow(level_str+"Source", sources_at_level, q1, pool_at_level, m_max_concurrent_sources);
         arrows.push_back(src_arrow);
         src_arrow->set_chunksize(m_event_source_chunksize);
 
         auto *map_arrow = new JEventMapArrow(level_str+"Map", q1, q2);;
         arrows.push_back(map_arrow);
         map_arrow->set_chunksize(m_event_source_chunksize);
+        for (auto source : preprocessing_sources_at_level) {
+            map_arrow->add_source(source);
+        }
+        if (unfolders_at_level[0]->GetCallPreprocessUpstream()) {
+            map_arrow->add_unfolder(unfolders_at_level[0]);
+        }
         src_arrow->attach(map_arrow);
 
         // TODO: We are using q2 temporarily knowing that it will be overwritten in attach_lower_level.
@@ -357,7 +476,7 @@ void JTopologyBuilder::attach_top_level(JEventLevel current_level) {
 
         if (procs_at_level.size() != 0) {
 
-            auto q3 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing);
+            auto q3 = new EventQueue(m_event_queue_threshold, mapping.get_loc_count(), m_enable_stealing, m_enable_lockfree_queues);
             queues.push_back(q3);
 
             auto* proc_arrow = new JEventProcessorArrow(level_str+"Tap", q3, nullptr, pool_at_level);
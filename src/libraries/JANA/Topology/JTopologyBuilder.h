@@ -7,6 +7,7 @@
 #include <memory>
 #include <JANA/JService.h>
 #include <JANA/Utils/JProcessorMapping.h>
+#include <JANA/Utils/JTaskQueue.h>
 #include <JANA/Engine/JPerfMetrics.h>  // TODO: Should't be here
 
 #include <JANA/Services/JParameterManager.h>
@@ -39,12 +40,19 @@ public:
     
     // Topology configuration
     size_t m_event_pool_size = 4;
+    size_t m_event_pool_magazine_size = 0;
     size_t m_event_queue_threshold = 80;
-    size_t m_event_source_chunksize = 40;
+    size_t m_event_source_chunksize = 1;
+    size_t m_max_concurrent_sources = 1;
     size_t m_event_processor_chunksize = 1;
     size_t m_location_count = 1;
     bool m_enable_call_graph_recording = false;
+    bool m_enable_parallel_factories = false;
     bool m_enable_stealing = false;
+    bool m_enable_lockfree_queues = false;
+    bool m_enable_lockfree_scheduler = false;
+    std::string m_scheduler_policy = "round_robin";
+    bool m_verify_locality = false;
     bool m_limit_total_events_in_flight = true;
     int m_affinity = 0;
     int m_locality = 0;
@@ -54,6 +62,7 @@ public:
     JEventPool* event_pool = nullptr; // TODO: Move into pools eventually
     JPerfMetrics metrics;
     JProcessorMapping mapping;
+    JTaskQueue task_queue; // Intra-event tasks, e.g. from JFactoryDag, which idle workers help with
 
     JLogger m_arrow_logger;
     JLogger m_queue_logger;
@@ -80,6 +89,11 @@ public:
 
     std::string print_topology();
 
+    std::string print_pool_locality();
+
+private:
+    void init_event_pool(JEventPool* pool);
+
 
 };
 
@@ -0,0 +1,88 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+void* JArena::Allocate(size_t bytes, size_t alignment) {
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_thread_safe) lock.lock();
+    return AllocateUnlocked(bytes, alignment);
+}
+
+
+void* JArena::AllocateUnlocked(size_t bytes, size_t alignment) {
+
+    // Try the current chunk, then any chunks after it that we kept from earlier events
+    while (m_current_chunk < m_chunks.size()) {
+        Chunk& chunk = m_chunks[m_current_chunk];
+        auto base = reinterpret_cast<uintptr_t>(chunk.data.get());
+        uintptr_t aligned = (base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t new_offset = (aligned - base) + bytes;
+        if (new_offset <= chunk.size) {
+            m_bytes_allocated += new_offset - m_offset;
+            m_offset = new_offset;
+            return reinterpret_cast<void*>(aligned);
+        }
+        if (m_current_chunk + 1 == m_chunks.size()) break;
+        m_current_chunk += 1;
+        m_offset = 0;
+    }
+
+    // Out of room: grow geometrically, and always leave enough room for this allocation
+    size_t previous = m_chunks.empty() ? 0 : m_chunks.back().size;
+    size_t size = std::max({m_initial_chunk_size, 2*previous, bytes + alignment});
+    Chunk chunk;
+    chunk.data.reset(new char[size]);
+    chunk.size = size;
+    m_chunks.push_back(std::move(chunk));
+    m_current_chunk = m_chunks.size() - 1;
+    m_offset = 0;
+    return AllocateUnlocked(bytes, alignment);
+}
+
+
+bool JArena::Owns(const void* ptr) const {
+    auto p = reinterpret_cast<uintptr_t>(ptr);
+    for (const Chunk& chunk : m_chunks) {
+        auto base = reinterpret_cast<uintptr_t>(chunk.data.get());
+        if (p >= base && p < base + chunk.size) return true;
+    }
+    return false;
+}
+
+
+void JArena::Reset() {
+
+    // Newest first, just like the stack
+    while (m_finalizers != nullptr) {
+        Finalizer* finalizer = m_finalizers;
+        m_finalizers = finalizer->next;
+        finalizer->destroy(finalizer->object);
+    }
+
+    if (m_chunks.size() > 1) {
+        size_t total = GetCapacity();
+        m_chunks.clear();
+        Chunk chunk;
+        chunk.data.reset(new char[total]);
+        chunk.size = total;
+        m_chunks.push_back(std::move(chunk));
+    }
+    m_current_chunk = 0;
+    m_offset = 0;
+    m_bytes_allocated = 0;
+    m_object_count = 0;
+}
+
+
+size_t JArena::GetCapacity() const {
+    size_t total = 0;
+    for (const Chunk& chunk : m_chunks) total += chunk.size;
+    return total;
+}
+
@@ -0,0 +1,100 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// JArena is a monotonic allocator with the same lifetime as one pass of a pooled JEvent through the topology.
+/// Allocating is a pointer bump, and instead of freeing objects one at a time, JEventPool calls Reset() when it
+/// recycles the event. Reset() runs the destructors of everything created via Create(), newest first, and then
+/// rewinds, keeping the memory around for the next event.
+///
+/// Use JFactoryT::NewObject() to place a factory's objects here, after opting in via SetUseArena(true); ClearData()
+/// then knows not to delete anything the arena owns. Arena objects must not outlive the event, so persistent factories
+/// can't use it.
+///
+/// Allocation only takes a lock once SetThreadSafe(true) has been called, which JFactorySet does when its factories
+/// may run in parallel within an event (i.e. in concurrent-create mode). Otherwise only one thread touches an event at
+/// a time, and allocating stays a plain pointer bump. Owns() and Reset() are never thread-safe; they are only meant to
+/// be called once nothing is touching the event anymore.
+class JArena {
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+        Finalizer* next;
+    };
+
+    std::vector<Chunk> m_chunks;
+    size_t m_current_chunk = 0;     // Index into m_chunks
+    size_t m_offset = 0;            // Into m_chunks[m_current_chunk]
+    size_t m_bytes_allocated = 0;   // Since the last Reset()
+    size_t m_object_count = 0;      // Since the last Reset()
+    Finalizer* m_finalizers = nullptr;
+    size_t m_initial_chunk_size;
+    bool m_thread_safe = false;
+    std::mutex m_mutex;
+
+    void* AllocateUnlocked(size_t bytes, size_t alignment);
+
+public:
+    explicit JArena(size_t initial_chunk_size = 64*1024) : m_initial_chunk_size(initial_chunk_size) {}
+    ~JArena() { Reset(); }
+
+    JArena(const JArena&) = delete;
+    JArena& operator=(const JArena&) = delete;
+
+    /// Whether Allocate() and Create() may be called from several threads at once. Set this before that happens.
+    void SetThreadSafe(bool thread_safe) { m_thread_safe = thread_safe; }
+    bool IsThreadSafe() const { return m_thread_safe; }
+
+    /// Raw memory, which the caller is responsible for destroying in place (if needed)
+    void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /// Constructs a T in the arena. Its destructor runs when the arena is Reset().
+    template <typename T, typename... Args>
+    T* Create(Args&&... args);
+
+    /// Whether ptr points into memory belonging to this arena
+    bool Owns(const void* ptr) const;
+
+    /// Destroys everything created since the last Reset() and rewinds, keeping the memory for reuse.
+    /// If the last event needed more than one chunk, they are merged into a single chunk of the combined size.
+    void Reset();
+
+    size_t GetBytesAllocated() const { return m_bytes_allocated; }
+    size_t GetObjectCount() const { return m_object_count; }
+    size_t GetCapacity() const;
+    size_t GetChunkCount() const { return m_chunks.size(); }
+};
+
+
+template <typename T, typename... Args>
+T* JArena::Create(Args&&... args) {
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_thread_safe) lock.lock();
+    void* memory = AllocateUnlocked(sizeof(T), alignof(T));
+    T* object = new (memory) T(std::forward<Args>(args)...);
+    m_object_count += 1;
+    if (!std::is_trivially_destructible<T>::value) {
+        void* finalizer_memory = AllocateUnlocked(sizeof(Finalizer), alignof(Finalizer));
+        m_finalizers = new (finalizer_memory) Finalizer {
+            [](void* obj) { static_cast<T*>(obj)->~T(); }, object, m_finalizers
+        };
+    }
+    return object;
+}
+
+
@@ -19,7 +19,10 @@
 class JCallGraphEntryMaker{
 public:
     JCallGraphEntryMaker(JCallGraphRecorder &callgraphrecorder, JFactory *factory) : m_call_graph(callgraphrecorder), m_factory(factory){
-        m_call_graph.StartFactoryCall(m_factory->GetObjectName(), m_factory->GetTag());
+        // Don't copy the names unless somebody is actually recording
+        if (m_call_graph.IsEnabled()) {
+            m_call_graph.StartFactoryCall(m_factory->GetObjectName(), m_factory->GetTag());
+        }
     }
     JCallGraphEntryMaker(JCallGraphRecorder &callgraphrecorder, std::string name) : m_call_graph(callgraphrecorder) {
         // (This is used mainly for JEventProcessors and called from JEventProcessorArrow::execute )
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <thread>
 #include <typeinfo>
+#include <cstdint>
 
 // Note that Apple complicates things some. In particular with the
 // addition of Apple silicon (M1 chip) which does not seem to have
@@ -17,6 +18,7 @@
 #endif // __aarch64__
 #else //__APPLE__ (i.e. Linux)
 #include <sched.h>
+#include <sys/syscall.h>
 #endif //__APPLE__
 
 
@@ -101,5 +103,51 @@ bool PinThreadToCpu(std::thread* thread, size_t cpu_id) {
     return true;
 }
 
+
+bool PinCurrentThreadToCpus(const std::vector<size_t>& cpu_ids) {
+
+#ifdef __APPLE__
+    // Mac OS X only supports affinity hints, not hard pinning
+    (void) cpu_ids;
+    return false;
+#else
+    if (cpu_ids.empty()) return false;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (size_t cpu_id : cpu_ids) {
+        CPU_SET(cpu_id, &cpuset);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    return (rc == 0);
+#endif
+}
+
+
+bool GetNumaNodes(const std::vector<const void*>& addresses, std::vector<int>& nodes) {
+
+    nodes.assign(addresses.size(), -1);
+#if defined(__linux__) && defined(SYS_move_pages)
+    if (addresses.empty()) return true;
+
+    // move_pages() with a null node list doesn't move anything; it just reports where each page lives
+    long page_size = sysconf(_SC_PAGESIZE);
+    std::vector<void*> pages(addresses.size());
+    for (size_t i=0; i<addresses.size(); ++i) {
+        auto address = reinterpret_cast<uintptr_t>(addresses[i]);
+        pages[i] = reinterpret_cast<void*>(address - (address % page_size));
+    }
+    std::vector<int> status(addresses.size(), -1);
+    long rc = syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0);
+    if (rc != 0) return false;
+
+    for (size_t i=0; i<status.size(); ++i) {
+        nodes[i] = (status[i] >= 0) ? status[i] : -1; // Negative values are -errno, e.g. -ENOENT for untouched pages
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 } // JCpuInfo namespace
 
@@ -15,6 +15,7 @@
 
 
 #include <thread>
+#include <vector>
 
 namespace JCpuInfo {
 
@@ -24,4 +25,11 @@ namespace JCpuInfo {
 
     bool PinThreadToCpu(std::thread *thread, size_t cpu_id);
 
+    /// Restricts the calling thread to the given set of cpus. Returns false if unsupported or unsuccessful.
+    bool PinCurrentThreadToCpus(const std::vector<size_t>& cpu_ids);
+
+    /// Looks up which NUMA node holds the page backing each address. Pages which haven't been touched yet,
+    /// or whose node can't be determined, are reported as -1. Returns false if unsupported on this platform.
+    bool GetNumaNodes(const std::vector<const void*>& addresses, std::vector<int>& nodes);
+
 }
@@ -8,12 +8,14 @@
 #include <JANA/JEvent.h>
 #include <JANA/Services/JComponentManager.h>
 #include <JANA/Topology/JPool.h>
+#include <JANA/Utils/JTaskQueue.h>
 
 
 class JEventPool : public JPool<std::shared_ptr<JEvent>> {
 
     std::shared_ptr<JComponentManager> m_component_manager;
     JEventLevel m_level;
+    JTaskQueue* m_task_queue = nullptr;
 
 public:
     inline JEventPool(std::shared_ptr<JComponentManager> component_manager,
@@ -26,15 +28,34 @@ public:
         , m_level(level) {
     }
 
+    /// If set, each event's factories may run in parallel, with their tasks going onto task_queue.
+    /// Must be called before init().
+    void set_task_queue(JTaskQueue* task_queue) {
+        m_task_queue = task_queue;
+    }
+
     void configure_item(std::shared_ptr<JEvent>* item) override {
         (*item) = std::make_shared<JEvent>();
         m_component_manager->configure_event(**item);
         item->get()->SetLevel(m_level); // This needs to happen _after_ configure_event
+        if (m_task_queue != nullptr) {
+            item->get()->GetFactorySet()->EnableFactoryDag(m_task_queue);
+        }
+    }
+
+    void get_item_addresses(std::shared_ptr<JEvent>* item, std::vector<const void*>& addresses) override {
+        addresses.push_back(item);
+        addresses.push_back(item->get());
+        addresses.push_back(item->get()->GetFactorySet());
+        for (JFactory* factory : item->get()->GetFactorySet()->GetAllFactories()) {
+            addresses.push_back(factory);
+        }
     }
 
     void release_item(std::shared_ptr<JEvent>* item) override {
         if (auto source = (*item)->GetJEventSource()) source->DoFinish(**item);
         (*item)->mFactorySet->Release();
+        (*item)->mArena.Reset(); // Only after the factories have let go of any arena objects
         (*item)->mInspector.Reset();
         (*item)->GetJCallGraphRecorder()->Reset();
         (*item)->Reset();
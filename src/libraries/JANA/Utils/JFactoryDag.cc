@@ -0,0 +1,207 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JFactoryDag.h"
+
+#include <JANA/JEvent.h>
+#include <JANA/JFactorySet.h>
+#include <JANA/JMultifactory.h>
+#include <JANA/Status/JComponentSummary.h>
+
+#include <algorithm>
+#include <chrono>
+
+
+JFactoryDag::JFactoryDag(JFactorySet* factory_set, JTaskQueue* task_queue)
+    : m_factory_set(factory_set), m_task_queue(task_queue) {
+
+    // Without call-once Create(), two nodes lazily pulling the same undeclared factory would both run it
+    if (!factory_set->IsConcurrentCreateEnabled()) {
+        throw JException("JFactoryDag: JFactorySet must be in concurrent-create mode");
+    }
+}
+
+
+void JFactoryDag::build() {
+
+    JEventLevel level = m_factory_set->GetLevel();
+    auto is_local = [&](JEventLevel l) { return l == level || l == JEventLevel::None; };
+
+    for (JMultifactory* multifactory : m_factory_set->GetAllMultifactories()) {
+        if (!multifactory->AreInputsDeclared() || multifactory->GetLevel() != level) continue;
+
+        JComponentSummary summary;
+        multifactory->Summarize(summary);
+        auto components = summary.GetAllComponents();
+        if (components.empty()) continue;
+        const JComponentSummary::Component* component = components.back();
+
+        Node node;
+        node.name = component->GetPrefix();
+        for (const auto* input : component->GetInputs()) {
+            node.inputs.push_back({input->GetTypeName(), input->GetName(), input->GetLevel()});
+        }
+        for (const auto* output : component->GetOutputs()) {
+            node.outputs.push_back({output->GetTypeName(), output->GetName(), output->GetLevel()});
+        }
+        if (node.outputs.empty()) continue;
+
+        node.helper = m_factory_set->GetFactory(node.outputs[0].type_name, node.outputs[0].name);
+        if (node.helper == nullptr) continue; // Leave it to lazy pulls
+
+        size_t index = m_nodes.size();
+        for (const Target& output : node.outputs) {
+            m_producers[{output.type_name, output.name}] = index;
+        }
+        m_nodes.push_back(std::move(node));
+    }
+
+    for (size_t i=0; i<m_nodes.size(); ++i) {
+        Node& node = m_nodes[i];
+        for (const Target& input : node.inputs) {
+            if (!is_local(input.level)) continue;
+            auto it = m_producers.find({input.type_name, input.name});
+            if (it == m_producers.end() || it->second == i) continue;
+            if (std::find(node.upstreams.begin(), node.upstreams.end(), it->second) == node.upstreams.end()) {
+                node.upstreams.push_back(it->second);
+            }
+        }
+    }
+
+    m_pending_upstreams.reset(new std::atomic<size_t>[m_nodes.size()]);
+    m_is_built = true;
+}
+
+
+const JFactoryDag::Plan& JFactoryDag::get_plan(const void* consumer, const std::function<std::vector<Target>()>& get_targets) {
+
+    auto it = m_plans.find(consumer);
+    if (it != m_plans.end()) return it->second;
+
+    if (!m_is_built) build();
+
+    JEventLevel level = m_factory_set->GetLevel();
+    size_t node_count = m_nodes.size();
+
+    Plan plan;
+    plan.upstream_counts.assign(node_count, 0);
+    plan.downstreams.assign(node_count, {});
+
+    enum class Mark { Unvisited, Visiting, Visited };
+    std::vector<Mark> marks(node_count, Mark::Unvisited);
+
+    // Depth-first, so that the post-order is a topological order
+    std::function<void(size_t)> visit = [&](size_t index) {
+        if (marks[index] == Mark::Visited) return;
+        if (marks[index] == Mark::Visiting) {
+            throw JException("JFactoryDag: Factory '%s' depends on its own output", m_nodes[index].name.c_str());
+        }
+        marks[index] = Mark::Visiting;
+        for (size_t upstream : m_nodes[index].upstreams) {
+            visit(upstream);
+            plan.downstreams[upstream].push_back(index);
+            plan.upstream_counts[index] += 1;
+        }
+        marks[index] = Mark::Visited;
+        plan.nodes.push_back(index);
+    };
+
+    for (const Target& target : get_targets()) {
+        if (target.level != level && target.level != JEventLevel::None) continue;
+        auto producer = m_producers.find({target.type_name, target.name});
+        if (producer != m_producers.end()) {
+            visit(producer->second);
+        }
+    }
+    return m_plans.emplace(consumer, std::move(plan)).first->second;
+}
+
+
+void JFactoryDag::submit(const Plan& plan, size_t node, const std::shared_ptr<const JEvent>& event) {
+    m_task_queue->push([this, &plan, node, event]() { run_node(plan, node, event); });
+}
+
+
+void JFactoryDag::run_node(const Plan& plan, size_t node, const std::shared_ptr<const JEvent>& event) {
+
+    // Once something has failed, we still walk the rest of the plan so that the counts come out right,
+    // but we don't run anything else
+    if (!m_failed.load()) {
+        try {
+            m_nodes[node].helper->Create(event);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(m_exception_mutex);
+            if (!m_failed.exchange(true)) {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+    for (size_t downstream : plan.downstreams[node]) {
+        if (m_pending_upstreams[downstream].fetch_sub(1) == 1) {
+            submit(plan, downstream, event);
+        }
+    }
+    if (m_remaining_nodes.fetch_sub(1) == 1) {
+        // Wake up the thread waiting in Prefetch()
+        m_task_queue->get_wait_object().notify();
+    }
+}
+
+
+void JFactoryDag::Prefetch(const std::shared_ptr<const JEvent>& event,
+                           const void* consumer,
+                           const std::function<std::vector<Target>()>& get_targets) {
+
+    const Plan& plan = get_plan(consumer, get_targets);
+    if (plan.nodes.empty()) return;
+
+    m_failed = false;
+    m_exception = nullptr;
+    for (size_t node : plan.nodes) {
+        m_pending_upstreams[node].store(plan.upstream_counts[node]);
+    }
+    m_remaining_nodes.store(plan.nodes.size());
+
+    for (size_t node : plan.nodes) {
+        if (plan.upstream_counts[node] == 0) {
+            submit(plan, node, event);
+        }
+    }
+
+    // Help out until our plan is finished. The tasks we run along the way may well belong to other events.
+    JWaitObject& wait_object = m_task_queue->get_wait_object();
+    while (m_remaining_nodes.load() != 0) {
+        if (m_task_queue->try_run_one()) continue;
+        uint64_t epoch = wait_object.prepare_wait();
+        if (m_remaining_nodes.load() == 0 || m_task_queue->size() != 0) {
+            wait_object.cancel_wait();
+            continue;
+        }
+        wait_object.commit_wait(epoch, std::chrono::microseconds(100));
+    }
+
+    if (m_exception) {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+
+size_t JFactoryDag::GetNodeCount() {
+    if (!m_is_built) build();
+    return m_nodes.size();
+}
+
+
+std::vector<std::string> JFactoryDag::GetPlannedNodes(const void* consumer) const {
+    std::vector<std::string> results;
+    auto it = m_plans.find(consumer);
+    if (it != m_plans.end()) {
+        for (size_t node : it->second.nodes) {
+            results.push_back(m_nodes[node].name);
+        }
+    }
+    return results;
+}
+
@@ -0,0 +1,97 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/Utils/JEventLevel.h>
+#include <JANA/Utils/JTaskQueue.h>
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class JEvent;
+class JFactory;
+class JFactorySet;
+
+/// JFactoryDag runs the factories an event needs in parallel, as far as their declared inputs and outputs allow.
+///
+/// Each JFactorySet (i.e. each pooled event) gets its own JFactoryDag, built lazily the first time somebody
+/// prefetches through it. Every multifactory which declares its inputs up front (i.e. every JOmniFactory) becomes
+/// a node, with an edge from whichever node produces each of its inputs. When a consumer (e.g. a JEventProcessor)
+/// prefetches its own inputs, the DAG submits every node they transitively depend on to the JTaskQueue as soon as
+/// that node's own inputs are ready, and the calling thread helps run tasks until they are all finished.
+///
+/// Factories which don't declare their inputs are not nodes. They are pulled lazily, exactly as before, by
+/// whichever node (or consumer) asks for them. Inputs from other event levels are also left to lazy pulls.
+/// Enabling the DAG puts the JFactorySet into concurrent-create mode, so two nodes which pull the same factory at
+/// the same time still only run it once.
+class JFactoryDag {
+public:
+    /// A collection which somebody wants, identified the same way as in JComponentSummary
+    struct Target {
+        std::string type_name;
+        std::string name;
+        JEventLevel level = JEventLevel::None;
+    };
+
+private:
+    struct Node {
+        std::string name;            // Factory prefix, for error messages
+        JFactory* helper = nullptr;  // Creating any one of the node's outputs runs the whole node
+        std::vector<Target> inputs;
+        std::vector<Target> outputs;
+        std::vector<size_t> upstreams;
+    };
+
+    /// A Plan is the subset of the DAG needed by one consumer
+    struct Plan {
+        std::vector<size_t> nodes;                       // Topologically sorted
+        std::vector<size_t> upstream_counts;             // Indexed by node, only meaningful for nodes in the plan
+        std::vector<std::vector<size_t>> downstreams;    // Indexed by node, restricted to the plan
+    };
+
+    JFactorySet* m_factory_set;
+    JTaskQueue* m_task_queue;
+    std::vector<Node> m_nodes;
+    std::map<std::pair<std::string, std::string>, size_t> m_producers;  // {(type_name, name): node}
+    std::map<const void*, Plan> m_plans;                                 // {consumer: plan}
+    bool m_is_built = false;
+
+    // Per-event execution state. Only one event uses a given JFactorySet at a time.
+    std::unique_ptr<std::atomic<size_t>[]> m_pending_upstreams;
+    std::atomic<size_t> m_remaining_nodes {0};
+    std::atomic<bool> m_failed {false};
+    std::exception_ptr m_exception;
+    std::mutex m_exception_mutex;
+
+    void build();
+    const Plan& get_plan(const void* consumer, const std::function<std::vector<Target>()>& get_targets);
+    void submit(const Plan& plan, size_t node, const std::shared_ptr<const JEvent>& event);
+    void run_node(const Plan& plan, size_t node, const std::shared_ptr<const JEvent>& event);
+
+public:
+    JFactoryDag(JFactorySet* factory_set, JTaskQueue* task_queue);
+
+    JFactoryDag(const JFactoryDag&) = delete;
+    JFactoryDag& operator=(const JFactoryDag&) = delete;
+
+    /// Runs every declared factory that `consumer`'s targets depend on, in parallel where possible, and returns
+    /// once they have all finished. `get_targets` is only called the first time a given consumer shows up.
+    /// If any factory throws, the first exception is rethrown here once everything in flight has stopped.
+    void Prefetch(const std::shared_ptr<const JEvent>& event,
+                  const void* consumer,
+                  const std::function<std::vector<Target>()>& get_targets);
+
+    size_t GetNodeCount();
+
+    /// The nodes needed by a consumer which has already prefetched, in the order they were planned
+    std::vector<std::string> GetPlannedNodes(const void* consumer) const;
+};
+
+
@@ -0,0 +1,63 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/Utils/JFactoryIndex.h>
+#include <atomic>
+#include <string>
+
+/// JFactoryHandle<T> names a collection, i.e. a (T, tag) pair, in a form which JEvent can look up without any
+/// string work. Create one once (e.g. as a member, or in Init()), and then call `event.Get(handle)` for each event.
+///
+/// The first Get() through a handle resolves default tags and finds the factory's slot in the JFactoryIndex. Since
+/// every pooled event shares the same JFactoryIndex, each later Get() is just a couple of loads. Handles may be shared
+/// between threads. Collections which have no slot (e.g. those only ever made via JEvent::Insert()) still work; they
+/// just take the slower lookup by tag.
+template <typename T>
+class JFactoryHandle {
+
+    std::string m_tag;
+
+    // Resolution cache, written once by whichever thread gets there first
+    mutable std::atomic_bool m_claimed {false};
+    mutable std::atomic<const JFactoryIndex*> m_index {nullptr};
+    mutable std::atomic<size_t> m_slot {JFactoryIndex::npos};
+
+public:
+    JFactoryHandle() = default;
+    explicit JFactoryHandle(std::string tag) : m_tag(std::move(tag)) {}
+
+    // Copies start out unresolved
+    JFactoryHandle(const JFactoryHandle& other) : m_tag(other.m_tag) {}
+    JFactoryHandle& operator=(const JFactoryHandle& other) {
+        if (this != &other) {
+            m_tag = other.m_tag;
+            m_claimed = false;
+            m_index = nullptr;
+            m_slot = JFactoryIndex::npos;
+        }
+        return *this;
+    }
+
+    const std::string& GetTag() const { return m_tag; }
+
+    /// Returns true and sets slot if this handle has already been resolved against index.
+    /// The slot may be JFactoryIndex::npos, meaning that the index doesn't know about this collection.
+    bool GetCachedSlot(const JFactoryIndex* index, size_t& slot) const {
+        if (m_index.load(std::memory_order_acquire) != index) return false;
+        slot = m_slot.load(std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Remembers the slot for index. Only the first resolution sticks; all events from the same
+    /// JComponentManager share one index anyway, so there is never a reason to change it.
+    void CacheSlot(const JFactoryIndex* index, size_t slot) const {
+        bool expected = false;
+        if (!m_claimed.compare_exchange_strong(expected, true)) return;
+        m_slot.store(slot, std::memory_order_relaxed);
+        m_index.store(index, std::memory_order_release);
+    }
+};
+
+
@@ -0,0 +1,34 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JFactoryIndex.h"
+
+#include <mutex>
+#include <unordered_map>
+
+
+size_t JFactoryIndex::GetTypeId(std::type_index type) {
+    // This lives in libJANA rather than in each plugin, so every shared library agrees on the ids
+    static std::mutex mutex;
+    static std::unordered_map<std::type_index, size_t> type_ids;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto result = type_ids.emplace(type, type_ids.size());
+    return result.first->second;
+}
+
+
+size_t JFactoryIndex::Add(std::type_index type, const std::string& tag) {
+    size_t type_id = GetTypeId(type);
+    size_t slot = FindSlot(type_id, tag);
+    if (slot != npos) return slot;
+
+    if (type_id >= m_slots_by_type.size()) {
+        m_slots_by_type.resize(type_id + 1);
+    }
+    slot = m_slot_count++;
+    m_slots_by_type[type_id].emplace_back(tag, slot);
+    return slot;
+}
+
@@ -0,0 +1,62 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+/// JFactoryIndex assigns every (type, tag) which the factory generators produce a dense integer slot, so that
+/// JFactorySet can keep its factories in a flat vector and JEvent::Get<T>(tag) can find them without a map lookup.
+///
+/// JComponentManager builds one JFactoryIndex when it initializes the components and shares it, read-only, with the
+/// JFactorySet of every pooled event. Since every pooled event comes from the same factory generators, a given
+/// (type, tag) lands in the same slot everywhere. Factories which show up later (e.g. via JEvent::Insert()) have no
+/// slot, and are found the old way.
+class JFactoryIndex {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /// A dense, process-wide id for each type. Ids are handed out on first use and never change.
+    static size_t GetTypeId(std::type_index type);
+
+    /// Like GetTypeId(std::type_index), but only pays for the lookup once per type (per shared library)
+    template <typename T>
+    static size_t GetTypeId() {
+        static const size_t type_id = GetTypeId(std::type_index(typeid(T)));
+        return type_id;
+    }
+
+    /// Assigns (type, tag) the next free slot, unless it already has one. Returns the slot either way.
+    size_t Add(std::type_index type, const std::string& tag);
+
+    /// Returns npos if (type, tag) has no slot
+    size_t GetSlot(std::type_index type, const std::string& tag) const {
+        return FindSlot(GetTypeId(type), tag);
+    }
+
+    template <typename T>
+    size_t GetSlot(const std::string& tag) const {
+        return FindSlot(GetTypeId<T>(), tag);
+    }
+
+    size_t GetSlotCount() const { return m_slot_count; }
+
+private:
+    // Indexed by type id. Most types only have a handful of tags, so a linear scan of these beats hashing the tag.
+    std::vector<std::vector<std::pair<std::string, size_t>>> m_slots_by_type;
+    size_t m_slot_count = 0;
+
+    size_t FindSlot(size_t type_id, const std::string& tag) const {
+        if (type_id >= m_slots_by_type.size()) return npos;
+        for (const auto& entry : m_slots_by_type[type_id]) {
+            if (entry.first == tag) return entry.second;
+        }
+        return npos;
+    }
+};
+
+
@@ -0,0 +1,114 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JFactoryRegistry.h"
+
+#include <JANA/JFactoryGenerator.h>
+#include <JANA/JFactorySet.h>
+#include <JANA/JVersion.h>
+#include <algorithm>
+
+#if JANA2_HAVE_PODIO
+#include <JANA/Podio/JFactoryPodioT.h>
+#endif
+
+
+JFactoryRegistry::JFactoryRegistry(const std::vector<JFactoryGenerator*>& generators) {
+
+    for (size_t gen_index=0; gen_index<generators.size(); ++gen_index) {
+        GeneratorInfo gen_info;
+        gen_info.generator = generators[gen_index];
+
+        JFactorySet scratch;
+        generators[gen_index]->GenerateFactories(&scratch);
+
+        for (JFactory* factory : scratch.GetAllFactories()) {
+            auto typed_key = std::make_pair(factory->GetObjectType(), factory->GetTag());
+            auto untyped_key = std::make_pair(factory->GetObjectName(), factory->GetTag());
+
+            auto typed_it = m_factories_by_type.find(typed_key);
+            auto untyped_it = m_factories_by_name.find(untyped_key);
+            if (typed_it != m_factories_by_type.end() || untyped_it != m_factories_by_name.end()) {
+                // Shadowed by an earlier generator, which therefore has to be materialized before this one
+                size_t owner = m_factories[(typed_it != m_factories_by_type.end()) ? typed_it->second : untyped_it->second].generator;
+                if (owner != gen_index &&
+                    std::find(gen_info.predecessors.begin(), gen_info.predecessors.end(), owner) == gen_info.predecessors.end()) {
+                    gen_info.predecessors.push_back(owner);
+                }
+                continue;
+            }
+
+            size_t factory_index = m_factories.size();
+            m_factories.push_back({factory->GetObjectType(), factory->GetObjectName(), factory->GetTag(),
+                                   factory->GetFactoryName(), factory->GetPluginName(), gen_index});
+            m_factories_by_type[typed_key] = factory_index;
+            m_factories_by_name[untyped_key] = factory_index;
+
+            auto& gens_for_type = m_generators_by_type[factory->GetObjectType()];
+            if (gens_for_type.empty() || gens_for_type.back() != gen_index) {
+                gens_for_type.push_back(gen_index);
+            }
+#if JANA2_HAVE_PODIO
+            if (dynamic_cast<JFactoryPodio*>(factory) != nullptr) {
+                gen_info.eager = true;
+            }
+#endif
+        }
+        m_generators.push_back(std::move(gen_info));
+    }
+
+    m_materialized_counts.reset(new std::atomic<size_t>[m_generators.size()]);
+    for (size_t i=0; i<m_generators.size(); ++i) m_materialized_counts[i] = 0;
+    m_used.reset(new std::atomic<bool>[m_factories.size()]);
+    for (size_t i=0; i<m_factories.size(); ++i) m_used[i] = false;
+}
+
+
+size_t JFactoryRegistry::FindGenerator(std::type_index type, const std::string& tag) const {
+    size_t factory = FindFactory(type, tag);
+    return (factory == npos) ? npos : m_factories[factory].generator;
+}
+
+
+size_t JFactoryRegistry::FindGenerator(const std::string& object_name, const std::string& tag) const {
+    auto it = m_factories_by_name.find(std::make_pair(object_name, tag));
+    return (it == m_factories_by_name.end()) ? npos : m_factories[it->second].generator;
+}
+
+
+const std::vector<size_t>& JFactoryRegistry::FindGenerators(std::type_index type) const {
+    static const std::vector<size_t> none;
+    auto it = m_generators_by_type.find(type);
+    return (it == m_generators_by_type.end()) ? none : it->second;
+}
+
+
+size_t JFactoryRegistry::FindFactory(std::type_index type, const std::string& tag) const {
+    auto it = m_factories_by_type.find(std::make_pair(type, tag));
+    return (it == m_factories_by_type.end()) ? npos : it->second;
+}
+
+
+void JFactoryRegistry::RecordMaterialized(size_t generator) const {
+    m_materialized_counts[generator].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void JFactoryRegistry::RecordUsed(size_t factory) const {
+    // Check first, so that once a factory has been seen, nobody writes to the shared cache line again
+    if (!m_used[factory].load(std::memory_order_relaxed)) {
+        m_used[factory].store(true, std::memory_order_relaxed);
+    }
+}
+
+
+size_t JFactoryRegistry::GetMaterializedCount(size_t generator) const {
+    return m_materialized_counts[generator].load(std::memory_order_relaxed);
+}
+
+
+bool JFactoryRegistry::IsUsed(size_t factory) const {
+    return m_used[factory].load(std::memory_order_relaxed);
+}
+
@@ -0,0 +1,88 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+class JFactoryGenerator;
+
+/// JFactoryRegistry remembers which JFactoryGenerator provides each (type, tag), so that a pooled JFactorySet can
+/// run a generator only once something actually asks for one of its factories (see JFactorySet::SetRegistry).
+/// JComponentManager builds one of these when the jana:lazy_factories parameter is set, and shares it read-only
+/// with every pooled event.
+///
+/// Generators are still the unit of instantiation, since a JFactoryGenerator can only produce all of its factories
+/// at once. When two generators provide the same (type, tag), the earlier one wins, exactly as when a JFactorySet
+/// is built eagerly. To keep it that way, each generator records the earlier generators it collides with, and
+/// these get materialized first.
+///
+/// The registry also keeps track of which factories were ever used, for the report at the end of the run.
+class JFactoryRegistry {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    struct FactoryInfo {
+        std::type_index type;
+        std::string object_name;
+        std::string tag;
+        std::string factory_name;
+        std::string plugin_name;
+        size_t generator;
+    };
+
+    /// Runs each generator once, into a scratch JFactorySet, to find out what it provides
+    explicit JFactoryRegistry(const std::vector<JFactoryGenerator*>& generators);
+
+    size_t GetGeneratorCount() const { return m_generators.size(); }
+    JFactoryGenerator* GetGenerator(size_t generator) const { return m_generators[generator].generator; }
+
+    /// Earlier generators which provide some of the same (type, tag)s as this one
+    const std::vector<size_t>& GetPredecessors(size_t generator) const { return m_generators[generator].predecessors; }
+
+    /// Generators which can't be deferred, e.g. because they provide PODIO factories, which JEvent indexes up front
+    bool IsEager(size_t generator) const { return m_generators[generator].eager; }
+
+    /// Which generator provides (type, tag), or npos
+    size_t FindGenerator(std::type_index type, const std::string& tag) const;
+    size_t FindGenerator(const std::string& object_name, const std::string& tag) const;
+
+    /// Every generator which provides some tag of this type
+    const std::vector<size_t>& FindGenerators(std::type_index type) const;
+
+    /// Index into GetFactories() for (type, tag), or npos
+    size_t FindFactory(std::type_index type, const std::string& tag) const;
+
+    const std::vector<FactoryInfo>& GetFactories() const { return m_factories; }
+
+    /// Called by JFactorySet. These only touch atomics, so any thread may call them.
+    void RecordMaterialized(size_t generator) const;
+    void RecordUsed(size_t factory) const;
+
+    size_t GetMaterializedCount(size_t generator) const;
+    bool IsUsed(size_t factory) const;
+
+private:
+    struct GeneratorInfo {
+        JFactoryGenerator* generator;
+        std::vector<size_t> predecessors;
+        bool eager = false;
+    };
+
+    std::vector<GeneratorInfo> m_generators;
+    std::vector<FactoryInfo> m_factories;
+    std::map<std::pair<std::type_index, std::string>, size_t> m_factories_by_type;
+    std::map<std::pair<std::string, std::string>, size_t> m_factories_by_name;
+    std::map<std::type_index, std::vector<size_t>> m_generators_by_type;
+
+    std::unique_ptr<std::atomic<size_t>[]> m_materialized_counts;
+    std::unique_ptr<std::atomic<bool>[]> m_used;
+};
+
@@ -0,0 +1,78 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JMappedFile.h"
+#include <JANA/JException.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+std::shared_ptr<const JMappedFile> JMappedFile::Open(const std::string& path) {
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw JException("Unable to open '%s': %s", path.c_str(), strerror(errno));
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw JException("Unable to stat '%s': %s", path.c_str(), strerror(error));
+    }
+
+    std::shared_ptr<JMappedFile> file(new JMappedFile);
+    file->m_path = path;
+    file->m_size = static_cast<size_t>(file_stat.st_size);
+
+    // mmap() refuses zero-length mappings, so an empty file simply has no data
+    if (file->m_size != 0) {
+        void* data = ::mmap(nullptr, file->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int error = errno;
+            ::close(fd);
+            throw JException("Unable to mmap '%s': %s", path.c_str(), strerror(error));
+        }
+        file->m_data = static_cast<const char*>(data);
+    }
+    // The mapping holds its own reference to the file, so the descriptor isn't needed past this point
+    ::close(fd);
+    return file;
+}
+
+
+JMappedFile::~JMappedFile() {
+    if (m_data != nullptr) {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+}
+
+
+size_t JMappedFile::GetPageSize() {
+    static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+
+void JMappedFile::Advise(size_t offset, size_t length, Advice advice) const {
+    if (m_data == nullptr || offset >= m_size) return;
+
+    size_t end = std::min(m_size, offset + length);
+    size_t begin = offset - (offset % GetPageSize());
+
+    int flag = MADV_NORMAL;
+    switch (advice) {
+        case Advice::Normal: flag = MADV_NORMAL; break;
+        case Advice::Sequential: flag = MADV_SEQUENTIAL; break;
+        case Advice::WillNeed: flag = MADV_WILLNEED; break;
+        case Advice::DontNeed: flag = MADV_DONTNEED; break;
+    }
+    ::madvise(const_cast<char*>(m_data) + begin, end - begin, flag);
+}
+
@@ -0,0 +1,41 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/// JMappedFile maps a whole file read-only into memory and unmaps it when destroyed. It is meant to be held by
+/// std::shared_ptr, so that anything still pointing into the mapping (e.g. a JMappedView inside an event that is in
+/// flight) keeps it alive after the JEventSourceMmap which created it has closed.
+class JMappedFile {
+public:
+    enum class Advice { Normal, Sequential, WillNeed, DontNeed };
+
+    /// Maps `path`, throwing a JException if the file can't be opened or mapped
+    static std::shared_ptr<const JMappedFile> Open(const std::string& path);
+
+    ~JMappedFile();
+    JMappedFile(const JMappedFile&) = delete;
+    JMappedFile& operator=(const JMappedFile&) = delete;
+
+    const char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+    const std::string& GetPath() const { return m_path; }
+
+    /// Passes an madvise() hint for [offset, offset+length) to the kernel. The range is widened to page boundaries
+    /// and clipped to the file. Hints are best-effort, so failures are ignored.
+    void Advise(size_t offset, size_t length, Advice advice) const;
+
+    static size_t GetPageSize();
+
+private:
+    JMappedFile() = default;
+
+    std::string m_path;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
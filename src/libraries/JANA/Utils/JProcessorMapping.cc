@@ -5,146 +5,350 @@
 #include "JProcessorMapping.h"
 
 #include <JANA/Utils/JTablePrinter.h>
-#include <iomanip>
-#include <unistd.h>
-#include <sys/wait.h>
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <tuple>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
-void JProcessorMapping::initialize(AffinityStrategy affinity, LocalityStrategy locality) {
+namespace {
 
-    m_affinity_strategy = affinity;
-    m_locality_strategy = locality;
+bool read_first_line(const std::string& path, std::string& line) {
+    std::ifstream infile(path);
+    if (!infile.good()) return false;
+    std::getline(infile, line);
+    return true;
+}
 
-    if (affinity == AffinityStrategy::None && locality == LocalityStrategy::Global) {
-        // User doesn't care about NUMA awareness, so we can skip building the processor map completely
-        m_error_msg = ""; // Denotes "no error" as used by stringifier
-        return;
-    }
+bool read_number(const std::string& path, long& value) {
+    std::string line;
+    if (!read_first_line(path, line)) return false;
+    std::istringstream iss(line);
+    return static_cast<bool>(iss >> value);
+}
 
-    // Capture lscpu info
+} // namespace
 
-    int pipe_fd[2]; // We want to pipe lscpu's stdout straight to us
-    if (pipe(pipe_fd) == -1) {
-        m_error_msg = "Unable to open pipe";
-        return;
-    }
-    pid_t pid = fork();
-    if (pid == -1) { // Failure
-        m_error_msg = "Unable to fork";
-        close(pipe_fd[0]);
-        close(pipe_fd[1]);
-        return;
+
+std::vector<size_t> JProcessorMapping::parse_cpu_list(const std::string& list) {
+    std::vector<size_t> result;
+    std::istringstream iss(list);
+    std::string range;
+    while (std::getline(iss, range, ',')) {
+        size_t first, last;
+        int count = sscanf(range.c_str(), "%zu-%zu", &first, &last);
+        if (count == 1) {
+            result.push_back(first);
+        }
+        else if (count == 2) {
+            for (size_t cpu=first; cpu<=last; ++cpu) result.push_back(cpu);
+        }
     }
-    else if (pid == 0) { // We are the child process
-        dup2(pipe_fd[1], 1);  // Redirect stdout to pipe
-        close(pipe_fd[0]);
-        close(pipe_fd[1]);
-        execlp("lscpu", "lscpu", "-b", "-pcpu,core,node,socket", (char*) nullptr);
-        // Unreachable
-        exit(-1);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+
+/// read_allowed_cpus() returns the cpus this process may actually run on, or an empty vector if there is no restriction.
+std::vector<size_t> JProcessorMapping::read_allowed_cpus() const {
+    std::vector<size_t> allowed;
+    std::string line;
+
+    // Containers usually restrict us via the cgroup cpuset (v2 first, then v1)
+    if (read_first_line(m_sysfs_root + "/fs/cgroup/cpuset.cpus.effective", line) ||
+        read_first_line(m_sysfs_root + "/fs/cgroup/cpuset/cpuset.effective_cpus", line)) {
+        allowed = parse_cpu_list(line);
     }
-    else { // We are the parent process
-        close(pipe_fd[1]);
+
+#ifdef __linux__
+    // The process affinity mask already reflects the cpuset, plus anything taskset/numactl did to us
+    if (m_sysfs_root == "/sys") {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0) {
+            std::vector<size_t> affinity;
+            for (size_t cpu=0; cpu<CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &cpuset)) affinity.push_back(cpu);
+            }
+            if (allowed.empty()) {
+                allowed = affinity;
+            }
+            else {
+                std::vector<size_t> intersection;
+                std::set_intersection(allowed.begin(), allowed.end(), affinity.begin(), affinity.end(),
+                                      std::back_inserter(intersection));
+                allowed = intersection;
+            }
+        }
     }
+#endif
+    return allowed;
+}
 
-    // In case initialize() is called multiple times, we don't want old data to interfere
-    m_loc_count = 1;
-    m_mapping.clear();
 
-    // Parse into table
-    FILE* infile = fdopen(pipe_fd[0], "r");
+/// read_topology() fills m_mapping with one row per usable cpu, ordered by cpu id. It does not assign locations.
+bool JProcessorMapping::read_topology() {
 
-    const size_t buffer_size = 300;
-    char buffer[buffer_size];
+    std::string cpu_dir = m_sysfs_root + "/devices/system/cpu";
+    std::string node_dir = m_sysfs_root + "/devices/system/node";
+    std::string line;
 
-    while (fgets(buffer, buffer_size, infile) != nullptr) {
-        if (buffer[0] == '#') continue;
-        Row row;
-        int count = sscanf(buffer, "%zu,%zu,%zu,%zu", &row.cpu_id, &row.core_id, &row.numa_domain_id, &row.socket_id);
-        if (count == 4) {
-            switch (m_locality_strategy) {
-                case LocalityStrategy::CpuLocal:        row.location_id = row.cpu_id; break;
-                case LocalityStrategy::CoreLocal:       row.location_id = row.core_id; break;
-                case LocalityStrategy::NumaDomainLocal: row.location_id = row.numa_domain_id; break;
-                case LocalityStrategy::SocketLocal:     row.location_id = row.socket_id; break;
-                case LocalityStrategy::Global:
-                default:                                row.location_id = 0; break;
-            }
-            if (row.location_id >= m_loc_count) {
-                // Assume all of these ids are zero-indexed and contiguous
-                m_loc_count = row.location_id + 1;
+    if (!read_first_line(cpu_dir + "/online", line)) {
+        m_error_msg = "Unable to read " + cpu_dir + "/online";
+        return false;
+    }
+    std::vector<size_t> cpus = parse_cpu_list(line);
+    std::vector<size_t> allowed = read_allowed_cpus();
+    if (!allowed.empty()) {
+        std::vector<size_t> intersection;
+        std::set_intersection(cpus.begin(), cpus.end(), allowed.begin(), allowed.end(), std::back_inserter(intersection));
+        cpus = intersection;
+    }
+    if (cpus.empty()) {
+        m_error_msg = "No usable cpus found in " + cpu_dir;
+        return false;
+    }
+
+    // NUMA domain membership. On machines without NUMA support the node directory is missing,
+    // in which case we treat each socket as its own domain, same as we always have.
+    std::map<size_t, size_t> cpu_to_numa_domain;
+    std::vector<size_t> nodes;
+    if (read_first_line(node_dir + "/online", line)) {
+        nodes = parse_cpu_list(line); // Same list format
+    }
+    for (size_t node : nodes) {
+        if (read_first_line(node_dir + "/node" + std::to_string(node) + "/cpulist", line)) {
+            for (size_t cpu : parse_cpu_list(line)) {
+                cpu_to_numa_domain[cpu] = node;
             }
-            m_mapping.push_back(row);
         }
-        else {
-            // On machines with no NUMA domains, lscpu returns "" instead of "0"
-            int count = sscanf(buffer, "%zu,%zu,,%zu", &row.cpu_id, &row.core_id, &row.socket_id);
-            row.numa_domain_id = row.socket_id;
-            if (count == 3) {
-                switch (m_locality_strategy) {
-                    case LocalityStrategy::CpuLocal:        row.location_id = row.cpu_id; break;
-                    case LocalityStrategy::CoreLocal:       row.location_id = row.core_id; break;
-                    case LocalityStrategy::NumaDomainLocal: row.location_id = row.numa_domain_id; break;
-                    case LocalityStrategy::SocketLocal:     row.location_id = row.socket_id; break;
-                    case LocalityStrategy::Global:
-                    default:                                row.location_id = 0; break;
-                }
-                if (row.location_id >= m_loc_count) {
-                    // Assume all of these ids are zero-indexed and contiguous
-                    m_loc_count = row.location_id + 1;
-                }
-                m_mapping.push_back(row);
+    }
+
+    // Core classes. Intel hybrid parts list their E-cores under cpu_atom. Elsewhere (e.g. ARM big.LITTLE)
+    // we fall back to cpu_capacity, where anything below the maximum capacity counts as an efficiency core.
+    std::map<size_t, size_t> cpu_to_core_class;
+    if (read_first_line(m_sysfs_root + "/devices/cpu_atom/cpus", line)) {
+        for (size_t cpu : parse_cpu_list(line)) {
+            cpu_to_core_class[cpu] = 1;
+        }
+    }
+    else {
+        std::map<size_t, long> capacities;
+        long max_capacity = 0;
+        for (size_t cpu : cpus) {
+            long capacity;
+            if (read_number(cpu_dir + "/cpu" + std::to_string(cpu) + "/cpu_capacity", capacity)) {
+                capacities[cpu] = capacity;
+                max_capacity = std::max(max_capacity, capacity);
             }
+        }
+        for (auto& pair : capacities) {
+            if (pair.second < max_capacity) cpu_to_core_class[pair.first] = 1;
+        }
+    }
+
+    // The kernel's core_ids are only unique within a socket, and may have gaps. Like lscpu,
+    // we hand out logical core ids and L3 ids in order of first appearance.
+    std::map<std::pair<long, long>, size_t> core_ids;
+    std::map<std::string, size_t> l3_ids;
+    std::map<size_t, size_t> core_thread_counts;
+
+    for (size_t cpu : cpus) {
+        std::string topology_dir = cpu_dir + "/cpu" + std::to_string(cpu) + "/topology";
+        long socket = 0;
+        long core = static_cast<long>(cpu);
+        if (!read_number(topology_dir + "/physical_package_id", socket) || socket < 0) socket = 0;
+        if (!read_number(topology_dir + "/core_id", core) || core < 0) core = static_cast<long>(cpu);
 
+        // Find this cpu's L3, identified by the set of cpus sharing it. Without one, the socket stands in.
+        std::string l3_key = "socket" + std::to_string(socket);
+        for (size_t index=0; ; ++index) {
+            std::string cache_dir = cpu_dir + "/cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index);
+            long level;
+            if (!read_number(cache_dir + "/level", level)) break;
+            if (level == 3 && read_first_line(cache_dir + "/shared_cpu_list", line)) {
+                l3_key = line;
+                break;
+            }
         }
+
+        Row row;
+        row.location_id = 0;
+        row.cpu_id = cpu;
+        row.socket_id = static_cast<size_t>(socket);
+        row.core_id = core_ids.emplace(std::make_pair(socket, core), core_ids.size()).first->second;
+        row.l3_id = l3_ids.emplace(l3_key, l3_ids.size()).first->second;
+        row.smt_index = core_thread_counts[row.core_id]++;
+        auto numa_it = cpu_to_numa_domain.find(cpu);
+        row.numa_domain_id = (numa_it == cpu_to_numa_domain.end()) ? row.socket_id : numa_it->second;
+        auto class_it = cpu_to_core_class.find(cpu);
+        row.core_class = (class_it == cpu_to_core_class.end()) ? 0 : class_it->second;
+        m_mapping.push_back(row);
     }
-    fclose(infile);
-    int status = 0;
-    waitpid(pid, &status, 0);  // Wait for child to exit and acknowledge. This prevents child from becoming a zombie.
+    return true;
+}
+
+
+void JProcessorMapping::initialize(AffinityStrategy affinity, LocalityStrategy locality) {
+
+    m_affinity_strategy = affinity;
+    m_locality_strategy = locality;
 
-    if (!WIFEXITED(status)) {
-        m_error_msg = "lscpu child process returned abnormally";
+    // In case initialize() is called multiple times, we don't want old data to interfere
+    m_loc_count = 1;
+    m_mapping.clear();
+    m_loc_distances.clear();
+    m_initialized = false;
+
+    if (affinity == AffinityStrategy::None && locality == LocalityStrategy::Global) {
+        // User doesn't care about NUMA awareness, so we can skip building the processor map completely
+        m_error_msg = ""; // Denotes "no error" as used by stringifier
         return;
     }
-    else if (WEXITSTATUS(status) != 0) {
-        m_error_msg = "lscpu child process returned with an exit code of " + std::to_string(WEXITSTATUS(status));
+
+    if (!read_topology()) {
+        m_mapping.clear();
         return;
     }
-    else if (m_mapping.empty()){
-        m_error_msg = "Unable to parse lscpu output";
-        return;
+
+    // Assign locations. Ids are renumbered densely, since a cpuset may leave gaps (e.g. only NUMA domain 1)
+    std::map<size_t, size_t> location_ids;
+    for (Row& row : m_mapping) {
+        size_t raw_location_id;
+        switch (m_locality_strategy) {
+            case LocalityStrategy::CpuLocal:        raw_location_id = row.cpu_id; break;
+            case LocalityStrategy::CoreLocal:       raw_location_id = row.core_id; break;
+            case LocalityStrategy::CacheLocal:      raw_location_id = row.l3_id; break;
+            case LocalityStrategy::NumaDomainLocal: raw_location_id = row.numa_domain_id; break;
+            case LocalityStrategy::SocketLocal:     raw_location_id = row.socket_id; break;
+            case LocalityStrategy::Global:
+            default:                                raw_location_id = 0; break;
+        }
+        row.location_id = location_ids.emplace(raw_location_id, location_ids.size()).first->second;
     }
+    m_loc_count = location_ids.size();
 
-    // Apply affinity strategy by sorting over sets of columns
+    // Apply affinity strategy by sorting over sets of columns. Rows start out ordered by cpu id.
     switch (m_affinity_strategy) {
 
         case AffinityStrategy::ComputeBound:
 
+            // Performance cores first, then efficiency cores. On non-hybrid cpus this is just cpu order.
             std::stable_sort(m_mapping.begin(), m_mapping.end(),
-                             [](const Row& lhs, const Row& rhs) -> bool { return lhs.cpu_id < rhs.cpu_id; });
+                             [](const Row& lhs, const Row& rhs) -> bool { return lhs.core_class < rhs.core_class; });
             break;
 
         case AffinityStrategy::MemoryBound:
 
             std::stable_sort(m_mapping.begin(), m_mapping.end(),
-                             [](const Row& lhs, const Row& rhs) -> bool { return lhs.cpu_id < rhs.cpu_id; });
+                             [](const Row& lhs, const Row& rhs) -> bool { return lhs.numa_domain_id < rhs.numa_domain_id; });
+            break;
 
+        case AffinityStrategy::CacheBound:
+
+            // Pack workers onto as few L3s as possible: fill one L3's physical cores (performance cores first),
+            // then its hyperthreads, before moving on to the next L3. L3s are visited NUMA domain by NUMA domain.
             std::stable_sort(m_mapping.begin(), m_mapping.end(),
-                             [](const Row& lhs, const Row& rhs) -> bool { return lhs.numa_domain_id < rhs.numa_domain_id; });
+                             [](const Row& lhs, const Row& rhs) -> bool {
+                                 return std::tie(lhs.numa_domain_id, lhs.l3_id, lhs.smt_index, lhs.core_class) <
+                                        std::tie(rhs.numa_domain_id, rhs.l3_id, rhs.smt_index, rhs.core_class);
+                             });
             break;
 
         default:
             break;
     }
 
+    compute_loc_distances();
+
     // Apparently we were successful
+    m_error_msg = "";
     m_initialized = true;
 }
 
+void JProcessorMapping::compute_loc_distances() {
+
+    // Read the NUMA distance table, e.g. "10 21" from /sys/devices/system/node/node0/distance
+    // Each node's row is indexed by position in the online node list, which matters once node ids have gaps.
+    std::map<size_t, std::vector<size_t>> numa_distances;
+    std::vector<size_t> nodes;
+    std::string line;
+    if (read_first_line(m_sysfs_root + "/devices/system/node/online", line)) {
+        nodes = parse_cpu_list(line);
+    }
+    for (size_t node : nodes) {
+        if (!read_first_line(m_sysfs_root + "/devices/system/node/node" + std::to_string(node) + "/distance", line)) continue;
+        std::istringstream iss(line);
+        size_t d;
+        while (iss >> d) numa_distances[node].push_back(d);
+    }
+    auto numa_distance = [&](size_t a, size_t b) -> size_t {
+        auto it = numa_distances.find(a);
+        auto b_pos = std::find(nodes.begin(), nodes.end(), b);
+        if (it != numa_distances.end() && b_pos != nodes.end()) {
+            size_t b_index = static_cast<size_t>(b_pos - nodes.begin());
+            if (b_index < it->second.size()) return it->second[b_index];
+        }
+        return (a == b) ? 10 : 20; // The kernel's conventional local/remote distances
+    };
+
+    // Each location is represented by the first cpu assigned to it
+    std::vector<const Row*> representatives(m_loc_count, nullptr);
+    for (const Row& row : m_mapping) {
+        if (representatives[row.location_id] == nullptr) {
+            representatives[row.location_id] = &row;
+        }
+    }
+
+    // Weight NUMA distance most heavily, then break ties by whether we share a socket, then an L3, then a core
+    m_loc_distances = std::vector<std::vector<size_t>>(m_loc_count, std::vector<size_t>(m_loc_count, 0));
+    for (size_t a=0; a<m_loc_count; ++a) {
+        for (size_t b=0; b<m_loc_count; ++b) {
+            const Row* ra = representatives[a];
+            const Row* rb = representatives[b];
+            if (a == b || ra == nullptr || rb == nullptr) continue;
+            m_loc_distances[a][b] = 8 * numa_distance(ra->numa_domain_id, rb->numa_domain_id)
+                                  + 4 * (ra->socket_id != rb->socket_id)
+                                  + 2 * (ra->l3_id != rb->l3_id)
+                                  + (ra->core_id != rb->core_id);
+        }
+    }
+}
+
+std::vector<std::vector<size_t>> JProcessorMapping::get_loc_cpus() const {
+    std::vector<std::vector<size_t>> result;
+    if (!m_initialized) return result;
+    result.resize(m_loc_count);
+    for (const Row& row : m_mapping) {
+        result[row.location_id].push_back(row.cpu_id);
+    }
+    return result;
+}
+
+std::vector<std::vector<size_t>> JProcessorMapping::get_loc_numa_domains() const {
+    std::vector<std::vector<size_t>> result;
+    if (!m_initialized) return result;
+    result.resize(m_loc_count);
+    for (const Row& row : m_mapping) {
+        auto& domains = result[row.location_id];
+        if (std::find(domains.begin(), domains.end(), row.numa_domain_id) == domains.end()) {
+            domains.push_back(row.numa_domain_id);
+        }
+    }
+    return result;
+}
+
 std::ostream& operator<<(std::ostream& os, const JProcessorMapping::AffinityStrategy& s) {
     switch (s) {
         case JProcessorMapping::AffinityStrategy::ComputeBound: os << "compute-bound (favor fewer hyperthreads)"; break;
         case JProcessorMapping::AffinityStrategy::MemoryBound: os << "memory-bound (favor fewer NUMA domains)"; break;
+        case JProcessorMapping::AffinityStrategy::CacheBound: os << "cache-bound (pack workers by shared L3)"; break;
         case JProcessorMapping::AffinityStrategy::None: os << "none"; break;
     }
     return os;
@@ -155,6 +359,7 @@ std::ostream& operator<<(std::ostream& os, const JProcessorMapping::LocalityStra
     switch (s) {
         case JProcessorMapping::LocalityStrategy::CpuLocal: os << "cpu-local"; break;
         case JProcessorMapping::LocalityStrategy::CoreLocal: os << "core-local"; break;
+        case JProcessorMapping::LocalityStrategy::CacheLocal: os << "l3-local"; break;
         case JProcessorMapping::LocalityStrategy::NumaDomainLocal: os << "numa-domain-local"; break;
         case JProcessorMapping::LocalityStrategy::SocketLocal: os << "socket-local"; break;
         case JProcessorMapping::LocalityStrategy::Global: os << "global"; break;
@@ -177,12 +382,15 @@ std::ostream& operator<<(std::ostream& os, const JProcessorMapping& m) {
         table.AddColumn("location", JTablePrinter::Justify::Right);
         table.AddColumn("cpu", JTablePrinter::Justify::Right);
         table.AddColumn("core", JTablePrinter::Justify::Right);
+        table.AddColumn("core type", JTablePrinter::Justify::Right);
+        table.AddColumn("l3", JTablePrinter::Justify::Right);
         table.AddColumn("numa node", JTablePrinter::Justify::Right);
         table.AddColumn("socket", JTablePrinter::Justify::Right);
 
         size_t worker_id = 0;
         for (const JProcessorMapping::Row& row : m.m_mapping) {
-            table | worker_id++ | row.location_id | row.cpu_id | row.core_id | row.numa_domain_id | row.socket_id;
+            table | worker_id++ | row.location_id | row.cpu_id | row.core_id | (row.core_class == 0 ? "P" : "E")
+                  | row.l3_id | row.numa_domain_id | row.socket_id;
         }
         table.Render(os);
     }
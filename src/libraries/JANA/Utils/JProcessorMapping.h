@@ -5,17 +5,31 @@
 #pragma once
 #include <cstddef>
 #include <ostream>
+#include <string>
 #include <vector>
 
+/// JProcessorMapping decides which cpu each worker gets pinned to and which location (event pool and queue
+/// partition) it belongs to. The hardware topology is read directly from sysfs: cpus, cores and sockets from
+/// /sys/devices/system/cpu, NUMA domains and distances from /sys/devices/system/node, L3 sharing from each cpu's
+/// cache/index*/shared_cpu_list, and core types from /sys/devices/cpu_atom (Intel hybrid) or cpu_capacity (ARM
+/// big.LITTLE). Cpus excluded by the process affinity mask or the cgroup cpuset are left out.
 class JProcessorMapping {
 
 public:
 
-    enum class AffinityStrategy { None, MemoryBound, ComputeBound };
-    enum class LocalityStrategy { Global, SocketLocal, NumaDomainLocal, CoreLocal, CpuLocal };
+    enum class AffinityStrategy { None, MemoryBound, ComputeBound, CacheBound };
+    enum class LocalityStrategy { Global, SocketLocal, NumaDomainLocal, CoreLocal, CpuLocal, CacheLocal };
 
     void initialize(AffinityStrategy affinity, LocalityStrategy locality);
 
+    /// set_sysfs_root() points topology discovery somewhere other than /sys. Meant for testing.
+    inline void set_sysfs_root(std::string root) {
+        m_sysfs_root = std::move(root);
+    }
+
+    /// parse_cpu_list() parses the kernel's cpu list format, e.g. "0-3,8,10-11"
+    static std::vector<size_t> parse_cpu_list(const std::string& list);
+
     inline size_t get_loc_count() const {
         return m_loc_count;
     }
@@ -28,6 +42,19 @@ public:
         return (m_initialized) ? m_mapping[worker_id % m_mapping.size()].location_id : 0;
     }
 
+    /// get_core_class() is 0 for performance cores (and for every core on a non-hybrid cpu), 1 for efficiency cores
+    inline size_t get_core_class(size_t worker_id) const {
+        return (m_initialized) ? m_mapping[worker_id % m_mapping.size()].core_class : 0;
+    }
+
+    inline size_t get_cpu_count() const {
+        return m_mapping.size();
+    }
+
+    inline bool is_initialized() const {
+        return m_initialized;
+    }
+
     inline AffinityStrategy get_affinity() const {
         return m_affinity_strategy;
     }
@@ -36,6 +63,21 @@ public:
         return m_locality_strategy;
     }
 
+    /// get_loc_distances() returns a loc_count x loc_count matrix of relative distances between locations,
+    /// derived from the kernel's NUMA distance table. Used to order work-stealing victims nearest-first.
+    /// Empty if the mapping hasn't been initialized.
+    inline const std::vector<std::vector<size_t>>& get_loc_distances() const {
+        return m_loc_distances;
+    }
+
+    /// get_loc_cpus() returns the cpus assigned to each location, indexed by location id.
+    /// Empty if the mapping hasn't been initialized.
+    std::vector<std::vector<size_t>> get_loc_cpus() const;
+
+    /// get_loc_numa_domains() returns the NUMA domains spanned by each location, indexed by location id.
+    /// Empty if the mapping hasn't been initialized.
+    std::vector<std::vector<size_t>> get_loc_numa_domains() const;
+
     friend std::ostream& operator<<(std::ostream& os, const JProcessorMapping& m);
     friend std::ostream& operator<<(std::ostream& os, const AffinityStrategy& s);
     friend std::ostream& operator<<(std::ostream& os, const LocalityStrategy& s);
@@ -48,14 +90,23 @@ private:
         size_t core_id;
         size_t numa_domain_id;
         size_t socket_id;
+        size_t l3_id;
+        size_t core_class;
+        size_t smt_index; // Which hyperthread of its core this cpu is
     };
 
     AffinityStrategy m_affinity_strategy = AffinityStrategy::None;
     LocalityStrategy m_locality_strategy = LocalityStrategy::Global;
     std::vector<Row> m_mapping;
+    std::vector<std::vector<size_t>> m_loc_distances;
     size_t m_loc_count = 1;
     bool m_initialized = false;
     std::string m_error_msg = "Not initialized yet";
+    std::string m_sysfs_root = "/sys";
+
+    bool read_topology();
+    std::vector<size_t> read_allowed_cpus() const;
+    void compute_loc_distances();
 };
 
 
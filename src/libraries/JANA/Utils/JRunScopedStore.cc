@@ -0,0 +1,42 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "JRunScopedStore.h"
+
+
+JRunScopedStore::Entry& JRunScopedStore::GetEntry(std::type_index type, const std::string& tag) const {
+    // Entries are never removed, so the reference stays valid after we let go of the map's lock
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& entry = m_entries[std::make_pair(type, tag)];
+    if (entry == nullptr) {
+        entry = std::make_unique<Entry>();
+    }
+    return *entry;
+}
+
+
+std::shared_ptr<const void> JRunScopedStore::GetOrCompute(std::type_index type, const std::string& tag, int32_t run_number,
+                                                          const std::function<std::shared_ptr<const void>()>& compute) {
+    Entry& entry = GetEntry(type, tag);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    for (const auto& run : entry.runs) {
+        if (run.first == run_number) return run.second;
+    }
+    auto data = compute();
+    entry.compute_count += 1;
+    entry.runs.emplace_back(run_number, data);
+    if (entry.runs.size() > RunsPerFactory) {
+        // Events which still hold on to the evicted run's data keep it alive until they are done with it
+        entry.runs.pop_front();
+    }
+    return data;
+}
+
+
+size_t JRunScopedStore::GetComputeCount(std::type_index type, const std::string& tag) const {
+    Entry& entry = GetEntry(type, tag);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    return entry.compute_count;
+}
+
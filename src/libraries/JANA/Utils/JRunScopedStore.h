@@ -0,0 +1,48 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <utility>
+
+/// JRunScopedStore holds the output of run-scoped factories (see JFactory::RUN_SCOPED), so that it gets computed
+/// once per run and shared, read-only, by the matching factory of every pooled event, instead of once per pool slot.
+///
+/// JComponentManager owns one of these and hands it to the JFactorySet of every pooled event. The data is type-erased
+/// here; JFactoryT knows what is actually inside. A few runs are kept per (type, tag), because events from adjacent
+/// runs are usually in flight at the same time.
+class JRunScopedStore {
+public:
+    static constexpr size_t RunsPerFactory = 4;
+
+    /// Returns the data for (type, tag, run_number), calling compute() to produce it unless some other caller already
+    /// did. compute() runs under a lock which is per (type, tag), so callers asking for the same run wait for it and
+    /// then share the result. If compute() throws, nothing is stored and the next caller tries again.
+    std::shared_ptr<const void> GetOrCompute(std::type_index type, const std::string& tag, int32_t run_number,
+                                             const std::function<std::shared_ptr<const void>()>& compute);
+
+    /// How many times (type, tag) has been computed so far
+    size_t GetComputeCount(std::type_index type, const std::string& tag) const;
+
+private:
+    struct Entry {
+        std::mutex mutex;
+        std::deque<std::pair<int32_t, std::shared_ptr<const void>>> runs;   // Oldest first
+        size_t compute_count = 0;
+    };
+
+    Entry& GetEntry(std::type_index type, const std::string& tag) const;
+
+    mutable std::mutex m_mutex;
+    mutable std::map<std::pair<std::type_index, std::string>, std::unique_ptr<Entry>> m_entries;
+};
+
@@ -0,0 +1,188 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/JException.h>
+#include <JANA/Utils/JEventLevel.h>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+/// JSpan<T> is a read-only, non-owning view of the objects in one JFactoryT<T>. It behaves like the
+/// std::vector<const T*> which JEvent::Get<T>() returns, except that making one doesn't allocate or copy anything.
+///
+/// A JSpan points straight into the factory, so it is only valid until that factory's data changes, i.e. until
+/// the event is recycled or somebody inserts more objects into that collection. Copy it into a vector (it converts
+/// implicitly) if you need to hold on to it for longer.
+template <typename T>
+class JSpan {
+public:
+    class Iterator {
+        T* const* m_ptr = nullptr;
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = const T*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T* const*;
+        using reference = const T*;
+
+        Iterator() = default;
+        explicit Iterator(T* const* ptr) : m_ptr(ptr) {}
+
+        const T* operator*() const { return *m_ptr; }
+        const T* operator[](difference_type n) const { return m_ptr[n]; }
+        Iterator& operator++() { ++m_ptr; return *this; }
+        Iterator operator++(int) { Iterator old = *this; ++m_ptr; return old; }
+        Iterator& operator--() { --m_ptr; return *this; }
+        Iterator operator--(int) { Iterator old = *this; --m_ptr; return old; }
+        Iterator& operator+=(difference_type n) { m_ptr += n; return *this; }
+        Iterator& operator-=(difference_type n) { m_ptr -= n; return *this; }
+        Iterator operator+(difference_type n) const { return Iterator(m_ptr + n); }
+        Iterator operator-(difference_type n) const { return Iterator(m_ptr - n); }
+        difference_type operator-(const Iterator& other) const { return m_ptr - other.m_ptr; }
+        bool operator==(const Iterator& other) const { return m_ptr == other.m_ptr; }
+        bool operator!=(const Iterator& other) const { return m_ptr != other.m_ptr; }
+        bool operator<(const Iterator& other) const { return m_ptr < other.m_ptr; }
+        bool operator>(const Iterator& other) const { return m_ptr > other.m_ptr; }
+        bool operator<=(const Iterator& other) const { return m_ptr <= other.m_ptr; }
+        bool operator>=(const Iterator& other) const { return m_ptr >= other.m_ptr; }
+    };
+
+    using value_type = const T*;
+    using size_type = std::size_t;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+private:
+    T* const* m_data = nullptr;
+    size_t m_size = 0;
+
+public:
+    JSpan() = default;
+    JSpan(T* const* data, size_t size) : m_data(data), m_size(size) {}
+    explicit JSpan(const std::vector<T*>& data) : m_data(data.data()), m_size(data.size()) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const T* operator[](size_t i) const { return m_data[i]; }
+    const T* at(size_t i) const {
+        if (i >= m_size) throw JException("JSpan::at(): Index %zu is out of range for size %zu", i, m_size);
+        return m_data[i];
+    }
+    const T* front() const { return m_data[0]; }
+    const T* back() const { return m_data[m_size-1]; }
+
+    Iterator begin() const { return Iterator(m_data); }
+    Iterator end() const { return Iterator(m_data + m_size); }
+
+    /// For code which really does want its own copy
+    std::vector<const T*> to_vector() const { return std::vector<const T*>(begin(), end()); }
+    operator std::vector<const T*>() const { return to_vector(); }
+};
+
+
+template <typename T> class JFactoryT;
+class JFactory;
+
+
+/// JConcatSpan<T> is a read-only, non-owning view of every JFactoryT<T> in a JFactorySet, regardless of tag, as if
+/// their contents had been concatenated. This is what JEvent::GetAllSpan<T>() returns. Like JSpan, making one
+/// doesn't allocate, and it is only valid while the underlying factories' data stays put.
+template <typename T>
+class JConcatSpan {
+public:
+    using FactoryMap = std::map<std::pair<std::type_index, std::string>, JFactory*>;
+    using FactoryIt = typename FactoryMap::const_iterator;
+
+private:
+    FactoryIt m_first;  // The factories of type T are adjacent in the JFactorySet's map, starting here
+    FactoryIt m_end;    // The end of the whole map. Factories of other types may be added while this span is alive,
+                        // even right after T's, so we stop at the first key of a different type instead of a fixed end.
+    JEventLevel m_level = JEventLevel::None;
+
+    bool is_past_last(FactoryIt it) const {
+        return it == m_end || it->first.first != std::type_index(typeid(T));
+    }
+
+    /// Factories from a different event level are skipped, exactly like JFactorySet::GetAllFactories<T>() does
+    JSpan<T> get_span(FactoryIt it) const {
+        auto* factory = static_cast<JFactoryT<T>*>(it->second);
+        if (factory->GetLevel() != m_level) return {};
+        return factory->GetSpan();
+    }
+
+public:
+    class Iterator {
+        const JConcatSpan* m_owner = nullptr;
+        FactoryIt m_factory;
+        JSpan<T> m_span;
+        size_t m_index = 0;
+
+        // Moves forward to the next factory with anything in it. Once we run out of T's factories, we become end().
+        void settle() {
+            while (m_index == m_span.size() && m_factory != m_owner->m_end) {
+                ++m_factory;
+                m_index = 0;
+                if (m_owner->is_past_last(m_factory)) {
+                    m_factory = m_owner->m_end;
+                    m_span = JSpan<T>();
+                }
+                else {
+                    m_span = m_owner->get_span(m_factory);
+                }
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const T*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T* const*;
+        using reference = const T*;
+
+        Iterator() = default;
+        Iterator(const JConcatSpan* owner, FactoryIt factory) : m_owner(owner), m_factory(factory) {
+            if (m_owner->is_past_last(m_factory)) {
+                m_factory = m_owner->m_end;
+            }
+            else {
+                m_span = m_owner->get_span(m_factory);
+                settle();
+            }
+        }
+
+        const T* operator*() const { return m_span[m_index]; }
+        Iterator& operator++() { ++m_index; settle(); return *this; }
+        Iterator operator++(int) { Iterator old = *this; ++(*this); return old; }
+        bool operator==(const Iterator& other) const { return m_factory == other.m_factory && m_index == other.m_index; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+    };
+
+    using value_type = const T*;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    JConcatSpan() = default;
+    JConcatSpan(FactoryIt first, FactoryIt end, JEventLevel level) : m_first(first), m_end(end), m_level(level) {}
+
+    Iterator begin() const { return Iterator(this, m_first); }
+    Iterator end() const { return Iterator(this, m_end); }
+
+    /// Linear in the number of factories, not the number of objects
+    size_t size() const {
+        size_t total = 0;
+        for (FactoryIt it = m_first; !is_past_last(it); ++it) total += get_span(it).size();
+        return total;
+    }
+    bool empty() const { return begin() == end(); }
+
+    std::vector<const T*> to_vector() const { return std::vector<const T*>(begin(), end()); }
+    operator std::vector<const T*>() const { return to_vector(); }
+};
+
+
@@ -0,0 +1,55 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <JANA/Utils/JWaitObject.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/// JTaskQueue holds small units of work from inside a single event (e.g. factories which the JFactoryDag
+/// has found can run concurrently). Whoever is free runs them: workers whose own arrow has nothing to do,
+/// and the thread which owns the event while it waits for its tasks to finish.
+///
+/// Tasks must not block waiting on other tasks. They may throw; the exception is the submitter's problem,
+/// so tasks are expected to catch and stash anything they throw themselves.
+class JTaskQueue {
+    std::mutex m_mutex;
+    std::deque<std::function<void()>> m_tasks;
+    std::atomic<size_t> m_size {0};
+    JWaitObject m_wait_object;
+
+public:
+    void push(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+            m_size.fetch_add(1);
+        }
+        m_wait_object.notify();
+    }
+
+    /// Runs at most one task on the calling thread. Returns false without taking the lock if there is nothing to do.
+    bool try_run_one() {
+        if (m_size.load(std::memory_order_acquire) == 0) return false;
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) return false;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            m_size.fetch_sub(1);
+        }
+        task();
+        return true;
+    }
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+    /// Notified on every push. Submitters may also notify() it themselves to wake anybody waiting on their tasks.
+    JWaitObject& get_wait_object() { return m_wait_object; }
+};
+
+
@@ -0,0 +1,73 @@
+
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/// JWaitObject lets a worker which is starved on a place (a JMailbox or JPool) park until somebody
+/// puts something there, instead of sleeping for a fixed backoff interval.
+///
+/// Usage: call prepare_wait() and then check the place once more. If that succeeds, call cancel_wait(),
+/// otherwise pass the epoch to commit_wait(). Because the waiter registers before its last check, any
+/// notify() after that check makes commit_wait() return immediately, so no wakeups are lost.
+/// While nobody is registered, notify() only reads the waiter count and never writes to shared memory,
+/// so places with parking disabled pay next to nothing for it.
+class JWaitObject {
+    std::atomic<uint64_t> m_epoch {0};
+    std::atomic<uint32_t> m_waiter_count {0};
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+public:
+    uint64_t get_epoch() const {
+        return m_epoch.load(std::memory_order_acquire);
+    }
+
+    uint32_t get_waiter_count() const {
+        return m_waiter_count.load(std::memory_order_relaxed);
+    }
+
+    void notify() {
+        // Pairs with the fence in prepare_wait(): either the waiter sees our item, or we see the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiter_count.load(std::memory_order_relaxed) == 0) return;
+        m_epoch.fetch_add(1);
+        // Taking the mutex guarantees that a waiter which has already checked the epoch
+        // is inside m_cv.wait() before we notify it
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cv.notify_all();
+    }
+
+    /// Registers the caller as a waiter and returns the epoch to pass to commit_wait().
+    /// Must be followed by exactly one cancel_wait() or commit_wait().
+    uint64_t prepare_wait() {
+        m_waiter_count.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_acquire);
+    }
+
+    void cancel_wait() {
+        m_waiter_count.fetch_sub(1);
+    }
+
+    /// Spins for up to spin_count polls, then parks for up to timeout. Returns true if notify()
+    /// was called since prepare_wait() returned `epoch`, false if we timed out.
+    template <typename DurationT>
+    bool commit_wait(uint64_t epoch, DurationT timeout, size_t spin_count = 0) {
+        bool notified = false;
+        for (size_t i=0; i<spin_count && !notified; ++i) {
+            notified = (m_epoch.load(std::memory_order_acquire) != epoch);
+        }
+        if (!notified) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            notified = m_cv.wait_for(lock, timeout, [&]() { return m_epoch.load() != epoch; });
+        }
+        m_waiter_count.fetch_sub(1);
+        return notified;
+    }
+};
@@ -19,6 +19,7 @@ class JTestDisentangler : public JFactoryT<JTestEventData> {
     size_t m_write_bytes = 500000;
     double m_cputime_spread = 0.25;
     double m_write_spread = 0.25;
+    bool m_use_arena = false;
 
     std::shared_ptr<JTestCalibrationService> m_calibration_service;
 
@@ -31,6 +32,8 @@ public:
         app->SetDefaultParameter("jtest:disentangler_spread", m_cputime_spread, "Spread of time spent during disentangling");
         app->SetDefaultParameter("jtest:disentangler_bytes", m_write_bytes, "Bytes written during disentangling");
         app->SetDefaultParameter("jtest:disentangler_bytes_spread", m_write_spread, "Spread of bytes written during disentangling");
+        app->SetDefaultParameter("jtest:use_arena", m_use_arena, "Allocate event data objects from the per-event arena");
+        SetUseArena(m_use_arena);
 
         // Retrieve calibration service from JApp
         m_calibration_service = app->GetService<JTestCalibrationService>();
@@ -49,7 +52,7 @@ public:
         consume_cpu_ms(m_cputime_ms, m_cputime_spread);
 
         // Write (large) event data
-        auto ed = new JTestEventData;
+        auto ed = NewObject();
         write_memory(ed->buffer, m_write_bytes, m_write_spread);
         Insert(ed);
     }
@@ -18,7 +18,11 @@ extern "C"{
 void InitPlugin(JApplication *app){
 
 	InitJANAPlugin(app);
-    app->Add(new JTestParser);
+    auto parser = new JTestParser;
+    bool parser_preprocess = false;
+    app->SetDefaultParameter("jtest:parser_preprocess", parser_preprocess, "Spend jtest:parser_ms in the parallel Preprocess() instead of the serial Emit()");
+    parser->EnablePreprocess(parser_preprocess);  // Needs to be known before the topology gets built
+    app->Add(parser);
     app->Add(new JTestPlotter);
 	app->Add(new JFactoryGeneratorT<JTestDisentangler>());
 	app->Add(new JFactoryGeneratorT<JTestTracker>());
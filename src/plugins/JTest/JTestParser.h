@@ -43,12 +43,35 @@ public:
         app->SetDefaultParameter("jtest:parser_spread", m_cputime_spread, "Spread of time spent during parsing");
         app->SetDefaultParameter("jtest:parser_bytes", m_write_bytes, "Bytes written during parsing");
         app->SetDefaultParameter("jtest:parser_bytes_spread", m_write_spread, "Spread of bytes written during parsing");
+        bool emit_batch = false;
+        app->SetDefaultParameter("jtest:parser_emit_batch", emit_batch, "Emit each entangled buffer's events in one batch");
+        EnableEmitBatch(emit_batch);
     }
 
     void Open() override {
     }
 
     Result Emit(JEvent& event) override {
+        Parse(event);
+        return Result::Success;
+    }
+
+    /// Emits whatever is left of the current entangled buffer in one go
+    Result EmitBatch(JEvent** events, size_t count, size_t& emitted_count) override {
+        emitted_count = 0;
+        do {
+            Parse(*events[emitted_count]);
+            emitted_count += 1;
+        } while (emitted_count < count && (m_events_generated % 40) != 0);
+        return Result::Success;
+    }
+
+    void Preprocess(const JEvent&) override {
+        consume_cpu_ms(m_cputime_ms, m_cputime_spread);
+    }
+
+private:
+    void Parse(JEvent& event) {
 
         if ((m_events_generated % 40) == 0) {
             // "Read" new entangled event every 40 events
@@ -56,8 +79,10 @@ public:
             write_memory(*m_latest_entangled_buffer, m_write_bytes, m_write_spread);
         }
 
-        // Spin the CPU
-        consume_cpu_ms(m_cputime_ms, m_cputime_spread);
+        // Spin the CPU, unless Preprocess() does it in parallel later
+        if (!IsPreprocessEnabled()) {
+            consume_cpu_ms(m_cputime_ms, m_cputime_spread);
+        }
 
         // Emit a shared pointer to the entangled event buffer
         auto eec = new JTestEntangledEventData;
@@ -68,7 +93,6 @@ public:
 
         event.SetEventNumber(m_events_generated);
         event.SetRunNumber(1);
-        return Result::Success;
     }
 
 };
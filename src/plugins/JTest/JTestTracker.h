@@ -17,6 +17,7 @@ class JTestTracker : public JFactoryT<JTestTrackData> {
     size_t m_write_bytes = 1000;
     double m_cputime_spread = 0.25;
     double m_write_spread = 0.25;
+    bool m_use_arena = false;
 
 public:
 
@@ -32,6 +33,8 @@ public:
         app->SetDefaultParameter("jtest:tracker_spread", m_cputime_spread, "Spread of time spent during tracking");
         app->SetDefaultParameter("jtest:tracker_bytes", m_write_bytes, "Bytes written during tracking");
         app->SetDefaultParameter("jtest:tracker_bytes_spread", m_write_spread, "Spread of bytes written during tracking");
+        app->SetDefaultParameter("jtest:use_arena", m_use_arena, "Allocate event data objects from the per-event arena");
+        SetUseArena(m_use_arena);
     }
 
     void Process(const std::shared_ptr<const JEvent> &aEvent) override {
@@ -44,13 +47,20 @@ public:
         consume_cpu_ms(m_cputime_ms, m_cputime_spread);
 
         // Write (small) track data
-        auto td = new JTestTrackData;
+        auto td = NewObject();
         write_memory(td->buffer, m_write_bytes, m_write_spread);
         Insert(td);
 
         // Insert some additional objects
         std::vector<JTestTrackAuxilliaryData*> auxObjs;
-        for(int i=0;i<4;i++) auxObjs.push_back( new JTestTrackAuxilliaryData);
+        for(int i=0;i<4;i++) {
+            if (m_use_arena) {
+                auxObjs.push_back( aEvent->GetArena().Create<JTestTrackAuxilliaryData>() );
+            }
+            else {
+                auxObjs.push_back( new JTestTrackAuxilliaryData);
+            }
+        }
         aEvent->Insert( auxObjs );
     }
 };
@@ -13,9 +13,792 @@
 #include <PodioStressTest.h>
 #endif
 
+#include <JANA/Services/JComponentManager.h>
+#include <JANA/Engine/JScheduler.h>
+#include <JANA/Topology/JPool.h>
+#include <JANA/Topology/JTopologyBuilder.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JEventSourceReadAhead.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JSoA.h>
+#include <JANA/Utils/JPerfUtils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <thread>
+#include <tuple>
+#include <utility>
+
+
+
+/// Counts every heap allocation made via operator new, so that we can report allocation rates
+static std::atomic<uint64_t> g_allocation_count {0};
+
+void* operator new(std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+
+/// Zeroes out every sleep and allocation in the JTest plugin, so that all we measure is JANA's own overhead
+void TurnOffJTestWorkloads(JParameterManager* params) {
+    params->SetParameter("jtest:parser_ms", 0);
+    params->SetParameter("jtest:parser_spread", 0);
+    params->SetParameter("jtest:parser_bytes", 0);
+    params->SetParameter("jtest:parser_bytes_spread", 0);
+
+    params->SetParameter("jtest:disentangler_ms", 0);
+    params->SetParameter("jtest:disentangler_spread", 0);
+    params->SetParameter("jtest:disentangler_bytes", 0);
+    params->SetParameter("jtest:disentangler_bytes_spread", 0);
+
+    params->SetParameter("jtest:tracker_ms", 0);
+    params->SetParameter("jtest:tracker_spread", 0);
+    params->SetParameter("jtest:tracker_bytes", 0);
+    params->SetParameter("jtest:tracker_bytes_spread", 0);
+
+    params->SetParameter("jtest:plotter_ms", 0);
+    params->SetParameter("jtest:plotter_spread", 0);
+    params->SetParameter("jtest:plotter_bytes", 0);
+    params->SetParameter("jtest:plotter_bytes_spread", 0);
+}
+
+
+struct PoolPerfItem { int x = 0; };
+
+/// Several threads repeatedly take an item from the pool and put it back, just like the source and processor arrows
+/// do with chunksize 1, with and without per-thread magazines in front of the shared free list
+void MeasurePoolMagazines(size_t magazine_size) {
+
+    const size_t thread_count = 4;
+    const size_t iterations = 50000;
+
+    JPool<PoolPerfItem> pool(64, 1, true);
+    pool.set_magazine_size(magazine_size);
+    pool.init();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<thread_count; ++t) {
+        threads.emplace_back([&]() {
+            PoolPerfItem* item;
+            for (size_t i=0; i<iterations; ++i) {
+                while (pool.pop(&item, 1, 1, 0) == 0) {
+                    std::this_thread::yield();
+                }
+                item->x += 1;
+                pool.push(&item, 1, 0);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    JLogger logger(JLogger::Level::INFO, &std::cout, "PerfTests");
+    logger.show_classname = true;
+    LOG_INFO(logger) << "Pool with magazine size " << magazine_size << ": " << thread_count << " threads x "
+                     << iterations << " get/put cycles took " << elapsed_ms << " ms, "
+                     << pool.get_shared_lock_count() << " shared locks" << LOG_END;
+}
+
+
+/// An arrow which does nothing, so that MeasureSchedulerContention() measures nothing but scheduler overhead
+struct NoOpArrow : public JArrow {
+    NoOpArrow(std::string name, bool is_parallel, bool is_source)
+        : JArrow(std::move(name), is_parallel, is_source, false) {}
+
+    void execute(JArrowMetrics& result, size_t) override {
+        result.update(JArrowMetrics::Status::KeepGoing, 1, 1, std::chrono::milliseconds(0), std::chrono::milliseconds(0));
+    }
+};
+
+/// Many workers repeatedly check short arrows in and out, with or without the scheduler-wide mutex
+void MeasureSchedulerContention(bool enable_lock_free) {
+
+    const size_t worker_count = 8;
+    const size_t iterations = 50000;
+
+    auto topology = std::make_shared<JTopologyBuilder>();
+    topology->m_enable_lockfree_scheduler = enable_lock_free;
+
+    // One sequential source feeding several parallel stages. The source never finishes, so
+    // every check-in takes the fast path. The topology owns (and deletes) the arrows.
+    auto source = new NoOpArrow("source", false, true);
+    topology->arrows.push_back(source);
+    for (int i=0; i<7; ++i) {
+        auto stage = new NoOpArrow("stage" + std::to_string(i), true, false);
+        source->attach(stage);
+        topology->arrows.push_back(stage);
+    }
+    JScheduler scheduler(topology);
+    scheduler.run_topology(worker_count);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t w=0; w<worker_count; ++w) {
+        workers.emplace_back([&, w]() {
+            JArrow* assignment = nullptr;
+            for (size_t i=0; i<iterations; ++i) {
+                assignment = scheduler.next_assignment(w, assignment, JArrowMetrics::Status::KeepGoing);
+            }
+            scheduler.last_assignment(w, assignment, JArrowMetrics::Status::KeepGoing);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    JLogger logger(JLogger::Level::INFO, &std::cout, "PerfTests");
+    logger.show_classname = true;
+    LOG_INFO(logger) << "Scheduler with " << (enable_lock_free ? "lock-free checkout" : "global mutex") << ": "
+                     << worker_count << " workers x " << iterations << " check-ins, "
+                     << (worker_count * iterations) / elapsed_s << " assignments/s" << LOG_END;
+}
+
+
+struct EmitStamp : public JObject {
+    std::chrono::steady_clock::time_point emitted;
+};
+
+struct StampingSource : public JEventSource {
+    size_t event_count = 0;
+    size_t max_event_count;
+    explicit StampingSource(size_t max_event_count) : max_event_count(max_event_count) {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("StampingSource");
+    }
+    Result Emit(JEvent& event) override {
+        if (event_count++ == max_event_count) return Result::FailureFinished;
+        auto stamp = new EmitStamp;
+        stamp->emitted = std::chrono::steady_clock::now();
+        event.Insert(stamp);
+        return Result::Success;
+    }
+};
+
+struct LatencyWork : public JObject {};
+
+struct LatencyWorkFactory : public JFactoryT<LatencyWork> {
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        consume_cpu_ms(1, 0, false);
+        Insert(new LatencyWork);
+    }
+};
+
+/// Records how long each event took from Emit() to Process(). The work happens in LatencyWorkFactory, which the
+/// processor's declared input pulls in its parallel stage, so the policy has a queue to choose between.
+struct LatencyProcessor : public JEventProcessor {
+    Input<LatencyWork> m_work {this, {.name=""}};
+    double total_latency_ms = 0;
+    double max_latency_ms = 0;
+    size_t event_count = 0;
+    LatencyProcessor() { SetCallbackStyle(CallbackStyle::ExpertMode); SetTypeName("LatencyProcessor"); }
+    void Process(const JEvent& event) override {
+        auto stamp = event.GetSingle<EmitStamp>();
+        double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stamp->emitted).count();
+        total_latency_ms += latency_ms;
+        max_latency_ms = std::max(max_latency_ms, latency_ms);
+        event_count += 1;
+    }
+};
+
+/// Runs a source feeding a 1 ms parallel stage under the given scheduler policy, timing every event from Emit() to
+/// Process().
+void MeasureSchedulerPolicy(const std::string& policy) {
+
+    const size_t event_count = 4000;
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    params->SetParameter("nthreads", 4);
+    params->SetParameter("jana:event_pool_size", 200);
+    params->SetParameter("jana:scheduler_policy", policy);
+
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    app.Add(new StampingSource(event_count));
+    app.Add(new JFactoryGeneratorT<LatencyWorkFactory>);
+    auto proc = new LatencyProcessor;
+    app.Add(proc);
+    app.SetTicker(false);
+    app.SetTimeoutEnabled(false);
+
+    auto start = std::chrono::steady_clock::now();
+    app.Run(true);
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double throughput_hz = proc->event_count / elapsed_s;
+    double avg_latency_ms = (proc->event_count == 0) ? 0 : proc->total_latency_ms / proc->event_count;
+
+    LOG_INFO(logger) << "Scheduler policy '" << policy << "': "
+                     << "throughput = " << throughput_hz << " Hz, "
+                     << "avg latency = " << avg_latency_ms << " ms/event, "
+                     << "max latency = " << proc->max_latency_ms << " ms/event" << LOG_END;
+}
+
+
+template <int N> struct LookupObject { int x; };
+
+/// Generates one factory for each of LookupTypeCount types and LookupTagCount tags, which is roughly the shape of
+/// a halld_recon-style reconstruction where each event makes thousands of Get() calls across a few hundred factories
+constexpr int LookupTypeCount = 32;
+constexpr int LookupTagCount = 8;
+
+struct LookupFactoryGenerator : public JFactoryGenerator {
+    template <int... Ns>
+    void GenerateAll(JFactorySet* facset, std::integer_sequence<int, Ns...>) {
+        (GenerateTags<Ns>(facset), ...);
+    }
+    template <int N>
+    void GenerateTags(JFactorySet* facset) {
+        for (int tag=0; tag<LookupTagCount; ++tag) {
+            auto fac = new JFactoryT<LookupObject<N>>;
+            fac->SetTag("tag" + std::to_string(tag));
+            fac->SetApplication(GetApplication());
+            facset->Add(fac);
+        }
+    }
+    void GenerateFactories(JFactorySet* facset) override {
+        GenerateAll(facset, std::make_integer_sequence<int, LookupTypeCount>());
+    }
+};
+
+template <int... Ns>
+size_t GetEverything(JEvent& event, const std::vector<std::string>& tags, std::integer_sequence<int, Ns...>) {
+    size_t count = 0;
+    for (const auto& tag : tags) {
+        ((count += event.Get<LookupObject<Ns>>(tag).size()), ...);
+    }
+    return count;
+}
+
+/// The same Gets as GetEverything, but through a JFactoryHandle for each collection
+template <int... Ns>
+struct LookupHandles {
+    std::tuple<std::vector<JFactoryHandle<LookupObject<Ns>>>...> handles;
+
+    LookupHandles(const std::vector<std::string>& tags) {
+        for (const auto& tag : tags) {
+            (std::get<std::vector<JFactoryHandle<LookupObject<Ns>>>>(handles).emplace_back(tag), ...);
+        }
+    }
+    size_t GetEverything(JEvent& event) {
+        size_t count = 0;
+        size_t tag_count = std::get<0>(handles).size();
+        for (size_t tag=0; tag<tag_count; ++tag) {
+            ((count += event.Get(std::get<std::vector<JFactoryHandle<LookupObject<Ns>>>>(handles)[tag]).size()), ...);
+        }
+        return count;
+    }
+};
+
+template <int... Ns>
+LookupHandles<Ns...> MakeLookupHandles(const std::vector<std::string>& tags, std::integer_sequence<int, Ns...>) {
+    return LookupHandles<Ns...>(tags);
+}
+
+/// Measures the latency of JEvent::Get() on already-created factories: by tag without and with the JFactoryIndex,
+/// and through JFactoryHandles
+void MeasureFactoryLookup() {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    app.Add(new LookupFactoryGenerator);
+    app.Initialize();
+
+    std::vector<std::string> tags;
+    for (int tag=0; tag<LookupTagCount; ++tag) tags.push_back("tag" + std::to_string(tag));
+    auto types = std::make_integer_sequence<int, LookupTypeCount>();
+    const size_t repetitions = 2000;
+    const double gets = repetitions * LookupTypeCount * LookupTagCount;
+
+    auto measure = [&](auto get_everything) {
+        get_everything(); // Create everything up front
+        auto start = std::chrono::steady_clock::now();
+        size_t total = 0;
+        for (size_t i=0; i<repetitions; ++i) {
+            total += get_everything();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (total != 0) throw JException("Factories should be empty");
+        return std::chrono::duration<double, std::nano>(elapsed).count() / gets;
+    };
+
+    // Via the JComponentManager, which sets up the JFactoryIndex, just like the event pool does
+    auto indexed_event = std::make_shared<JEvent>(&app);
+    app.GetService<JComponentManager>()->configure_event(*indexed_event);
+    double indexed_ns = measure([&]() { return GetEverything(*indexed_event, tags, types); });
+
+    // Through JFactoryHandles, resolved on the first pass
+    auto handles = MakeLookupHandles(tags, types);
+    double handle_ns = measure([&]() { return handles.GetEverything(*indexed_event); });
+
+    // A plain JFactorySet, which has to do the map lookups
+    auto mapped_event = std::make_shared<JEvent>(&app);
+    std::vector<JFactoryGenerator*> gens = app.GetService<JComponentManager>()->get_fac_gens();
+    mapped_event->SetFactorySet(new JFactorySet(gens));
+    double mapped_ns = measure([&]() { return GetEverything(*mapped_event, tags, types); });
+
+    LOG_INFO(logger) << "JEvent::Get() latency over " << LookupTypeCount * LookupTagCount << " factories: "
+                     << "map lookup = " << mapped_ns << " ns, "
+                     << "indexed lookup = " << indexed_ns << " ns, "
+                     << "handle = " << handle_ns << " ns" << LOG_END;
+}
+
+
+/// Runs JTest with and without jtest:use_arena, reporting throughput and heap allocations per event
+void MeasureEventArena(bool use_arena) {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    params->SetParameter("jtest:write_csv", false);
+    TurnOffJTestWorkloads(params);
+    params->SetParameter("jtest:use_arena", use_arena);
+    params->SetParameter("nthreads", 4);
+    params->SetParameter("jana:nevents", 50000);
+
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    app.AddPlugin("JTest");
+    app.SetTicker(false);
+    app.SetTimeoutEnabled(false);
+    app.Initialize();
+
+    uint64_t allocations_before = g_allocation_count.load();
+    auto start = std::chrono::steady_clock::now();
+    app.Run(true);
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t allocations = g_allocation_count.load() - allocations_before;
+
+    auto nevents = app.GetNEventsProcessed();
+    LOG_INFO(logger) << "Per-event arena " << (use_arena ? "on" : "off") << ": "
+                     << "throughput = " << nevents / elapsed_s << " Hz, "
+                     << "heap allocations = " << (nevents == 0 ? 0 : (double) allocations / nevents) << " per event, "
+                     << allocations / elapsed_s << " per second" << LOG_END;
+}
+
+
+/// An object which is expensive to construct because it owns a reserved buffer
+struct RecyclingPerfHit : public JResettable {
+    std::vector<double> samples;
+    RecyclingPerfHit() { samples.reserve(256); }
+    void Release() override { samples.clear(); }
+};
+
+struct RecyclingPerfFactory : public JFactoryT<RecyclingPerfHit> {
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        for (int i=0; i<100; ++i) {
+            auto hit = Make();
+            for (int j=0; j<100; ++j) hit->samples.push_back(j);
+            Insert(hit);
+        }
+    }
+};
+
+/// Runs the same event through a factory again and again, reporting steady-state latency and heap allocations
+/// per event with and without the RECYCLE_OBJECTS flag
+void MeasureObjectRecycling(bool recycle) {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    app.Initialize();
+
+    auto event = std::make_shared<JEvent>(&app);
+    auto factory = new RecyclingPerfFactory;
+    factory->SetRecycleFlag(recycle);
+    event->GetFactorySet()->Add(factory);
+
+    // Warm up, so that we only see the steady state
+    for (int i=0; i<10; ++i) {
+        event->Get<RecyclingPerfHit>();
+        event->GetFactorySet()->Release();
+    }
 
+    const size_t nevents = 20000;
+    uint64_t allocations_before = g_allocation_count.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<nevents; ++i) {
+        event->Get<RecyclingPerfHit>();
+        event->GetFactorySet()->Release();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t allocations = g_allocation_count.load() - allocations_before;
+
+    LOG_INFO(logger) << "Object recycling " << (recycle ? "on" : "off") << ": "
+                     << "latency = " << std::chrono::duration<double, std::micro>(elapsed).count() / nevents << " us/event, "
+                     << "heap allocations = " << (double) allocations / nevents << " per event" << LOG_END;
+}
+
+
+/// A run-level lookup table, e.g. derived from geometry and calibrations, which is expensive to build and large
+struct RunPerfTable {
+    static inline std::atomic<int> live_count {0};
+    std::vector<double> values;
+    explicit RunPerfTable(int run_number) : values(1<<20) {
+        for (size_t i=0; i<values.size(); ++i) values[i] = std::sqrt(double(i + run_number));
+        live_count += 1;
+    }
+    ~RunPerfTable() { live_count -= 1; }
+};
+
+struct RunPerfFactory : public JFactoryT<RunPerfTable> {
+    std::unique_ptr<RunPerfTable> table;   // The usual way to do it: every pooled instance rebuilds its own copy
+
+    RunPerfFactory(bool run_scoped) {
+        SetRunScopedFlag(run_scoped);
+        SetNotOwnerFlag(!run_scoped);
+    }
+    void ChangeRun(const std::shared_ptr<const JEvent>& event) override {
+        if (!TestFactoryFlag(RUN_SCOPED)) {
+            table = std::make_unique<RunPerfTable>(event->GetRunNumber());
+        }
+    }
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        if (TestFactoryFlag(RUN_SCOPED)) {
+            Insert(new RunPerfTable(event->GetRunNumber()));
+        }
+        else {
+            Insert(table.get());
+        }
+    }
+};
+
+/// Pushes a few runs' worth of events through a pool of events, the way the topology would, reporting how long the
+/// run-level tables take to build and how many copies of them are resident: one per pooled event when each factory
+/// rebuilds its own in ChangeRun(), versus one per run for a RUN_SCOPED factory
+void MeasureRunScopedFactory(bool run_scoped) {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    app.Initialize();
+    auto components = app.GetService<JComponentManager>();
+
+    const size_t pool_size = 16;
+    const int nruns = 4;
+    const int events_per_run = 64;
+    std::vector<std::shared_ptr<JEvent>> pool;
+    for (size_t i=0; i<pool_size; ++i) {
+        auto event = std::make_shared<JEvent>(&app);
+        components->configure_event(*event);
+        event->GetFactorySet()->Add(new RunPerfFactory(run_scoped));
+        pool.push_back(event);
+    }
+
+    int max_live = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int run=0; run<nruns; ++run) {
+        for (int i=0; i<events_per_run; ++i) {
+            auto& event = pool[i % pool_size];
+            event->SetRunNumber(run);
+            event->Get<RunPerfTable>();
+            max_live = std::max(max_live, RunPerfTable::live_count.load());
+            event->GetFactorySet()->Release();
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    LOG_INFO(logger) << "Run-level table via " << (run_scoped ? "RUN_SCOPED factory" : "per-factory ChangeRun()") << ": "
+                     << "time = " << std::chrono::duration<double, std::milli>(elapsed).count() / nruns << " ms/run, "
+                     << "max resident tables = " << max_live << " (" << max_live * 8 << " MB)" << LOG_END;
+}
+
+
+/// A source whose events come in blocks of 40, like the JTest parser's entangled buffers
+struct BlockPerfSource : public JEventSource {
+    BlockPerfSource() { SetCallbackStyle(CallbackStyle::ExpertMode); }
+    Result Emit(JEvent& event) override {
+        event.SetRunNumber(1);
+        return Result::Success;
+    }
+    Result EmitBatch(JEvent** events, size_t count, size_t& emitted_count) override {
+        for (emitted_count = 0; emitted_count < count; ++emitted_count) {
+            events[emitted_count]->SetRunNumber(1);
+        }
+        return Result::Success;
+    }
+};
+
+/// Measures JANA's per-event overhead for pulling events out of a source: one DoNext() per event, versus one
+/// DoNextBatch() per chunk of 40, calling Emit() for each event or EmitBatch() once
+void MeasureEmitBatch() {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    app.Initialize();
+
+    const size_t chunk_size = 40;
+    std::vector<std::shared_ptr<JEvent>> events;
+    std::vector<std::shared_ptr<JEvent>*> event_ptrs;
+    for (size_t i=0; i<chunk_size; ++i) {
+        events.push_back(std::make_shared<JEvent>(&app));
+    }
+    for (auto& event : events) event_ptrs.push_back(&event);
+    std::array<JEventSource::Result, chunk_size> results;
+
+    auto measure = [&](const char* name, auto&& fill_chunk) {
+        BlockPerfSource source;
+        source.SetApplication(&app);
+        source.DoInit();
+        const size_t nchunks = 50000;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i=0; i<nchunks; ++i) {
+            fill_chunk(source);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        LOG_INFO(logger) << "Source overhead via " << name << ": "
+                         << std::chrono::duration<double, std::nano>(elapsed).count() / (nchunks * chunk_size) << " ns/event" << LOG_END;
+    };
+
+    measure("DoNext()", [&](JEventSource& source) {
+        for (auto& event : events) source.DoNext(event);
+    });
+    measure("DoNextBatch() + Emit()", [&](JEventSource& source) {
+        source.DoNextBatch(event_ptrs.data(), chunk_size, results.data());
+    });
+    measure("DoNextBatch() + EmitBatch()", [&](JEventSource& source) {
+        source.EnableEmitBatch();
+        source.DoNextBatch(event_ptrs.data(), chunk_size, results.data());
+    });
+}
+
+
+/// Synthetic slow disk: every block of 4 KB takes 1 ms to arrive, and holds one event
+constexpr auto SlowDiskLatency = std::chrono::milliseconds(1);
+constexpr size_t SlowDiskBlockSize = 4096;
+constexpr size_t SlowDiskBlocks = 300;
+
+struct SlowDiskSource : public JEventSource {
+    size_t blocks_read = 0;
+    std::vector<char> buffer;
+    SlowDiskSource() { SetCallbackStyle(CallbackStyle::ExpertMode); SetTypeName("SlowDiskSource"); }
+    Result Emit(JEvent& event) override {
+        if (blocks_read == SlowDiskBlocks) return Result::FailureFinished;
+        std::this_thread::sleep_for(SlowDiskLatency);
+        buffer.assign(SlowDiskBlockSize, static_cast<char>(blocks_read++));
+        event.SetRunNumber(buffer[0]);
+        return Result::Success;
+    }
+};
+
+struct SlowDiskReadAheadSource : public JEventSourceReadAhead {
+    size_t blocks_read = 0;
+    SlowDiskReadAheadSource() { SetCallbackStyle(CallbackStyle::ExpertMode); SetTypeName("SlowDiskSource"); }
+    bool ReadBlock(Buffer& buffer) override {
+        if (blocks_read == SlowDiskBlocks) return false;
+        std::this_thread::sleep_for(SlowDiskLatency);
+        buffer.assign(SlowDiskBlockSize, static_cast<char>(blocks_read++));
+        return true;
+    }
+    Result Emit(JEvent& event) override {
+        Buffer* block;
+        auto result = NextBlock(block);
+        if (result != Result::Success) return result;
+        event.SetRunNumber((*block)[0]);
+        return Result::Success;
+    }
+};
+
+struct SlowDiskProcessor : public JEventProcessor {
+    // Timed from the first to the last event, so that JApplication's startup and shutdown don't count
+    std::chrono::steady_clock::time_point first_event, last_event;
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        if (first_event == std::chrono::steady_clock::time_point()) first_event = std::chrono::steady_clock::now();
+        consume_cpu_ms(1, 0, false);
+        last_event = std::chrono::steady_clock::now();
+    }
+};
+
+/// Runs a single worker over a source whose reads take as long as the processing does. Reading inside Emit() leaves
+/// the worker waiting on the disk, while reading ahead on the prefetch thread hides the disk behind the processing.
+void MeasureReadAhead(bool read_ahead) {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    params->SetParameter("nthreads", 1);
+    params->SetParameter("SlowDiskSource:read_ahead_depth", 8);
+    params->SetParameter("SlowDiskSource:read_ahead_buffer_size", SlowDiskBlockSize);
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    if (read_ahead) {
+        app.Add(new SlowDiskReadAheadSource);
+    }
+    else {
+        app.Add(new SlowDiskSource);
+    }
+    auto proc = new SlowDiskProcessor;
+    app.Add(proc);
+    app.Run();
+    auto elapsed = proc->last_event - proc->first_event;
+
+    LOG_INFO(logger) << "Slow disk (" << SlowDiskLatency.count() << " ms/block) read "
+                     << (read_ahead ? "ahead on the prefetch thread" : "inside Emit()") << ": "
+                     << std::chrono::duration<double, std::milli>(elapsed).count() / (SlowDiskBlocks - 1) << " ms/event" << LOG_END;
+}
+
+
+/// Unpacks 1000 events taking 200 us each, either inside Emit() or inside Preprocess()
+struct UnpackPerfSource : public JEventSource {
+    size_t events_emitted = 0;
+    explicit UnpackPerfSource(bool preprocess) {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("UnpackPerfSource");
+        EnablePreprocess(preprocess);
+    }
+    Result Emit(JEvent& event) override {
+        if (events_emitted == 1000) return Result::FailureFinished;
+        event.SetEventNumber(++events_emitted);
+        if (!IsPreprocessEnabled()) Unpack();
+        return Result::Success;
+    }
+    void Preprocess(const JEvent&) override { Unpack(); }
+    static void Unpack() {
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(200)) {}
+    }
+};
+
+struct UnpackPerfProcessor : public JEventProcessor {
+    void Process(const std::shared_ptr<const JEvent>&) override {}
+};
+
+/// Reports how much of reading a source is serial, depending on whether unpacking happens in Emit() or Preprocess().
+/// The wall time only improves with as many cores as threads, but the serial fraction shows the available speedup
+/// either way.
+void MeasurePreprocessSplit(bool preprocess) {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    params->SetParameter("nthreads", 4);
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+    auto source = new UnpackPerfSource(preprocess);
+    app.Add(source);
+    app.Add(new UnpackPerfProcessor);
+
+    app.Run();
+
+    double emit_s = std::chrono::duration<double>(source->GetEmitTime()).count();
+    double preprocess_s = std::chrono::duration<double>(source->GetPreprocessTime()).count();
+    LOG_INFO(logger) << "Unpacking in " << (preprocess ? "Preprocess()" : "Emit()") << ": "
+                     << "Emit = " << emit_s * 1000 << " ms, Preprocess = " << preprocess_s * 1000 << " ms, "
+                     << "serial fraction = " << 100.0 * emit_s / (emit_s + preprocess_s) << "%" << LOG_END;
+}
+
+
+/// The Tutorial's Hit, once as a JObject and once as a JSoA schema
+struct LayoutHit : public JObject {
+    int x, y;
+    double E, t;
+    LayoutHit(int x, int y, double E, double t) : x(x), y(y), E(E), t(t) {}
+};
+struct LayoutHitSchema {
+    using Columns = std::tuple<int, int, double, double>;
+    enum Column { x, y, E, t };
+    static constexpr std::array<const char*, 4> names {"x", "y", "E", "t"};
+};
+
+/// Runs SimpleClusterFactory's sums over the same hits stored as a vector of individually allocated JObjects
+/// (JFactoryT's layout) and as columns (JSoA's layout), reporting the time per hit
+void MeasureSoALayout() {
+
+    auto params = new JParameterManager;
+    params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+    JApplication app(params);
+    auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+
+    const size_t nhits = 4096;
+    const size_t repetitions = 5000;
+
+    // Interleave the hits with other allocations, roughly like a real event's heap
+    std::vector<LayoutHit*> pointers;
+    std::vector<std::unique_ptr<std::vector<char>>> clutter;
+    JSoA<LayoutHitSchema> columns;
+    for (size_t i=0; i<nhits; ++i) {
+        int x = i % 80, y = i % 24;
+        double E = 0.001 * i, t = 0.5 * (i % 100);
+        pointers.push_back(new LayoutHit(x, y, E, t));
+        clutter.push_back(std::make_unique<std::vector<char>>(i % 200));
+        columns.push_back(x, y, E, t);
+    }
+
+    auto measure = [&](auto kernel) {
+        volatile double sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r=0; r<repetitions; ++r) sink = sink + kernel();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / (repetitions * nhits);
+    };
+
+    double pointer_ns = measure([&]() {
+        long x_sum = 0, y_sum = 0;
+        double E_tot = 0, t_begin = 0, t_end = 0;
+        for (const LayoutHit* hit : pointers) {
+            x_sum += hit->x;
+            y_sum += hit->y;
+            E_tot += hit->E;
+            t_begin = (hit->t < t_begin) ? hit->t : t_begin;
+            t_end = (hit->t > t_end) ? hit->t : t_end;
+        }
+        return x_sum + y_sum + E_tot + t_begin + t_end;
+    });
+
+    // Four independent accumulators per quantity, so that the compiler can keep them in SIMD registers
+    // without having to reorder any floating-point additions
+    double column_ns = measure([&]() {
+        constexpr size_t L = 4;
+        const size_t n = columns.size();
+        const int* x = columns.data<LayoutHitSchema::x>();
+        const int* y = columns.data<LayoutHitSchema::y>();
+        const double* E = columns.data<LayoutHitSchema::E>();
+        const double* t = columns.data<LayoutHitSchema::t>();
+        long x_sum[L] = {}, y_sum[L] = {};
+        double E_tot[L] = {}, t_begin[L] = {}, t_end[L] = {};
+        size_t i = 0;
+        for (; i+L<=n; i+=L) {
+            for (size_t l=0; l<L; ++l) {
+                x_sum[l] += x[i+l];
+                y_sum[l] += y[i+l];
+                E_tot[l] += E[i+l];
+                t_begin[l] = (t[i+l] < t_begin[l]) ? t[i+l] : t_begin[l];
+                t_end[l] = (t[i+l] > t_end[l]) ? t[i+l] : t_end[l];
+            }
+        }
+        for (; i<n; ++i) {
+            x_sum[0] += x[i]; y_sum[0] += y[i]; E_tot[0] += E[i];
+            t_begin[0] = (t[i] < t_begin[0]) ? t[i] : t_begin[0];
+            t_end[0] = (t[i] > t_end[0]) ? t[i] : t_end[0];
+        }
+        double result = 0;
+        for (size_t l=0; l<L; ++l) result += x_sum[l] + y_sum[l] + E_tot[l] + t_begin[l] + t_end[l];
+        return result;
+    });
+
+    for (auto* hit : pointers) delete hit;
+
+    LOG_INFO(logger) << "Cluster sums over " << nhits << " hits: "
+                     << "vector of pointers = " << pointer_ns << " ns/hit, "
+                     << "JSoA columns = " << column_ns << " ns/hit" << LOG_END;
+}
 
 
 int main() {
@@ -55,37 +838,66 @@ int main() {
         // Log levels get set as soon as JApp gets constructed
         params->SetParameter("jtest:write_csv", false);
 
-        params->SetParameter("jtest:parser_ms", 0);
-        params->SetParameter("jtest:parser_spread", 0);
-        params->SetParameter("jtest:parser_bytes", 0);
-        params->SetParameter("jtest:parser_bytes_spread", 0);
+        TurnOffJTestWorkloads(params);
 
-        params->SetParameter("jtest:disentangler_ms", 0);
-        params->SetParameter("jtest:disentangler_spread", 0);
-        params->SetParameter("jtest:disentangler_bytes", 0);
-        params->SetParameter("jtest:disentangler_bytes_spread", 0);
+        params->SetParameter("benchmark:resultsdir", "perftest_pure_overhead");
 
-        params->SetParameter("jtest:tracker_ms", 0);
-        params->SetParameter("jtest:tracker_spread", 0);
-        params->SetParameter("jtest:tracker_bytes", 0);
-        params->SetParameter("jtest:tracker_bytes_spread", 0);
+        JApplication app(params);
+        auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
+        app.AddPlugin("JTest");
 
-        params->SetParameter("jtest:plotter_ms", 0);
-        params->SetParameter("jtest:plotter_spread", 0);
-        params->SetParameter("jtest:plotter_bytes", 0);
-        params->SetParameter("jtest:plotter_bytes_spread", 0);
+        LOG_INFO(logger) << "Running JTest with all sleeps and computations turned off" << LOG_END;
+        JBenchmarker benchmarker(&app);
+        benchmarker.RunUntilFinished();
+    }
 
-        params->SetParameter("benchmark:resultsdir", "perftest_pure_overhead");
+    {
+        auto params = new JParameterManager;
+        params->SetParameter("log:off", "JApplication,JPluginLoader,JArrowProcessingController,JArrow,JParameterManager");
+        params->SetParameter("jtest:write_csv", false);
+        TurnOffJTestWorkloads(params);
+        params->SetParameter("jana:enable_lockfree_queues", true);
+        params->SetParameter("benchmark:resultsdir", "perftest_pure_overhead_lockfree");
 
         JApplication app(params);
         auto logger = app.GetService<JLoggingService>()->get_logger("PerfTests");
         app.AddPlugin("JTest");
 
-        LOG_INFO(logger) << "Running JTest with all sleeps and computations turned off" << LOG_END;
+        LOG_INFO(logger) << "Running JTest with all sleeps and computations turned off, using lock-free event queues" << LOG_END;
         JBenchmarker benchmarker(&app);
         benchmarker.RunUntilFinished();
     }
 
+    MeasureSchedulerPolicy("round_robin");
+    MeasureSchedulerPolicy("drain_first");
+
+    MeasurePoolMagazines(0);
+    MeasurePoolMagazines(16);
+
+    MeasureSchedulerContention(false);
+    MeasureSchedulerContention(true);
+
+    MeasureFactoryLookup();
+
+    MeasureEventArena(false);
+    MeasureEventArena(true);
+
+    MeasureObjectRecycling(false);
+    MeasureObjectRecycling(true);
+
+    MeasureSoALayout();
+
+    MeasureRunScopedFactory(false);
+    MeasureRunScopedFactory(true);
+
+    MeasureEmitBatch();
+
+    MeasureReadAhead(false);
+    MeasureReadAhead(true);
+
+    MeasurePreprocessSplit(false);
+    MeasurePreprocessSplit(true);
+
 #if HAVE_PODIO
     {
         // Test that we can link against PODIO datamodel
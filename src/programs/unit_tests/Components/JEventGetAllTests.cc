@@ -6,6 +6,8 @@
 #include "catch.hpp"
 #include <JANA/JEvent.h>
 
+#include <algorithm>
+
 struct Base {
     double base;
     Base(double base) : base(base) {};
@@ -48,6 +50,12 @@ public:
 
 class UnrelatedFactory : public JFactoryT<Unrelated> {};
 
+// Its mangled name sorts right after Derived's, so its factory lands next to Derived's in the JFactorySet's map
+struct Appended {
+    double appended;
+    Appended(double appended) : appended(appended) {};
+};
+
 class MultipleFactory : public JFactoryT<Multiple> {
 public:
     MultipleFactory() {
@@ -187,3 +195,69 @@ TEST_CASE("JEventGetAllChildren") {
     }
 
 }
+
+
+TEST_CASE("JEventGetSpan") {
+
+    auto event = std::make_shared<JEvent>();
+    event->SetFactorySet(new JFactorySet);
+
+    event->Insert(std::vector<Derived*>{new Derived(1,2), new Derived(3,4)}, "first");
+    event->Insert(std::vector<Derived*>{}, "empty");
+    event->Insert(std::vector<Derived*>{new Derived(5,6)}, "second");
+    event->Insert(new Base(7));
+
+    SECTION("GetSpan views the factory's data without copying it") {
+        auto span = event->GetSpan<Derived>("first");
+        REQUIRE(span.size() == 2);
+        REQUIRE(span[1]->base == 3);
+        REQUIRE(span.at(0) == event->Get<Derived>("first")[0]);
+        REQUIRE_THROWS_AS(span.at(2), JException);
+
+        std::vector<double> bases;
+        for (const Derived* d : span) bases.push_back(d->base);
+        REQUIRE(bases == std::vector<double>{1, 3});
+
+        std::vector<const Derived*> copied = span;
+        REQUIRE(copied.size() == 2);
+    }
+
+    SECTION("GetSpan respects strict") {
+        REQUIRE_THROWS_AS(event->GetSpan<Derived>("missing"), JException);
+        REQUIRE(event->GetSpan<Derived>("missing", false).empty());
+    }
+
+    SECTION("GetAllSpan concatenates every tag and skips empty factories") {
+        auto all = event->GetAllSpan<Derived>();
+        REQUIRE(all.size() == 3);
+        std::vector<double> bases;
+        for (const Derived* d : all) bases.push_back(d->base);
+        std::sort(bases.begin(), bases.end()); // Order of tags is unspecified
+        REQUIRE(bases == std::vector<double>{1, 3, 5});
+
+        // Other types are not included
+        REQUIRE(event->GetAllSpan<Base>().size() == 1);
+        REQUIRE_THROWS_AS(event->GetAllSpan<Unrelated>(), JException);
+    }
+
+    SECTION("GetAllSpan stops at Derived's factories when a new type is added while it is alive") {
+        auto all = event->GetAllSpan<Derived>();
+        auto it = all.begin();
+        event->Insert(new Appended(8));
+        event->Insert(new Unrelated(9));
+        REQUIRE(all.size() == 3);
+        size_t count = 0;
+        for (; it != all.end(); ++it) {
+            REQUIRE((*it)->base < 7);
+            ++count;
+        }
+        REQUIRE(count == 3);
+        REQUIRE(event->GetAllSpan<Derived>().size() == 3);
+    }
+
+    SECTION("GetAll returns the same objects as GetAllSpan") {
+        auto all = event->GetAll<Derived>();
+        REQUIRE(all == event->GetAllSpan<Derived>().to_vector());
+        REQUIRE(all.size() == 3);
+    }
+}
@@ -2,6 +2,20 @@
 #include "catch.hpp"
 
 #include <JANA/JEventSource.h>
+#include <JANA/JEventSourceMmap.h>
+#include <JANA/JEventSourceReadAhead.h>
+#include <JANA/JEventProcessor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
 
 struct MyEventSource : public JEventSource {
     int open_count = 0;
@@ -71,3 +85,473 @@ TEST_CASE("JEventSource_ExpertMode_EmitCount") {
 }
 
 
+
+
+/// Stands in for a file on a parallel filesystem: each read takes a while, during which other sources could be read
+struct SlowFileSource : public JEventSource {
+    static inline std::atomic<int> reads_in_progress {0};
+    static inline std::atomic<int> max_reads_in_progress {0};
+    static inline bool wait_for_overlap = false;   // Hold the first reads back until some other source is read too
+    std::atomic<int> open_count {0};
+    std::atomic<int> close_count {0};
+    size_t events_in_file = 10;
+
+    SlowFileSource() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("SlowFileSource");
+    }
+    void Open() override { open_count++; }
+    void Close() override { close_count++; }
+    Result Emit(JEvent&) override {
+        if (GetEventCount() >= events_in_file) return Result::FailureFinished;
+        int in_progress = ++reads_in_progress;
+        int max = max_reads_in_progress;
+        while (in_progress > max && !max_reads_in_progress.compare_exchange_weak(max, in_progress)) {}
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (wait_for_overlap && max_reads_in_progress < 2 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        --reads_in_progress;
+        return Result::Success;
+    }
+};
+
+struct SlowFileCountingProcessor : public JEventProcessor {
+    std::atomic<int> event_count {0};
+    void Process(const std::shared_ptr<const JEvent>&) override { event_count++; }
+};
+
+TEST_CASE("JEventSourceArrow_ConcurrentSources") {
+    SlowFileSource::reads_in_progress = 0;
+    SlowFileSource::max_reads_in_progress = 0;
+    SlowFileSource::wait_for_overlap = false;
+
+    JApplication app;
+    app.SetParameterValue("log:global", "off");
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:event_source_chunksize", 1);   // Otherwise one worker can grab the entire event pool
+    std::vector<SlowFileSource*> sources;
+    for (int i=0; i<6; ++i) {
+        sources.push_back(new SlowFileSource);
+        app.Add(sources.back());
+    }
+    auto proc = new SlowFileCountingProcessor;
+    app.Add(proc);
+
+    SECTION("Sources are read one after another by default") {
+        app.Run();
+        REQUIRE(SlowFileSource::max_reads_in_progress == 1);
+    }
+
+    SECTION("Up to jana:max_concurrent_sources are read at once") {
+        app.SetParameterValue("jana:max_concurrent_sources", 3);
+        SlowFileSource::wait_for_overlap = true;
+        app.Run();
+        REQUIRE(SlowFileSource::max_reads_in_progress > 1);
+        REQUIRE(SlowFileSource::max_reads_in_progress <= 3);
+    }
+
+    SECTION("Concurrent sources with the lock-free scheduler") {
+        app.SetParameterValue("jana:max_concurrent_sources", 3);
+        app.SetParameterValue("jana:enable_lockfree_scheduler", true);
+        app.Run();
+        REQUIRE(SlowFileSource::max_reads_in_progress <= 3);
+    }
+
+    // Either way, every event from every source makes it through, and every source is opened and closed exactly once
+    REQUIRE(proc->event_count == 60);
+    for (auto* source : sources) {
+        REQUIRE(source->open_count == 1);
+        REQUIRE(source->close_count == 1);
+        REQUIRE(source->GetEventCount() == 10);
+    }
+}
+
+
+/// Stands in for a format which stores events in blocks, e.g. EVIO
+struct BlockSource : public JEventSource {
+    size_t events_in_file = 30;
+    size_t block_size = 7;
+    std::atomic<int> emit_batch_count {0};
+    std::atomic<int> close_count {0};
+
+    BlockSource() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("BlockSource");
+        EnableEmitBatch();
+    }
+    void Close() override { close_count++; }
+    Result EmitBatch(JEvent** events, size_t count, size_t& emitted_count) override {
+        emit_batch_count++;
+        emitted_count = 0;
+        size_t position = GetEventCount();
+        while (emitted_count < count) {
+            if (position == events_in_file) return Result::FailureFinished;
+            events[emitted_count]->SetEventNumber(100 + position);
+            emitted_count++;
+            position++;
+            if (position % block_size == 0) break;   // Stop at the end of each block
+        }
+        return Result::Success;
+    }
+};
+
+struct EventNumberRecorder : public JEventProcessor {
+    std::mutex mutex;
+    std::vector<uint64_t> event_numbers;
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        event_numbers.push_back(event->GetEventNumber());
+    }
+};
+
+TEST_CASE("JEventSource_EmitBatch") {
+    JApplication app;
+    app.SetParameterValue("log:global", "off");
+    app.SetParameterValue("jana:event_pool_size", 16);
+    app.SetParameterValue("jana:event_source_chunksize", 10);
+    auto source = new BlockSource;
+    auto proc = new EventNumberRecorder;
+    app.Add(source);
+    app.Add(proc);
+
+    SECTION("Every event comes through, a block at a time") {
+        app.Run();
+        std::sort(proc->event_numbers.begin(), proc->event_numbers.end());
+        REQUIRE(proc->event_numbers.size() == 30);
+        for (size_t i=0; i<30; ++i) {
+            REQUIRE(proc->event_numbers[i] == 100 + i);
+        }
+        REQUIRE(source->emit_batch_count < 15);   // Far fewer calls than events
+        REQUIRE(source->close_count == 1);
+    }
+
+    SECTION("NSkip and NEvents are respected") {
+        app.SetParameterValue("jana:nskip", 3);
+        app.SetParameterValue("jana:nevents", 12);
+        app.Run();
+        std::sort(proc->event_numbers.begin(), proc->event_numbers.end());
+        REQUIRE(proc->event_numbers.size() == 12);
+        REQUIRE(proc->event_numbers.front() == 103);
+        REQUIRE(proc->event_numbers.back() == 114);
+        REQUIRE(source->GetEventCount() == 15);
+        REQUIRE(source->close_count == 1);
+    }
+}
+
+
+/// Reads blocks of 5 event numbers each on the prefetch thread, and unpacks one event per Emit()
+struct ReadAheadSource : public JEventSourceReadAhead {
+    size_t blocks_in_file = 8;
+    bool throw_on_block_3 = false;
+    std::atomic<size_t> blocks_read {0};
+    std::atomic<size_t> blocks_handed_out {0};
+    std::atomic<size_t> max_blocks_ahead {0};
+    std::atomic<int> close_count {0};
+    std::atomic<bool> read_on_emit_thread {false};
+    std::atomic<std::thread::id> emit_thread;
+    Buffer* block = nullptr;
+    size_t position_in_block = 0;
+
+    ReadAheadSource() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("ReadAheadSource");
+    }
+
+    bool ReadBlock(Buffer& buffer) override {
+        if (blocks_read == blocks_in_file) return false;
+        if (throw_on_block_3 && blocks_read == 3) throw std::runtime_error("Bad block");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        for (uint32_t i=0; i<5; ++i) {
+            uint32_t event_number = blocks_read * 5 + i;
+            auto offset = buffer.size();
+            buffer.resize(offset + sizeof(uint32_t));
+            std::memcpy(buffer.data() + offset, &event_number, sizeof(uint32_t));
+        }
+        if (std::this_thread::get_id() == emit_thread) read_on_emit_thread = true;
+        size_t ahead = ++blocks_read - blocks_handed_out;
+        if (ahead > max_blocks_ahead) max_blocks_ahead = ahead;
+        return true;
+    }
+
+    Result Emit(JEvent& event) override {
+        emit_thread = std::this_thread::get_id();
+        if (block == nullptr || position_in_block == block->size()) {
+            auto result = NextBlock(block);
+            if (result != Result::Success) return result;
+            blocks_handed_out++;
+            position_in_block = 0;
+        }
+        uint32_t event_number;
+        std::memcpy(&event_number, block->data() + position_in_block, sizeof(uint32_t));
+        position_in_block += sizeof(uint32_t);
+        event.SetEventNumber(event_number);
+        return Result::Success;
+    }
+
+    void Close() override { close_count++; }
+};
+
+TEST_CASE("JEventSourceReadAhead") {
+    JApplication app;
+    app.SetParameterValue("log:global", "off");
+    app.SetParameterValue("ReadAheadSource:read_ahead_depth", 2);
+    app.SetParameterValue("ReadAheadSource:read_ahead_buffer_size", 64);
+    auto source = new ReadAheadSource;
+    auto proc = new EventNumberRecorder;
+    app.Add(source);
+    app.Add(proc);
+
+    SECTION("Every event comes through, read ahead by a bounded amount") {
+        app.Run();
+        std::sort(proc->event_numbers.begin(), proc->event_numbers.end());
+        REQUIRE(proc->event_numbers.size() == 40);
+        for (size_t i=0; i<40; ++i) {
+            REQUIRE(proc->event_numbers[i] == i);
+        }
+        REQUIRE(source->GetReadAheadDepth() == 2);
+        REQUIRE(source->GetReadAheadBufferSize() == 64);
+        REQUIRE(source->blocks_read == 8);
+        REQUIRE(source->max_blocks_ahead <= 2);
+        REQUIRE(source->read_on_emit_thread == false);
+        REQUIRE(source->close_count == 1);
+    }
+
+    SECTION("Closing early stops the prefetch thread") {
+        app.SetParameterValue("jana:nevents", 12);
+        app.Run();
+        REQUIRE(proc->event_numbers.size() == 12);
+        REQUIRE(source->blocks_read < 8);
+        REQUIRE(source->close_count == 1);
+    }
+
+    SECTION("Exceptions from ReadBlock() surface in Emit()") {
+        source->throw_on_block_3 = true;
+        REQUIRE_THROWS(app.Run());
+    }
+}
+
+TEST_CASE("JEventSourceReadAhead_Teardown") {
+    // A source that is destroyed while still open gets its prefetch thread stopped by DoTeardown(), before the
+    // derived class goes away. ReadAheadSource deliberately doesn't stop it in its own destructor.
+    auto source = new ReadAheadSource;
+    source->blocks_in_file = 1000;
+    {
+        JApplication app;
+        app.SetParameterValue("log:global", "off");
+        app.Add(source);
+        app.Initialize();
+        source->DoOpen();
+        while (source->blocks_read == 0) {
+            std::this_thread::yield();
+        }
+        REQUIRE(source->GetStatus() == JEventSource::Status::Opened);
+    }
+    SUCCEED(); // Reaching here without an assert or a pure virtual call is the test
+}
+
+
+/// Reads a file of back-to-back uint64 event numbers, attaching each one to its event as a JMappedView
+struct MmapSource : public JEventSourceMmap {
+    size_t offset = 0;
+    std::atomic<int> close_count {0};
+    std::shared_ptr<const JMappedFile> file_seen_in_open;
+
+    MmapSource(std::string resource_name) : JEventSourceMmap(std::move(resource_name)) {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("MmapSource");
+    }
+    void Open() override { file_seen_in_open = GetMappedFile(); }
+    Result Emit(JEvent& event) override {
+        if (offset + sizeof(uint64_t) > GetMappedSize()) return Result::FailureFinished;
+        auto view = AttachView(event, offset, sizeof(uint64_t));
+        event.SetEventNumber(*view->As<uint64_t>());
+        offset += sizeof(uint64_t);
+        return Result::Success;
+    }
+    void Close() override { close_count++; }
+};
+
+struct MappedViewChecker : public JEventProcessor {
+    std::atomic<size_t> matching {0};
+    std::atomic<size_t> mismatching {0};
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        auto view = event->GetSingle<JMappedView>();
+        if (view->size == sizeof(uint64_t) && *view->As<uint64_t>() == event->GetEventNumber()) {
+            matching++;
+        }
+        else {
+            mismatching++;
+        }
+    }
+};
+
+TEST_CASE("JEventSourceMmap") {
+    namespace fs = std::filesystem;
+    auto path = fs::temp_directory_path() / ("jana_mmap_test_" + std::to_string(getpid()) + ".bin");
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        for (uint64_t i=0; i<50; ++i) {
+            uint64_t event_number = 1000 + i;
+            file.write(reinterpret_cast<const char*>(&event_number), sizeof(uint64_t));
+        }
+    }
+
+    SECTION("Every event sees its own bytes in the mapping") {
+        JApplication app;
+        app.SetParameterValue("log:global", "off");
+        auto source = new MmapSource(path.string());
+        auto proc = new MappedViewChecker;
+        app.Add(source);
+        app.Add(proc);
+        app.Run();
+        REQUIRE(proc->matching == 50);
+        REQUIRE(proc->mismatching == 0);
+        REQUIRE(source->file_seen_in_open != nullptr);   // Mapped before Open()
+        REQUIRE(source->file_seen_in_open->GetSize() == 50 * sizeof(uint64_t));
+        REQUIRE(source->close_count == 1);
+    }
+
+    SECTION("Views keep the mapping alive until the event is recycled") {
+        JApplication app;
+        app.SetParameterValue("log:global", "off");
+        app.Initialize();
+        MmapSource source(path.string());
+        source.SetApplication(&app);
+        source.DoInit();
+        auto event = std::make_shared<JEvent>(&app);
+        REQUIRE(source.DoNext(event) == JEventSource::Result::Success);
+
+        source.file_seen_in_open = nullptr;
+        source.DoClose();
+        REQUIRE(source.GetStatus() == JEventSource::Status::Closed);
+
+        auto view = event->GetSingle<JMappedView>();
+        std::weak_ptr<const JMappedFile> mapping = view->file;
+        REQUIRE(*view->As<uint64_t>() == 1000);   // Still readable after the source closed
+        REQUIRE(mapping.use_count() == 1);        // ... because only the event holds on to it
+
+        event->GetFactorySet()->Release();
+        REQUIRE(mapping.expired());
+    }
+
+    SECTION("Views outside the file are rejected") {
+        JApplication app;
+        app.SetParameterValue("log:global", "off");
+        app.Initialize();
+        struct OutOfRangeSource : public MmapSource {
+            using MmapSource::MmapSource;
+            Result Emit(JEvent& event) override {
+                AttachView(event, GetMappedSize() - 4, 8);
+                return Result::Success;
+            }
+        } source(path.string());
+        source.SetApplication(&app);
+        source.DoInit();
+        auto event = std::make_shared<JEvent>(&app);
+        REQUIRE_THROWS_AS(source.DoNext(event), JException);
+    }
+
+    SECTION("Missing files are reported when opening") {
+        JApplication app;
+        app.SetParameterValue("log:global", "off");
+        app.Initialize();
+        MmapSource source((path.string() + ".missing"));
+        source.SetApplication(&app);
+        source.DoInit();
+        REQUIRE_THROWS_AS(source.DoOpen(), JException);
+    }
+
+    fs::remove(path);
+}
+
+
+struct RawWord : public JObject {
+    uint64_t word;
+    explicit RawWord(uint64_t word) : word(word) {}
+};
+
+struct DecodedWord : public JObject {
+    uint64_t value;
+    explicit DecodedWord(uint64_t value) : value(value) {}
+};
+
+/// Only grabs a raw word under the lock in Emit(), and decodes it in the parallel Preprocess()
+struct SplitSource : public JEventSource {
+    size_t events_in_file = 20;
+    std::atomic<int> preprocess_calls {0};
+
+    SplitSource(std::string name, bool preprocess) {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+        SetTypeName("SplitSource");
+        SetResourceName(std::move(name));
+        EnablePreprocess(preprocess);
+    }
+    Result Emit(JEvent& event) override {
+        if (GetEventCount() == events_in_file) return Result::FailureFinished;
+        event.Insert(new RawWord(GetEventCount() * 3));
+        return Result::Success;
+    }
+    void Preprocess(const JEvent& event) override {
+        preprocess_calls++;
+        auto raw = event.GetSingle<RawWord>();
+        event.Insert(new DecodedWord(raw->word / 3));
+    }
+};
+
+struct DecodedWordCounter : public JEventProcessor {
+    std::atomic<size_t> decoded {0};
+    std::atomic<size_t> undecoded {0};
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        // Nobody produces DecodedWords except Preprocess(), so we don't want Get() to complain about them being missing
+        auto factory = event->GetFactory<DecodedWord>();
+        if (factory != nullptr && factory->GetNumObjects() == 1) {
+            decoded++;
+        }
+        else {
+            undecoded++;
+        }
+    }
+};
+
+TEST_CASE("JEventSource_Preprocess") {
+    JApplication app;
+    app.SetParameterValue("log:global", "off");
+    auto proc = new DecodedWordCounter;
+    app.Add(proc);
+
+    SECTION("Preprocess() runs between the source and the processors once enabled") {
+        auto source = new SplitSource("split", true);
+        app.Add(source);
+        app.Run();
+        REQUIRE(proc->decoded == 20);
+        REQUIRE(proc->undecoded == 0);
+        REQUIRE(source->preprocess_calls == 20);
+        REQUIRE(source->GetPreprocessCount() == 20);
+        REQUIRE(source->GetEmitTime().count() > 0);
+        REQUIRE(source->GetPreprocessTime().count() > 0);
+    }
+
+    SECTION("Preprocess() is not called unless enabled") {
+        auto source = new SplitSource("unsplit", false);
+        app.Add(source);
+        app.Run();
+        REQUIRE(proc->decoded == 0);
+        REQUIRE(proc->undecoded == 20);
+        REQUIRE(source->preprocess_calls == 0);
+        REQUIRE(source->GetPreprocessTime().count() == 0);
+    }
+
+    SECTION("Each event is only preprocessed by the source which emitted it") {
+        auto splitting = new SplitSource("split", true);
+        auto unsplitting = new SplitSource("unsplit", false);
+        app.Add(splitting);
+        app.Add(unsplitting);
+        app.Run();
+        REQUIRE(proc->decoded == 20);
+        REQUIRE(proc->undecoded == 20);
+        REQUIRE(splitting->preprocess_calls == 20);
+        REQUIRE(unsplitting->preprocess_calls == 0);
+    }
+}
@@ -0,0 +1,226 @@
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <catch.hpp>
+#include <JANA/JApplication.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+#include <JANA/Omni/JOmniFactory.h>
+#include <JANA/Omni/JOmniFactoryGeneratorT.h>
+#include <JANA/Utils/JFactoryDag.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace factorydagtests {
+
+struct Hit { int energy; };
+struct Track { int energy; };
+struct Cluster { int energy; };
+struct Particle { int energy; };
+
+/// Keeps track of how many factories are running at once, across all threads
+struct Concurrency {
+    static std::atomic<int> current;
+    static std::atomic<int> max;
+    static std::atomic<int> executions;
+
+    static void reset() { current = 0; max = 0; executions = 0; }
+
+    static void run(std::chrono::milliseconds duration) {
+        int now = ++current;
+        int prev = max.load();
+        while (now > prev && !max.compare_exchange_weak(prev, now)) {}
+        std::this_thread::sleep_for(duration);
+        --current;
+        ++executions;
+    }
+};
+std::atomic<int> Concurrency::current {0};
+std::atomic<int> Concurrency::max {0};
+std::atomic<int> Concurrency::executions {0};
+
+static std::chrono::milliseconds branch_duration {0};
+
+struct TrackFactory : public JOmniFactory<TrackFactory> {
+    Input<Hit> hits_in {this};
+    Output<Track> tracks_out {this};
+
+    void Configure() {}
+    void ChangeRun(int32_t) {}
+    void Execute(int32_t, uint64_t) {
+        Concurrency::run(branch_duration);
+        for (const Hit* hit : hits_in()) {
+            tracks_out().push_back(new Track {hit->energy + 1});
+        }
+    }
+};
+
+struct ClusterFactory : public JOmniFactory<ClusterFactory> {
+    Input<Hit> hits_in {this};
+    Output<Cluster> clusters_out {this};
+
+    void Configure() {}
+    void ChangeRun(int32_t) {}
+    void Execute(int32_t, uint64_t) {
+        Concurrency::run(branch_duration);
+        for (const Hit* hit : hits_in()) {
+            clusters_out().push_back(new Cluster {hit->energy + 10});
+        }
+        if (hits_in().empty()) {
+            throw JException("ClusterFactory: No hits!");
+        }
+    }
+};
+
+struct ParticleFactory : public JOmniFactory<ParticleFactory> {
+    Input<Track> tracks_in {this};
+    Input<Cluster> clusters_in {this};
+    Output<Particle> particles_out {this};
+
+    void Configure() {}
+    void ChangeRun(int32_t) {}
+    void Execute(int32_t, uint64_t) {
+        Concurrency::run(std::chrono::milliseconds(0));
+        // Both branches must have finished before we run
+        if (tracks_in().size() != clusters_in().size()) {
+            throw JException("ParticleFactory: Branches are out of sync");
+        }
+        for (size_t i=0; i<tracks_in().size(); ++i) {
+            particles_out().push_back(new Particle {tracks_in()[i]->energy + clusters_in()[i]->energy});
+        }
+    }
+};
+
+void add_factories(JFactorySet* facset, JApplication* app) {
+    JOmniFactoryGeneratorT<TrackFactory> track_gen("tracker", {"hits"}, {"tracks"});
+    JOmniFactoryGeneratorT<ClusterFactory> cluster_gen("calorimeter", {"hits"}, {"clusters"});
+    JOmniFactoryGeneratorT<ParticleFactory> particle_gen("pid", {"tracks", "clusters"}, {"particles"});
+    for (JFactoryGenerator* gen : std::vector<JFactoryGenerator*>{&track_gen, &cluster_gen, &particle_gen}) {
+        gen->SetApplication(app);
+        gen->GenerateFactories(facset);
+    }
+}
+
+std::vector<JFactoryDag::Target> particle_targets() {
+    return {{"factorydagtests::Particle", "particles", JEventLevel::None}};
+}
+
+
+TEST_CASE("JFactoryDag_PlanAndPrefetch") {
+    JApplication app;
+    app.SetParameterValue("log:global", "OFF");
+    app.Initialize();
+    Concurrency::reset();
+    branch_duration = std::chrono::milliseconds(0);
+
+    auto event = std::make_shared<JEvent>(&app);
+    auto facset = new JFactorySet;
+    add_factories(facset, &app);
+    event->SetFactorySet(facset);
+
+    JTaskQueue task_queue;
+    facset->EnableFactoryDag(&task_queue);
+    JFactoryDag* dag = facset->GetFactoryDag();
+    REQUIRE(dag != nullptr);
+    REQUIRE(dag->GetNodeCount() == 3);
+
+    SECTION("The DAG requires call-once Create") {
+        REQUIRE(facset->IsConcurrentCreateEnabled());
+        JFactorySet plain_facset;
+        REQUIRE_THROWS_AS(JFactoryDag(&plain_facset, &task_queue), JException);
+    }
+
+    SECTION("Both branches run before the node that needs them") {
+        event->Insert(std::vector<Hit*>{new Hit{1}, new Hit{2}}, "hits");
+        int consumer;
+        dag->Prefetch(event, &consumer, particle_targets);
+
+        auto planned = dag->GetPlannedNodes(&consumer);
+        REQUIRE(planned.size() == 3);
+        REQUIRE(planned.back() == "pid");
+        REQUIRE(Concurrency::executions == 3);
+        REQUIRE(task_queue.size() == 0);
+
+        auto particles = event->Get<Particle>("particles");
+        REQUIRE(particles.size() == 2);
+        REQUIRE(particles[0]->energy == 2 + 11);
+        REQUIRE(particles[1]->energy == 3 + 12);
+        REQUIRE(Concurrency::executions == 3); // Get() didn't rerun anything
+    }
+
+    SECTION("Consumers only run what they need") {
+        event->Insert(std::vector<Hit*>{new Hit{1}}, "hits");
+        int consumer;
+        dag->Prefetch(event, &consumer, []() {
+            return std::vector<JFactoryDag::Target> {{"factorydagtests::Track", "tracks", JEventLevel::None}};
+        });
+        REQUIRE(dag->GetPlannedNodes(&consumer) == std::vector<std::string>{"tracker"});
+        REQUIRE(Concurrency::executions == 1);
+    }
+
+    SECTION("Exceptions are rethrown to the caller") {
+        event->Insert(std::vector<Hit*>{}, "hits");
+        int consumer;
+        REQUIRE_THROWS_AS(dag->Prefetch(event, &consumer, particle_targets), JException);
+        REQUIRE(task_queue.size() == 0);
+    }
+}
+
+
+struct HitSource : public JEventSource {
+    HitSource() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+    Result Emit(JEvent& event) override {
+        event.Insert(std::vector<Hit*>{new Hit{1}, new Hit{2}, new Hit{3}}, "hits");
+        return Result::Success;
+    }
+};
+
+struct ParticleProcessor : public JEventProcessor {
+    Input<Particle> particles_in {this, {.name="particles"}};
+    std::atomic<size_t> particle_count {0};
+    std::atomic<size_t> span_mismatch_count {0};
+
+    ParticleProcessor() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+    void Process(const JEvent&) override {
+        const std::vector<const Particle*>& particles = particles_in();
+        particle_count += particles.size();
+        if (!std::equal(particles.begin(), particles.end(), particles_in.GetSpan().begin())) span_mismatch_count++;
+    }
+};
+
+struct DagFactoryGenerator : public JFactoryGenerator {
+    void GenerateFactories(JFactorySet* facset) override {
+        add_factories(facset, GetApplication());
+    }
+};
+
+
+TEST_CASE("JFactoryDag_IdleWorkersHelp") {
+    Concurrency::reset();
+    branch_duration = std::chrono::milliseconds(100);
+
+    JApplication app;
+    app.SetParameterValue("log:global", "OFF");
+    app.SetParameterValue("jana:nevents", 1);
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("jana:enable_parallel_factories", true);
+    app.Add(new HitSource);
+    app.Add(new DagFactoryGenerator);
+    auto processor = new ParticleProcessor;
+    app.Add(processor);
+    app.Run(true);
+
+    REQUIRE(processor->particle_count == 3);
+    REQUIRE(processor->span_mismatch_count == 0);
+    REQUIRE(Concurrency::executions == 3);
+    // With a single event in flight, the second worker is idle, so it picks up one of the two branches
+    REQUIRE(Concurrency::max == 2);
+}
+
+} // namespace factorydagtests
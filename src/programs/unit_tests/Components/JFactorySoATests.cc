@@ -0,0 +1,175 @@
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <catch.hpp>
+#include <JANA/JApplication.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JFactorySoA.h>
+#include <JANA/Omni/JOmniFactory.h>
+#include <JANA/Omni/JOmniFactoryGeneratorT.h>
+
+namespace soatests {
+
+struct HitSchema {
+    using Columns = std::tuple<int, double>;
+    enum Column { cell, E };
+    static constexpr std::array<const char*, 2> names {"cell", "E"};
+};
+
+
+TEST_CASE("JSoA_Basics") {
+    JSoA<HitSchema> hits;
+    REQUIRE(hits.empty());
+    hits.push_back(3, 1.5);
+    hits.push_back(7, 2.5);
+    REQUIRE(hits.size() == 2);
+
+    SECTION("Columns are contiguous") {
+        auto& energies = hits.column<HitSchema::E>();
+        REQUIRE(energies == std::vector<double>{1.5, 2.5});
+        REQUIRE(hits.data<HitSchema::cell>()[1] == 7);
+    }
+
+    SECTION("Rows are proxies into the columns") {
+        REQUIRE(hits[0].get<HitSchema::cell>() == 3);
+        hits[1].get<HitSchema::E>() = 9.0;
+        REQUIRE(hits.column<HitSchema::E>()[1] == 9.0);
+        const auto& const_hits = hits;
+        REQUIRE(const_hits.at(1).get<HitSchema::E>() == 9.0);
+        REQUIRE_THROWS_AS(hits.at(2), JException);
+    }
+
+    SECTION("Clearing keeps capacity") {
+        hits.reserve(100);
+        hits.clear();
+        REQUIRE(hits.empty());
+        REQUIRE(hits.column<HitSchema::cell>().empty());
+        REQUIRE(hits.column<HitSchema::E>().capacity() >= 100);
+    }
+
+    SECTION("Rows can be viewed as JObjects") {
+        JSoARowView<HitSchema> view(&hits, 1);
+        JObjectSummary summary;
+        view.Summarize(summary);
+        auto fields = summary.get_fields();
+        REQUIRE(fields.size() == 2);
+        REQUIRE(fields[0].name == "cell");
+        REQUIRE(fields[0].type == "int");
+        REQUIRE(fields[0].value == "7");
+        REQUIRE(fields[1].name == "E");
+        REQUIRE(fields[1].value == "2.5");
+    }
+}
+
+
+struct HitSoAFactory : public JFactorySoA<HitSchema> {
+    int constructed_tables = 0;
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        auto& hits = MakeTable();
+        if (hits.column<HitSchema::E>().capacity() == 0) constructed_tables++;
+        for (int i=0; i<10; ++i) {
+            hits.push_back(i, i * 0.5 + event->GetEventNumber());
+        }
+    }
+};
+
+TEST_CASE("JFactorySoA_Basics") {
+    auto event = std::make_shared<JEvent>();
+    auto factory = new HitSoAFactory;
+    event->GetFactorySet()->Add(factory);
+
+    SECTION("Tables are reachable via GetSoA") {
+        event->SetEventNumber(100);
+        const auto& hits = event->GetSoA<HitSchema>();
+        REQUIRE(hits.size() == 10);
+        REQUIRE(hits.column<HitSchema::E>()[2] == 101.0);
+        REQUIRE_THROWS_AS(event->GetSoA<HitSchema>("missing"), JException);
+    }
+
+    SECTION("Tables are recycled between events") {
+        for (int i=0; i<5; ++i) {
+            event->SetEventNumber(i);
+            REQUIRE(event->GetSoA<HitSchema>().size() == 10);
+            event->GetFactorySet()->Release();
+        }
+        REQUIRE(factory->constructed_tables == 1);
+    }
+
+    SECTION("Rows show up as JObjects") {
+        event->GetSoA<HitSchema>();
+        auto objs = factory->GetAs<JObject>();
+        REQUIRE(objs.size() == 10);
+        JObjectSummary summary;
+        objs[3]->Summarize(summary);
+        REQUIRE(summary.get_fields()[0].value == "3");
+    }
+}
+
+
+struct HitSource : public JEventSource {
+    SoAOutput<HitSchema> hits_out {this, "raw_hits"};
+
+    HitSource() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+    Result Emit(JEvent& event) override {
+        for (int i=0; i<4; ++i) {
+            hits_out().push_back(i, 1.0 * event.GetEventNumber());
+        }
+        return Result::Success;
+    }
+};
+
+struct CalibrationFactory : public JOmniFactory<CalibrationFactory> {
+    SoAInput<HitSchema> hits_in {this};
+    SoAOutput<HitSchema> hits_out {this};
+
+    void Configure() {}
+    void ChangeRun(int32_t) {}
+    void Execute(int32_t, uint64_t) {
+        const auto& raw = hits_in();
+        auto& calibrated = hits_out();
+        calibrated.resize(raw.size());
+        const int* cell_in = raw.data<HitSchema::cell>();
+        const double* E_in = raw.data<HitSchema::E>();
+        int* cell_out = calibrated.data<HitSchema::cell>();
+        double* E_out = calibrated.data<HitSchema::E>();
+        for (size_t i=0; i<raw.size(); ++i) {
+            cell_out[i] = cell_in[i];
+            E_out[i] = 2.0 * E_in[i];
+        }
+    }
+};
+
+struct EnergyProcessor : public JEventProcessor {
+    SoAInput<HitSchema> hits_in {this, {.name="calibrated_hits"}};
+    double total_energy = 0;
+    size_t row_view_count = 0;
+
+    EnergyProcessor() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+    void Process(const JEvent& event) override {
+        for (double E : hits_in().column<HitSchema::E>()) total_energy += E;
+        auto fac = event.GetFactory<JSoA<HitSchema>>("calibrated_hits");
+        row_view_count += fac->GetAs<JObject>().size();
+    }
+};
+
+TEST_CASE("JFactorySoA_Omni") {
+    JApplication app;
+    app.SetParameterValue("log:global", "OFF");
+    app.SetParameterValue("jana:nevents", 3);
+    app.Add(new HitSource);
+    app.Add(new JOmniFactoryGeneratorT<CalibrationFactory>("calib", {"raw_hits"}, {"calibrated_hits"}));
+    auto proc = new EnergyProcessor;
+    app.Add(proc);
+    app.Run(true);
+
+    // Event numbers are 0,1,2; each has 4 hits with E = event number, which get doubled
+    REQUIRE(proc->total_energy == 4 * 2.0 * (0 + 1 + 2));
+    REQUIRE(proc->row_view_count == 12);
+}
+
+} // namespace soatests
@@ -8,6 +8,13 @@
 
 #include <JANA/JEvent.h>
 #include <JANA/JFactoryT.h>
+#include <JANA/JMultifactory.h>
+#include <JANA/Services/JComponentManager.h>
+#include <JANA/Utils/JFactoryIndex.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 TEST_CASE("JFactoryTests") {
 
@@ -268,3 +275,406 @@ TEST_CASE("JFactory_Logger") {
     app.Run();
 }
 
+
+
+struct MySlowFactory : public JFactoryT<JFactoryTestDummyObject> {
+    std::atomic<int> init_call_count {0};
+    std::atomic<int> process_call_count {0};
+
+    void Init() override {
+        ++init_call_count;
+    }
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        ++process_call_count;
+        // Give the other threads plenty of time to pile up behind us
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        Insert(new JFactoryTestDummyObject(event->GetEventNumber()));
+        Insert(new JFactoryTestDummyObject(22));
+    }
+};
+
+struct MySlowMultifactory : public JMultifactory {
+    std::atomic<int> process_call_count {0};
+
+    MySlowMultifactory() {
+        DeclareOutput<JFactoryTestDummyObject>("left");
+        DeclareOutput<JFactoryTestDummyObject>("right");
+    }
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        ++process_call_count;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        SetData<JFactoryTestDummyObject>("left", {new JFactoryTestDummyObject(1)});
+        SetData<JFactoryTestDummyObject>("right", {new JFactoryTestDummyObject(2)});
+    }
+};
+
+/// Runs body on nthreads threads, releasing them all at once so that they really do collide
+void run_concurrently(size_t nthreads, std::function<void(size_t)> body) {
+    std::atomic<bool> go {false};
+    std::vector<std::thread> threads;
+    for (size_t i=0; i<nthreads; ++i) {
+        threads.emplace_back([&, i]() {
+            while (!go.load()) { std::this_thread::yield(); }
+            body(i);
+        });
+    }
+    go = true;
+    for (auto& t : threads) t.join();
+}
+
+TEST_CASE("JFactory_ConcurrentCreate") {
+    auto event = std::make_shared<JEvent>();
+    auto facset = event->GetFactorySet();
+    auto fac = new MySlowFactory;
+    facset->Add(fac);
+    facset->EnableConcurrentCreate();
+    REQUIRE(fac->GetConcurrentCreate());
+
+    SECTION("Process runs exactly once however many threads call Get") {
+        for (int event_nr=1; event_nr<=3; ++event_nr) {
+            event->SetEventNumber(event_nr);
+            std::vector<std::vector<const JFactoryTestDummyObject*>> results(8);
+            run_concurrently(8, [&](size_t i) {
+                results[i] = event->Get<JFactoryTestDummyObject>();
+            });
+            REQUIRE(fac->init_call_count == 1);
+            REQUIRE(fac->process_call_count == event_nr);
+            for (const auto& result : results) {
+                // Nobody saw a half-filled factory
+                REQUIRE(result.size() == 2);
+                REQUIRE(result[0]->data == event_nr);
+            }
+            fac->ClearData();
+        }
+    }
+
+    SECTION("Inserted data is never overwritten") {
+        event->Insert(new JFactoryTestDummyObject(99));
+        run_concurrently(4, [&](size_t) {
+            event->Get<JFactoryTestDummyObject>();
+        });
+        REQUIRE(fac->process_call_count == 0);
+        REQUIRE(event->Get<JFactoryTestDummyObject>()[0]->data == 99);
+    }
+
+    SECTION("Factories added later are concurrent too") {
+        auto late = new JFactoryTestDummyFactory;
+        late->SetTag("late");
+        facset->Add(late);
+        REQUIRE(late->GetConcurrentCreate());
+    }
+}
+
+TEST_CASE("JFactory_ConcurrentCreateMultifactory") {
+    JApplication app;
+    auto event = std::make_shared<JEvent>(&app);
+    auto facset = event->GetFactorySet();
+    auto multifac = new MySlowMultifactory;
+    multifac->SetApplication(&app);
+    facset->Add(multifac);
+    facset->EnableConcurrentCreate();
+
+    // Asking for the left and right outputs at the same time still only runs the multifactory once
+    std::atomic<int> total {0};
+    run_concurrently(8, [&](size_t i) {
+        auto objs = event->Get<JFactoryTestDummyObject>(i % 2 == 0 ? "left" : "right");
+        total += objs.at(0)->data;
+    });
+    REQUIRE(multifac->process_call_count == 1);
+    REQUIRE(total == 4*1 + 4*2);
+}
+
+TEST_CASE("JFactorySet_FactoryIndex") {
+    auto index = std::make_shared<JFactoryIndex>();
+    size_t untagged = index->Add(typeid(JFactoryTestDummyObject), "");
+    size_t tagged = index->Add(typeid(JFactoryTestDummyObject), "tagged");
+    REQUIRE(untagged != tagged);
+    REQUIRE(index->Add(typeid(JFactoryTestDummyObject), "tagged") == tagged);
+    REQUIRE(index->GetSlot<JFactoryTestDummyObject>("tagged") == tagged);
+    REQUIRE(index->GetSlot<JFactoryTestDummyObject>("missing") == JFactoryIndex::npos);
+    REQUIRE(index->GetSlot<int>("") == JFactoryIndex::npos);
+    REQUIRE(index->GetSlotCount() == 2);
+
+    JFactorySet facset;
+    auto untagged_fac = new JFactoryTestDummyFactory;
+    facset.Add(untagged_fac);
+    facset.SetFactoryIndex(index);
+
+    // Added after the index was set
+    auto tagged_fac = new JFactoryTestDummyFactory;
+    tagged_fac->SetTag("tagged");
+    facset.Add(tagged_fac);
+
+    // Not in the index at all
+    auto unindexed_fac = new JFactoryTestDummyFactory;
+    unindexed_fac->SetTag("unindexed");
+    facset.Add(unindexed_fac);
+
+    REQUIRE(facset.GetFactory<JFactoryTestDummyObject>() == untagged_fac);
+    REQUIRE(facset.GetFactory<JFactoryTestDummyObject>("tagged") == tagged_fac);
+    REQUIRE(facset.GetFactory<JFactoryTestDummyObject>("unindexed") == unindexed_fac);
+    REQUIRE(facset.GetFactory<JFactoryTestDummyObject>("missing") == nullptr);
+}
+
+TEST_CASE("JFactorySet_FactoryIndexFromComponentManager") {
+    JApplication app;
+    app.Add(new JFactoryGeneratorT<JFactoryTestDummyFactory>());
+    app.Initialize();
+    auto event = std::make_shared<JEvent>(&app);
+    app.GetService<JComponentManager>()->configure_event(*event);
+
+    const JFactoryIndex* index = event->GetFactorySet()->GetFactoryIndex();
+    REQUIRE(index != nullptr);
+    REQUIRE(index->GetSlot<JFactoryTestDummyObject>("") != JFactoryIndex::npos);
+    REQUIRE(event->Get<JFactoryTestDummyObject>().size() == 3);
+
+    // Every pooled event shares the same index
+    auto other_event = std::make_shared<JEvent>(&app);
+    app.GetService<JComponentManager>()->configure_event(*other_event);
+    REQUIRE(other_event->GetFactorySet()->GetFactoryIndex() == index);
+}
+
+TEST_CASE("JEvent_FactoryHandle") {
+    JApplication app;
+    app.Add(new JFactoryGeneratorT<JFactoryTestDummyFactory>());
+    app.Add(new JFactoryGeneratorT<JFactoryTestDummyFactory>("tagged"));
+    app.Initialize();
+    auto components = app.GetService<JComponentManager>();
+    auto event = std::make_shared<JEvent>(&app);
+    components->configure_event(*event);
+    const JFactoryIndex* index = event->GetFactorySet()->GetFactoryIndex();
+
+    SECTION("Handles resolve once and then find the same factory as the tag") {
+        JFactoryHandle<JFactoryTestDummyObject> handle("tagged");
+        size_t slot;
+        REQUIRE(!handle.GetCachedSlot(index, slot));
+        REQUIRE(event->GetFactory(handle) == event->GetFactory<JFactoryTestDummyObject>("tagged"));
+        REQUIRE(handle.GetCachedSlot(index, slot));
+        REQUIRE(slot == index->GetSlot<JFactoryTestDummyObject>("tagged"));
+        REQUIRE(event->Get(handle).size() == 3);
+
+        // The same handle works for every event from the same JComponentManager
+        auto other_event = std::make_shared<JEvent>(&app);
+        components->configure_event(*other_event);
+        REQUIRE(event->GetFactory(handle) != other_event->GetFactory(handle));
+        REQUIRE(other_event->GetFactory(handle) == other_event->GetFactory<JFactoryTestDummyObject>("tagged"));
+    }
+
+    SECTION("Handles respect default tags") {
+        std::map<std::string, std::string> default_tags {{"JFactoryTestDummyObject", "tagged"}};
+        event->SetDefaultTags(default_tags);
+        JFactoryHandle<JFactoryTestDummyObject> handle;
+        REQUIRE(event->GetFactory(handle) == event->GetFactory<JFactoryTestDummyObject>("tagged"));
+    }
+
+    SECTION("Collections without a slot still work") {
+        event->Insert(new JFactoryTestDummyObject(5), "inserted");
+        JFactoryHandle<JFactoryTestDummyObject> handle("inserted");
+        auto objs = event->Get(handle);
+        REQUIRE(objs.size() == 1);
+        REQUIRE(objs[0]->data == 5);
+        size_t slot;
+        REQUIRE(handle.GetCachedSlot(index, slot));
+        REQUIRE(slot == JFactoryIndex::npos);
+    }
+
+    SECTION("Missing collections throw unless optional") {
+        JFactoryHandle<JFactoryTestDummyObject> handle("missing");
+        REQUIRE_THROWS_AS(event->Get(handle), JException);
+        REQUIRE(event->Get(handle, false).empty());
+    }
+}
+
+
+struct RecyclableHit : public JResettable {
+    static int constructed;
+    std::vector<double> samples;
+    bool reset = false;
+    RecyclableHit() { constructed++; samples.reserve(64); }
+    void Release() override { samples.clear(); }
+    void Reset() override { reset = true; }
+};
+int RecyclableHit::constructed = 0;
+
+struct RecyclingFactory : public JFactoryT<RecyclableHit> {
+    size_t count = 3;
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        for (size_t i=0; i<count; ++i) {
+            auto hit = Make();
+            hit->samples.push_back(i);
+            Insert(hit);
+        }
+    }
+};
+
+TEST_CASE("JFactory_RecycleObjects") {
+    RecyclableHit::constructed = 0;
+    auto event = std::make_shared<JEvent>();
+    auto factory = new RecyclingFactory;
+    event->GetFactorySet()->Add(factory);
+
+    SECTION("Without the flag, objects are deleted") {
+        event->Get<RecyclableHit>();
+        event->GetFactorySet()->Release();
+        REQUIRE(factory->GetRecycledCount() == 0);
+        event->Get<RecyclableHit>();
+        REQUIRE(RecyclableHit::constructed == 6);
+    }
+
+    SECTION("With the flag, objects are reused with their capacity") {
+        factory->SetRecycleFlag(true);
+        auto first = event->Get<RecyclableHit>();
+        event->GetFactorySet()->Release();
+        REQUIRE(factory->GetRecycledCount() == 3);
+        REQUIRE(first[0]->samples.empty());
+        REQUIRE(first[0]->samples.capacity() >= 64);
+
+        auto second = event->Get<RecyclableHit>();
+        REQUIRE(RecyclableHit::constructed == 3);
+        REQUIRE(factory->GetRecycledCount() == 0);
+        REQUIRE(second.size() == 3);
+        for (auto* hit : second) {
+            REQUIRE(hit->reset);
+            REQUIRE(hit->samples.size() == 1);
+            REQUIRE(std::find(first.begin(), first.end(), hit) != first.end());
+        }
+
+        // Events that need more objects than were recycled make up the difference
+        event->GetFactorySet()->Release();
+        factory->count = 5;
+        REQUIRE(event->Get<RecyclableHit>().size() == 5);
+        REQUIRE(RecyclableHit::constructed == 5);
+    }
+
+    SECTION("Non-owning factories don't recycle") {
+        factory->SetRecycleFlag(true);
+        factory->SetNotOwnerFlag(true);
+        auto hits = event->Get<RecyclableHit>();
+        event->GetFactorySet()->Release();
+        REQUIRE(factory->GetRecycledCount() == 0);
+        for (auto* hit : hits) delete hit;
+    }
+}
+
+TEST_CASE("JFactorySet_LazyFactories") {
+    JApplication app;
+    app.SetParameterValue("jana:lazy_factories", true);
+    app.Add(new JFactoryGeneratorT<JFactoryTestDummyFactory>());
+    app.Add(new JFactoryGeneratorT<JFactoryTestDummyFactory>("tagged"));
+    app.Add(new JFactoryGeneratorT<JFactoryTestExceptingFactory>("tagged"));  // Shadowed by the one above
+    app.Initialize();
+    auto components = app.GetService<JComponentManager>();
+    auto registry = components->get_factory_registry();
+    REQUIRE(registry != nullptr);
+    REQUIRE(registry->GetGeneratorCount() == 3);
+    REQUIRE(registry->GetPredecessors(2) == std::vector<size_t>{1});
+
+    auto event = std::make_shared<JEvent>(&app);
+    components->configure_event(*event);
+    auto facset = event->GetFactorySet();
+    REQUIRE(facset->GetAllFactories().empty());
+
+    SECTION("Generators run on first lookup, and shadowing matches the eager order") {
+        // The key belongs to the earlier generator, so the shadowed one never needs to run
+        auto tagged = facset->GetFactory<JFactoryTestDummyObject>("tagged");
+        REQUIRE(dynamic_cast<JFactoryTestDummyFactory*>(tagged) != nullptr);
+        REQUIRE(facset->GetAllFactories().size() == 1);
+        REQUIRE(registry->GetMaterializedCount(0) == 0);
+        REQUIRE(registry->GetMaterializedCount(1) == 1);
+        REQUIRE(registry->GetMaterializedCount(2) == 0);
+
+        REQUIRE(event->Get<JFactoryTestDummyObject>("tagged").size() == 3);
+        REQUIRE(facset->GetFactory("JFactoryTestDummyObject", "") != nullptr);
+        REQUIRE(registry->GetMaterializedCount(0) == 1);
+        REQUIRE(facset->GetFactory<JFactoryTestDummyObject>("missing") == nullptr);
+    }
+
+    SECTION("GetAll materializes every generator for the type") {
+        REQUIRE(facset->GetAllFactories<JFactoryTestDummyObject>().size() == 2);
+        REQUIRE(facset->GetAllFactories().size() == 2);
+        REQUIRE(registry->GetMaterializedCount(2) == 0);  // Fully shadowed, so it never needs to run
+        auto tagged = facset->GetFactory<JFactoryTestDummyObject>("tagged");
+        REQUIRE(dynamic_cast<JFactoryTestDummyFactory*>(tagged) != nullptr);
+    }
+
+    SECTION("Used factories get recorded on release") {
+        event->Get<JFactoryTestDummyObject>("tagged");
+        size_t tagged = registry->FindFactory(typeid(JFactoryTestDummyObject), "tagged");
+        size_t untagged = registry->FindFactory(typeid(JFactoryTestDummyObject), "");
+        REQUIRE(!registry->IsUsed(tagged));
+        facset->Release();
+        REQUIRE(registry->IsUsed(tagged));
+        REQUIRE(!registry->IsUsed(untagged));
+    }
+
+    SECTION("Concurrent create materializes everything up front") {
+        facset->EnableConcurrentCreate();
+        REQUIRE(facset->GetAllFactories().size() == 2);
+    }
+}
+
+struct JFactoryTestRunScopedFactory : public JFactoryT<JFactoryTestDummyObject> {
+    static inline std::atomic<int> process_call_count {0};
+    static inline bool destroyed = false;
+
+    JFactoryTestRunScopedFactory() {
+        SetTag("run_scoped");
+        SetRunScopedFlag(true);
+    }
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        ++process_call_count;
+        Insert(new JFactoryTestDummyObject(event->GetRunNumber(), &destroyed));
+    }
+};
+
+TEST_CASE("JFactory_RunScoped") {
+    JFactoryTestRunScopedFactory::process_call_count = 0;
+    JFactoryTestRunScopedFactory::destroyed = false;
+    {
+        JApplication app;
+        app.Add(new JFactoryGeneratorT<JFactoryTestRunScopedFactory>());
+        app.Initialize();
+        auto components = app.GetService<JComponentManager>();
+        auto store = components->get_run_scoped_store();
+        int init_count = JFactoryTestRunScopedFactory::process_call_count;  // The component summary doesn't Process()
+
+        auto event1 = std::make_shared<JEvent>(&app);
+        auto event2 = std::make_shared<JEvent>(&app);
+        components->configure_event(*event1);
+        components->configure_event(*event2);
+        event1->SetRunNumber(22);
+        event2->SetRunNumber(22);
+
+        // Both pooled events share the one object computed for run 22
+        auto obj1 = event1->GetSingle<JFactoryTestDummyObject>("run_scoped");
+        auto obj2 = event2->GetSingle<JFactoryTestDummyObject>("run_scoped");
+        REQUIRE(obj1 == obj2);
+        REQUIRE(obj1->data == 22);
+        REQUIRE(JFactoryTestRunScopedFactory::process_call_count == init_count + 1);
+        REQUIRE(store->GetComputeCount(typeid(JFactoryTestDummyObject), "run_scoped") == 1);
+
+        // Recycling the event doesn't delete the shared data, and the next event of the same run gets it back
+        event1->GetFactorySet()->Release();
+        REQUIRE(!JFactoryTestRunScopedFactory::destroyed);
+        REQUIRE(event1->GetSingle<JFactoryTestDummyObject>("run_scoped") == obj2);
+        REQUIRE(JFactoryTestRunScopedFactory::process_call_count == init_count + 1);
+
+        // A new run gets computed once, by whichever event gets there first
+        event1->GetFactorySet()->Release();
+        event2->GetFactorySet()->Release();
+        event1->SetRunNumber(23);
+        event2->SetRunNumber(23);
+        auto obj3 = event2->GetSingle<JFactoryTestDummyObject>("run_scoped");
+        REQUIRE(obj3->data == 23);
+        REQUIRE(event1->GetSingle<JFactoryTestDummyObject>("run_scoped") == obj3);
+        REQUIRE(JFactoryTestRunScopedFactory::process_call_count == init_count + 2);
+
+        // Events from the previous run which are still in flight don't force a recompute
+        event1->GetFactorySet()->Release();
+        event1->SetRunNumber(22);
+        REQUIRE(event1->GetSingle<JFactoryTestDummyObject>("run_scoped") == obj1);
+        REQUIRE(JFactoryTestRunScopedFactory::process_call_count == init_count + 2);
+    }
+    // The shared data goes away along with the last event and the store
+    REQUIRE(JFactoryTestRunScopedFactory::destroyed);
+}
@@ -62,6 +62,48 @@ TEST_CASE("ScaleNWorkerUpdate") {
     REQUIRE(threads == 8);
 }
 
+TEST_CASE("ScaleWithoutPausing") {
+    const size_t nevents = 600;
+    JApplication app;
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("log:global", "OFF");
+    app.SetParameterValue("log:warn", "JScheduler,JArrow,JWorker,JArrowProcessingController");
+    app.SetTicker(false);
+    app.Add(new scaletest::CountingSource(nevents));
+    auto processor = new scaletest::CountingProcessor;
+    app.Add(processor);
+    app.Run(false);
+
+    auto pc = app.GetService<JArrowProcessingController>();
+    auto scheduler = pc->get_scheduler();
+
+    for (size_t nthreads : {8, 3, 6, 1, 4}) {
+        app.Scale(nthreads);
+        // Scaling a running topology must not pause it. (Once the source finishes, it drains and pauses on its own.)
+        auto status = scheduler->get_topology_status();
+        REQUIRE((status == JScheduler::TopologyStatus::Running || status == JScheduler::TopologyStatus::Draining ||
+                 status == JScheduler::TopologyStatus::Paused));
+        if (status != JScheduler::TopologyStatus::Paused) {
+            REQUIRE(pc->measure_performance()->workers.size() == nthreads);
+            REQUIRE(pc->measure_performance()->thread_count == nthreads);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    while (!pc->is_stopped()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pc->wait_until_stopped();
+
+    // Every event was processed exactly once
+    std::vector<uint64_t> event_numbers = processor->event_numbers;
+    std::sort(event_numbers.begin(), event_numbers.end());
+    REQUIRE(event_numbers.size() == nevents);
+    for (size_t i=0; i<nevents; ++i) {
+        REQUIRE(event_numbers[i] == i+1);
+    }
+}
+
 TEST_CASE("ScaleThroughputImprovement", "[.][performance]") {
 
     JApplication app;
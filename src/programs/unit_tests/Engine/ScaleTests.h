@@ -8,6 +8,8 @@
 #include <JANA/Utils/JPerfUtils.h>
 #include <JANA/JEventProcessor.h>
 #include <JANA/JEventSource.h>
+#include <mutex>
+#include <vector>
 
 namespace scaletest {
 struct DummySource : public JEventSource {
@@ -33,5 +35,37 @@ struct DummyProcessor : public JEventProcessor {
         std::this_thread::sleep_for(std::chrono::nanoseconds(1));
     }
 };
+
+/// CountingSource emits event numbers 1..max_events and then finishes
+struct CountingSource : public JEventSource {
+    size_t max_events;
+    size_t emitted = 0;
+
+    CountingSource(size_t max_events) : max_events(max_events) {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+
+    Result Emit(JEvent& event) override {
+        if (emitted == max_events) return Result::FailureFinished;
+        event.SetEventNumber(++emitted);
+        return Result::Success;
+    }
+};
+
+/// CountingProcessor records every event number it sees, so that we can check that each event was
+/// processed exactly once no matter how many times we scaled in the meantime
+struct CountingProcessor : public JEventProcessor {
+    std::mutex mutex;
+    std::vector<uint64_t> event_numbers;
+
+    CountingProcessor() {
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+    void Process(const JEvent& event) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mutex);
+        event_numbers.push_back(event.GetEventNumber());
+    }
+};
 } // namespace scaletest
 #endif //JANA2_SCALETESTS_H
@@ -9,6 +9,7 @@
 #include <JANA/Topology/JTopologyBuilder.h>
 
 #include "../Topology/TestTopologyComponents.h"
+#include <thread>
 
 TEST_CASE("SchedulerTests") {
 
@@ -29,6 +30,7 @@ TEST_CASE("SchedulerTests") {
     auto sum_everything = new SumSink<double>("sum_everything", q3, p2);
 
     auto topology = std::make_shared<JTopologyBuilder>();
+    topology->m_enable_lockfree_scheduler = GENERATE(false, true);
 
     emit_rand_ints->attach(multiply_by_two);
     multiply_by_two->attach(subtract_one);
@@ -115,6 +117,7 @@ TEST_CASE("SchedulerRoundRobinBehaviorTests") {
     auto sum_everything = new SumSink<double>("sum_everything", q3, p2);
 
     auto topology = std::make_shared<JTopologyBuilder>();
+    topology->m_enable_lockfree_scheduler = GENERATE(false, true);
 
     emit_rand_ints->attach(multiply_by_two);
     multiply_by_two->attach(subtract_one);
@@ -227,3 +230,158 @@ TEST_CASE("SchedulerRoundRobinBehaviorTests") {
 }
 
 
+TEST_CASE("SchedulerDrainFirstPolicy") {
+
+    auto q1 = new JMailbox<int*>(10);
+    auto q2 = new JMailbox<double*>(10);
+    auto q3 = new JMailbox<double*>(10);
+
+    auto p1 = new JPool<int>(0,1,false);
+    auto p2 = new JPool<double>(0,1,false);
+    p1->init();
+    p2->init();
+
+    MultByTwoProcessor processor;
+
+    auto emit_rand_ints = new RandIntSource("emit_rand_ints", p1, q1);
+    auto multiply_by_two = new MapArrow<int*,double*>("multiply_by_two", processor, q1, q2);
+    auto subtract_one = new SubOneProcessor("subtract_one", q2, q3);
+    auto sum_everything = new SumSink<double>("sum_everything", q3, p2);
+
+    auto topology = std::make_shared<JTopologyBuilder>();
+    topology->m_enable_lockfree_scheduler = GENERATE(false, true);
+    topology->m_scheduler_policy = "drain_first";
+
+    emit_rand_ints->attach(multiply_by_two);
+    multiply_by_two->attach(subtract_one);
+    subtract_one->attach(sum_everything);
+
+    topology->arrows.push_back(emit_rand_ints);
+    topology->arrows.push_back(multiply_by_two);
+    topology->arrows.push_back(subtract_one);
+    topology->arrows.push_back(sum_everything);
+
+    JScheduler scheduler(topology);
+    REQUIRE(scheduler.get_policy()->get_name() == "drain_first");
+    scheduler.run_topology(1);
+
+    SECTION("With every queue empty, the source goes first") {
+        JArrow* assignment = scheduler.next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment->get_name() == "emit_rand_ints");
+    }
+
+    SECTION("Idle stages rank below the source, even when its downstream is congested") {
+        JDrainFirstPolicy policy;
+        REQUIRE(policy.get_priority(multiply_by_two, {subtract_one}) < policy.get_priority(emit_rand_ints, {multiply_by_two}));
+
+        int values[10];
+        int* items[10];
+        for (int i=0; i<10; ++i) items[i] = &values[i];
+        q1->push_and_unreserve(items, 10, 0, 0);
+        REQUIRE(policy.get_priority(subtract_one, {sum_everything}) < policy.get_priority(emit_rand_ints, {multiply_by_two}));
+        REQUIRE(policy.get_priority(emit_rand_ints, {multiply_by_two}) < policy.get_priority(multiply_by_two, {subtract_one}));
+
+        int* popped[10];
+        REQUIRE(q1->pop(popped, 10, 10, 0) == 10);
+    }
+
+    SECTION("The fullest queue gets drained first") {
+        double values[4] = {1, 2, 3, 4};
+        double* items[4] = {&values[0], &values[1], &values[2], &values[3]};
+        q2->push_and_unreserve(items, 2, 0, 0);
+        q3->push_and_unreserve(items+2, 1, 0, 0);
+
+        JArrow* assignment = scheduler.next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment->get_name() == "subtract_one");
+
+        // Once subtract_one's queue is no fuller than sum_everything's, the tie goes to whoever comes next
+        double* popped[2];
+        REQUIRE(q2->pop(popped, 1, 1, 0) == 1);
+        assignment = scheduler.next_assignment(0, assignment, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment->get_name() == "sum_everything");
+
+        q2->pop(popped, 1, 1, 0);
+        q3->pop(popped, 1, 1, 0);
+    }
+
+    SECTION("A congested downstream holds back the source") {
+        int values[10];
+        int* items[10];
+        for (int i=0; i<10; ++i) items[i] = &values[i];
+        q1->push_and_unreserve(items, 10, 0, 0);
+
+        JArrow* assignment = scheduler.next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment->get_name() == "multiply_by_two");
+
+        // multiply_by_two is parallel, so it keeps winning until its queue drains
+        JArrow* second = scheduler.next_assignment(1, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(second->get_name() == "multiply_by_two");
+
+        int* popped[10];
+        REQUIRE(q1->pop(popped, 10, 10, 0) == 10);
+    }
+}
+
+TEST_CASE("SchedulerPolicyFromParameter") {
+    REQUIRE(JSchedulerPolicy::create("round_robin")->get_name() == "round_robin");
+    REQUIRE(JSchedulerPolicy::create("drain_first")->get_name() == "drain_first");
+    REQUIRE_THROWS_AS(JSchedulerPolicy::create("fastest"), JException);
+}
+
+/// An arrow which does nothing, so that workers check it in and out as fast as they can
+struct NoOpArrow : public JArrow {
+    NoOpArrow(std::string name, bool is_parallel, bool is_source)
+        : JArrow(std::move(name), is_parallel, is_source, false) {}
+
+    void execute(JArrowMetrics& result, size_t) override {
+        result.update(JArrowMetrics::Status::KeepGoing, 1, 1, std::chrono::milliseconds(0), std::chrono::milliseconds(0));
+    }
+};
+
+TEST_CASE("SchedulerConcurrentCheckins") {
+
+    const size_t worker_count = 4;
+    const size_t iterations = 2000;
+
+    auto topology = std::make_shared<JTopologyBuilder>();
+    topology->m_enable_lockfree_scheduler = GENERATE(false, true);
+
+    // One sequential source feeding several parallel stages. The source never finishes, so
+    // every check-in takes the fast path. The topology owns (and deletes) the arrows.
+    auto source = new NoOpArrow("source", false, true);
+    topology->arrows.push_back(source);
+    for (int i=0; i<7; ++i) {
+        auto stage = new NoOpArrow("stage" + std::to_string(i), true, false);
+        source->attach(stage);
+        topology->arrows.push_back(stage);
+    }
+    JScheduler scheduler(topology);
+    scheduler.run_topology(worker_count);
+
+    std::atomic<size_t> source_overlap_count {0};
+    std::atomic<int> source_holders {0};
+    std::vector<std::thread> workers;
+    for (size_t w=0; w<worker_count; ++w) {
+        workers.emplace_back([&, w]() {
+            JArrow* assignment = nullptr;
+            for (size_t i=0; i<iterations; ++i) {
+                if (assignment == source) source_holders--;
+                assignment = scheduler.next_assignment(w, assignment, JArrowMetrics::Status::KeepGoing);
+                if (assignment == source && ++source_holders > 1) source_overlap_count++;
+            }
+            if (assignment == source) source_holders--;
+            scheduler.last_assignment(w, assignment, JArrowMetrics::Status::KeepGoing);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // The sequential source was never handed to two workers at once, and every checkout was matched by a checkin
+    REQUIRE(source_overlap_count == 0);
+    auto state = scheduler.get_topology_state();
+    for (auto& as : state.arrow_states) {
+        REQUIRE(as.thread_count == 0);
+        REQUIRE(as.status == JScheduler::ArrowStatus::Active);
+    }
+}
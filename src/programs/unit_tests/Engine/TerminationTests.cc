@@ -17,6 +17,7 @@ TEST_CASE("TerminationTests") {
     auto processor = new CountingProcessor();
     app.Add(processor);
     app.SetParameterValue("jana:extended_report", 0);
+    app.SetParameterValue("jana:enable_lockfree_scheduler", GENERATE(false, true));
 
     SECTION("Manual termination") {
 
@@ -1,6 +1,7 @@
 
 #include <catch.hpp>
 #include <JANA/Topology/JJunctionArrow.h>
+#include <JANA/Topology/JPipelineArrow.h>
 
 namespace jana {
 namespace arrowtests {
@@ -86,7 +87,160 @@ TEST_CASE("ArrowTests_Basic") {
 
 }
 
-    
+
+TEST_CASE("ArrowTests_WorkStealing") {
+
+    JMailbox<int*> qi {2, 2, true};  // Two locations, work stealing enabled
+    JPool<int> pi {5, 1, true};
+    JPool<double> pd {5, 1, true};
+    JMailbox<double*> qd {2, 1, false};
+
+    pi.init();
+    pd.init();
+
+    TestMapArrow a {&qi, &pi, &pd, &qd};
+
+    int* x;
+    pi.pop(&x, 1, 1, 0);
+    *x = 100;
+
+    // Item lands on location 1, but the worker lives on location 0
+    qi.push_and_unreserve(&x, 1, 0, 1);
+    JArrowMetrics m;
+    a.execute(m, 0);
+
+    double* y;
+    REQUIRE(qd.pop_and_reserve(&y, 1, 1, 0) == 1);
+    REQUIRE(*y == 122.2);
+    REQUIRE(a.get_metrics().get_total_steal_count() == 1);
+    REQUIRE(qi.size() == 0);
+}
+
+
+
+struct TestDoubleArrow : public JPipelineArrow<TestDoubleArrow, int> {
+
+    size_t process_count = 0;
+
+    TestDoubleArrow(JMailbox<int*>* qi, JMailbox<int*>* qo)
+    : JPipelineArrow<TestDoubleArrow, int>("testdoublearrow", true, false, false, qi, qo, nullptr) {}
+
+    void process(int* x, bool& success, JArrowMetrics::Status& status) {
+        *x *= 2;
+        process_count += 1;
+        success = true;
+        status = JArrowMetrics::Status::KeepGoing;
+    }
+};
+
+
+struct TestLimitedSourceArrow : public JPipelineArrow<TestLimitedSourceArrow, int> {
+
+    size_t emit_limit = 3;
+    size_t emit_count = 0;
+
+    TestLimitedSourceArrow(JPool<int>* pool, JMailbox<int*>* qo)
+    : JPipelineArrow<TestLimitedSourceArrow, int>("testlimitedsourcearrow", false, true, false, nullptr, qo, pool) {}
+
+    void process(int* x, bool& success, JArrowMetrics::Status& status) {
+        if (emit_count >= emit_limit) {
+            success = false;
+            status = JArrowMetrics::Status::Finished;
+            return;
+        }
+        *x = (int) emit_count++;
+        success = true;
+        status = JArrowMetrics::Status::KeepGoing;
+    }
+};
+
+
+TEST_CASE("ArrowTests_PipelineChunking") {
+
+    JMailbox<int*> qi {20, 1, false};
+    JMailbox<int*> qo {20, 1, false};
+    JPool<int> pool {10, 1, true};
+    pool.init();
+
+    TestDoubleArrow a {&qi, &qo};
+    a.set_chunksize(4);
+
+    int* items[6];
+    REQUIRE(pool.pop(items, 6, 6, 0) == 6);
+    for (int i=0; i<6; ++i) *items[i] = i;
+    qi.push_and_unreserve(items, 6, 0, 0);
+
+    JArrowMetrics m;
+    m.clear();
+    a.execute(m, 0);
+    REQUIRE(a.process_count == 4);
+    REQUIRE(m.get_last_status() == JArrowMetrics::Status::KeepGoing);
+    REQUIRE(m.get_total_message_count() == 4);
+    REQUIRE(qi.size() == 2);
+    REQUIRE(qo.size() == 4);
+
+    a.execute(m, 0);
+    REQUIRE(a.process_count == 6);
+    REQUIRE(m.get_total_message_count() == 6);
+    REQUIRE(qi.size() == 0);
+
+    int* results[6];
+    REQUIRE(qo.pop_and_reserve(results, 6, 6, 0) == 6);
+    for (int i=0; i<6; ++i) {
+        REQUIRE(*results[i] == 2*i);
+    }
+    qo.push_and_unreserve(results, 0, 6, 0);
+    pool.push(results, 6, 0);
+}
+
+
+TEST_CASE("ArrowTests_PipelineChunkingClampedByOutput") {
+
+    JMailbox<int*> qi {20, 1, false};
+    JMailbox<int*> qo {3, 1, false};  // Output can only accept 3 at a time
+    JPool<int> pool {10, 1, true};
+    pool.init();
+
+    TestDoubleArrow a {&qi, &qo};
+    a.set_chunksize(1000); // Clamped to JANA2_ARROWDATA_MAX_SIZE
+
+    int* items[8];
+    REQUIRE(pool.pop(items, 8, 8, 0) == 8);
+    for (int i=0; i<8; ++i) *items[i] = i;
+    qi.push_and_unreserve(items, 8, 0, 0);
+
+    JArrowMetrics m;
+    m.clear();
+    a.execute(m, 0);
+    REQUIRE(a.process_count == 3);
+    REQUIRE(qi.size() == 5);
+    REQUIRE(qo.size() == 3);
+}
+
+
+TEST_CASE("ArrowTests_PipelineChunkingSourceFinishes") {
+
+    JMailbox<int*> qo {20, 1, false};
+    JPool<int> pool {10, 1, true};
+    pool.init();
+
+    TestLimitedSourceArrow a {&pool, &qo};
+    a.set_chunksize(5);
+
+    JArrowMetrics m;
+    m.clear();
+    a.execute(m, 0);
+
+    // Three events were emitted, and the remaining two were returned to the pool
+    REQUIRE(m.get_last_status() == JArrowMetrics::Status::Finished);
+    REQUIRE(m.get_total_message_count() == 3);
+    REQUIRE(qo.size() == 3);
+
+    int* items[10];
+    REQUIRE(pool.pop(items, 7, 10, 0) == 7);
+    pool.push(items, 7, 0);
+}
+
 } // namespace arrowtests
 } // namespace jana
 
@@ -1,6 +1,8 @@
 
 #include <catch.hpp>
 #include <JANA/Topology/JPool.h>
+#include <chrono>
+#include <thread>
 
 namespace jana {
 namespace jpooltests {
@@ -90,6 +92,225 @@ TEST_CASE("JPoolTests_SingleLocationUnlimitedEvents") {
 }
 
 
+TEST_CASE("JPoolTests_HomeLocation") {
+
+    JPool<Event> pool(6, 2, false);
+    pool.init();
+
+    Event* e = pool.get(0);
+    Event* f = pool.get(1);
+    REQUIRE(pool.get_home_location(e) == 0);
+    REQUIRE(pool.get_home_location(f) == 1);
+
+    Event heap_event;
+    REQUIRE(pool.get_home_location(&heap_event) == pool.get_location_count());
+
+    // Items always return to their home location, even if put() is called from elsewhere
+    f->x = 42;
+    pool.put(f, 0);
+    Event* items[3];
+    REQUIRE(pool.pop(items, 3, 3, 1) == 3);
+    bool found = false;
+    for (Event* item : items) {
+        if (item->x == 42) found = true;
+        REQUIRE(pool.get_home_location(item) == 1);
+    }
+    REQUIRE(found);
+}
+
+TEST_CASE("JPoolTests_LocationPoolSize") {
+
+    // The pool size is split across locations instead of being given to each of them
+    JPool<Event> pool(5, 2, true);
+    pool.init();
+    REQUIRE(pool.get_location_pool_size() == 3);
+
+    Event* items[6];
+    REQUIRE(pool.pop(items, 3, 3, 0) == 3);
+    for (size_t i=0; i<3; ++i) {
+        REQUIRE(pool.get_home_location(items[i]) == 0);
+    }
+
+    // Once location 0 runs dry, it takes from location 1
+    REQUIRE(pool.pop(items+3, 3, 3, 0) == 3);
+    for (size_t i=3; i<6; ++i) {
+        REQUIRE(pool.get_home_location(items[i]) == 1);
+    }
+    REQUIRE(pool.pop(items, 1, 1, 0) == 0);
+    REQUIRE(pool.pop(items, 1, 1, 1) == 0);
+
+    // Borrowed items go back to their own location
+    pool.push(items, 6, 0);
+    Event* again[3];
+    REQUIRE(pool.pop(again, 3, 3, 1) == 3);
+    for (Event* item : again) {
+        REQUIRE(pool.get_home_location(item) == 1);
+    }
+    pool.push(again, 3, 1);
+}
+
+TEST_CASE("JPoolTests_MoreLocationsThanItems") {
+
+    // e.g. cpu-local locality with the default pool size of nthreads
+    bool use_magazines = GENERATE(false, true);
+    JPool<Event> pool(3, 8, true);
+    if (use_magazines) pool.set_magazine_size(4);
+    pool.init();
+    REQUIRE(pool.get_location_pool_size() == 1);
+
+    // A single location can still check out a whole chunk
+    Event* items[8];
+    REQUIRE(pool.pop(items, 1, 5, 2) == 5);
+    REQUIRE(pool.pop(items+5, 3, 3, 2) == 3);
+    REQUIRE(pool.pop(items, 1, 1, 5) == 0);
+
+    // If the minimum can't be met, nothing is taken
+    pool.push(items, 2, 2);
+    Event* too_few[3];
+    REQUIRE(pool.pop(too_few, 3, 3, 7) == 0);
+    REQUIRE(pool.pop(too_few, 2, 3, 7) == 2);
+
+    pool.push(too_few, 2, 7);
+    pool.push(items+2, 6, 2);
+    Event* all[8];
+    REQUIRE(pool.pop(all, 8, 8, 0) == 8);
+    pool.push(all, 8, 0);
+}
+
+TEST_CASE("JPoolTests_MagazineLimitEvents") {
+
+    JPool<Event> pool(4, 1, true);
+    pool.set_magazine_size(2);
+    pool.init();
+
+    Event* items[4];
+    REQUIRE(pool.pop(items, 4, 4, 0) == 4);
+    REQUIRE(pool.pop(items, 1, 1, 0) == 0); // Pool is exhausted
+
+    items[0]->x = 11;
+    pool.put(items[0], 0); // Goes into this thread's magazine
+    Event* e = pool.get(0);
+    REQUIRE(e != nullptr);
+    REQUIRE(e->x == 11);
+    pool.put(e, 0);
+    pool.push(items+1, 3, 0); // Overflows the magazine, which flushes back to the shared pool
+
+    Event* again[4];
+    REQUIRE(pool.pop(again, 4, 4, 0) == 4);
+    pool.push(again, 4, 0);
+}
+
+TEST_CASE("JPoolTests_MagazineReclaim") {
+
+    // Free events hoarded in one thread's magazine must still be reachable from another thread,
+    // otherwise a bounded pool could deadlock
+    JPool<Event> pool(4, 1, true);
+    pool.set_magazine_size(8);
+    pool.init();
+
+    Event* items[4];
+    REQUIRE(pool.pop(items, 4, 4, 0) == 4);
+    std::thread t([&]() {
+        pool.push(items, 4, 0); // All four end up in this thread's magazine
+    });
+    t.join();
+
+    Event* stolen[4];
+    REQUIRE(pool.pop(stolen, 4, 4, 0) == 4);
+}
+
+
+struct ThreadRecordingPool : public JPool<Event> {
+    std::vector<std::thread::id> configuring_threads;
+    ThreadRecordingPool() : JPool<Event>(4, 2, true) {}
+    void configure_item(Event*) override {
+        configuring_threads.push_back(std::this_thread::get_id());
+    }
+};
+
+TEST_CASE("JPoolTests_FirstTouchInit") {
+
+    // Every machine has cpu 0, but the sandbox we run in might not let us use it
+    bool can_pin_to_cpu0 = false;
+    std::thread probe([&]() { can_pin_to_cpu0 = JCpuInfo::PinCurrentThreadToCpus({0}); });
+    probe.join();
+
+    // Location 1 has no cpus at all, so it can never be pinned
+    ThreadRecordingPool pool;
+    auto unpinned_locations = pool.init({{0}, {}});
+    if (can_pin_to_cpu0) {
+        REQUIRE(unpinned_locations == std::vector<size_t>{1});
+    }
+    else {
+        REQUIRE(unpinned_locations == std::vector<size_t>{0, 1});
+    }
+
+    REQUIRE(pool.configuring_threads.size() == 4);
+    REQUIRE(pool.configuring_threads[0] != std::this_thread::get_id());
+    REQUIRE(pool.configuring_threads[0] == pool.configuring_threads[1]);
+    REQUIRE(pool.configuring_threads[2] == pool.configuring_threads[3]);
+
+    Event* e = pool.get(1);
+    REQUIRE(e != nullptr);
+    REQUIRE(pool.get_home_location(e) == 1);
+
+    // Every item at a location is accounted for, even if the platform can't tell us which node it is on
+    size_t total = 0;
+    for (auto& pair : pool.get_numa_node_histogram(1)) {
+        total += pair.second;
+    }
+    REQUIRE(total == 2);
+}
+
+TEST_CASE("JPoolTests_FirstTouchInitWithoutCpus") {
+
+    // If the cpu list doesn't match the locations, every location is reported as unpinned
+    ThreadRecordingPool pool;
+    REQUIRE(pool.init({{0}}) == std::vector<size_t>{0, 1});
+    REQUIRE(pool.configuring_threads.size() == 4);
+    REQUIRE(pool.get(1) != nullptr);
+}
+
+/// Several threads repeatedly take an event from the pool and put it back, just like the source and
+/// processor arrows do with chunksize 1. Returns the number of times the shared free lists were locked.
+size_t CountSharedLocks(size_t magazine_size, size_t thread_count, size_t iterations) {
+
+    JPool<Event> pool(64, 1, true);
+    pool.set_magazine_size(magazine_size);
+    pool.init();
+
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<thread_count; ++t) {
+        threads.emplace_back([&]() {
+            Event* item;
+            for (size_t i=0; i<iterations; ++i) {
+                while (pool.pop(&item, 1, 1, 0) == 0) {
+                    std::this_thread::yield();
+                }
+                item->x += 1;
+                pool.push(&item, 1, 0);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    return pool.get_shared_lock_count();
+}
+
+TEST_CASE("JPoolTests_MagazineSharedLocks") {
+
+    const size_t thread_count = 2;
+    const size_t iterations = 1000;
+
+    // Two locks per cycle without magazines
+    REQUIRE(CountSharedLocks(0, thread_count, iterations) == 2 * thread_count * iterations);
+
+    // The pool is big enough that no thread ever has to reclaim from another's magazine, so each thread only
+    // touches the shared free list while its magazine warms up
+    REQUIRE(CountSharedLocks(16, thread_count, iterations) * 4 < 2 * thread_count * iterations);
+}
+
 
 } // namespace jana
 } // namespace jpooltests
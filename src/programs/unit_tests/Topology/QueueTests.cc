@@ -3,8 +3,12 @@
 // Subject to the terms in the LICENSE file found in the top-level directory.
 
 #include <JANA/Topology/JMailbox.h>
+#include <JANA/Topology/JRingBuffer.h>
 
 #include "catch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 
 TEST_CASE("QueueTests_Basic") {
@@ -37,3 +41,276 @@ TEST_CASE("QueueTests_Basic") {
     REQUIRE(count == 2);
     REQUIRE(q.size() == 1);
 }
+
+
+TEST_CASE("QueueTests_LockFreeBasic") {
+
+    JMailbox<int*> q(100, 1, false, true);
+    REQUIRE(q.is_lock_free_enabled());
+    REQUIRE(q.size() == 0);
+
+    int* item = new int {22};
+    bool result = q.try_push(&item, 1, 0);
+    REQUIRE(q.size() == 1);
+    REQUIRE(result == true);
+    REQUIRE(item == nullptr);
+
+    int* items[10];
+    auto count = q.pop(items, 1, 10, 0);
+    REQUIRE(count == 1);
+    REQUIRE(q.size() == 0);
+    REQUIRE(*(items[0]) == 22);
+
+    *(items[0]) = 33;
+    items[1] = new int {44};
+    items[2] = new int {55};
+
+    size_t reserve_count = q.reserve(3, 5, 0);
+    REQUIRE(reserve_count == 5);
+
+    q.push_and_unreserve(items, 3, reserve_count, 0);
+    REQUIRE(q.size() == 3);
+
+    count = q.pop_and_reserve(items, 2, 2, 0);
+    REQUIRE(count == 2);
+    REQUIRE(q.size() == 1);
+    REQUIRE(*(items[0]) == 33);
+    REQUIRE(*(items[1]) == 44);
+
+    // Not enough items to satisfy min_requested_count
+    int* leftover[10];
+    count = q.pop(leftover, 2, 10, 0);
+    REQUIRE(count == 0);
+
+    count = q.pop(leftover, 1, 10, 0);
+    REQUIRE(count == 1);
+    REQUIRE(*(leftover[0]) == 55);
+    q.unreserve(2, 0);
+
+    delete items[0];
+    delete items[1];
+    delete leftover[0];
+}
+
+
+TEST_CASE("QueueTests_LockFreeRespectsThreshold") {
+
+    JMailbox<int*> q(4, 1, false, true);
+    int values[8] = {0,1,2,3,4,5,6,7};
+    int* items[8];
+    for (int i=0; i<8; ++i) items[i] = &values[i];
+
+    REQUIRE(q.try_push(items, 3, 0) == true);
+    REQUIRE(q.try_push(items+3, 2, 0) == false); // Would exceed threshold
+    REQUIRE(q.reserve(1, 5, 0) == 1);
+    REQUIRE(q.reserve(1, 5, 0) == 0);             // Reservations count against the threshold too
+    q.unreserve(1, 0);
+    REQUIRE(q.try_push(items+3, 1, 0) == true);
+    REQUIRE(q.size() == 4);
+
+    int* popped[8];
+    REQUIRE(q.pop(popped, 1, 8, 0) == 4);
+    for (int i=0; i<4; ++i) {
+        REQUIRE(*popped[i] == i); // FIFO
+    }
+}
+
+
+TEST_CASE("QueueTests_LockFreeVectorApi") {
+
+    JMailbox<int> q(10, 1, false, true);
+    std::vector<int> in {1,2,3};
+    REQUIRE(q.push(in) == JMailbox<int>::Status::Ready);
+    REQUIRE(in.empty());
+
+    std::vector<int> out;
+    REQUIRE(q.pop(out, 2) == JMailbox<int>::Status::Ready);
+    REQUIRE(out == std::vector<int>{1,2});
+
+    int x = 0;
+    bool success = false;
+    REQUIRE(q.pop(x, success) == JMailbox<int>::Status::Empty);
+    REQUIRE(success);
+    REQUIRE(x == 3);
+
+    q.pop(x, success);
+    REQUIRE(!success);
+}
+
+TEST_CASE("QueueTests_LockFreeUnreservedOverflow") {
+
+    // A push past the soft threshold never fails, even once the ring (2*threshold) is physically full
+    JMailbox<int> q(2, 1, false, true);
+    std::vector<int> in;
+    for (int i=0; i<20; ++i) in.push_back(i);
+    REQUIRE(q.push(in) == JMailbox<int>::Status::Full);
+    REQUIRE(q.size() == 20);
+
+    std::vector<int> out;
+    while (out.size() < 20) {
+        std::vector<int> chunk;
+        q.pop(chunk, 3);
+        REQUIRE(!chunk.empty());
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+    std::sort(out.begin(), out.end());
+    for (int i=0; i<20; ++i) REQUIRE(out[i] == i);
+    REQUIRE(q.size() == 0);
+}
+
+/// Hammers a single queue with several producers and consumers using the reserve/push_and_unreserve/
+/// pop_and_reserve protocol which the arrows use. Every item must come out exactly once, and the
+/// queue must never hold more than its threshold.
+void StressTestMailbox(bool enable_lock_free) {
+
+    const size_t threshold = 16;
+    const size_t producer_count = 4;
+    const size_t consumer_count = 4;
+    const size_t items_per_producer = 20000;
+    const size_t chunksize = 5;
+
+    JMailbox<size_t*> q(threshold, 1, false, enable_lock_free);
+    std::vector<size_t> values(producer_count * items_per_producer);
+    std::vector<std::atomic<int>> seen(values.size());
+    for (size_t i=0; i<values.size(); ++i) {
+        values[i] = i;
+        seen[i] = 0;
+    }
+    std::atomic<size_t> consumed_count {0};
+    std::atomic<bool> exceeded_threshold {false};
+
+    std::vector<std::thread> threads;
+    for (size_t p=0; p<producer_count; ++p) {
+        threads.emplace_back([&, p]() {
+            size_t next = p * items_per_producer;
+            size_t end = next + items_per_producer;
+            size_t* buffer[chunksize];
+            while (next < end) {
+                size_t reserved = q.reserve(1, chunksize, 0);
+                if (reserved == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                size_t count = std::min(reserved, end - next);
+                for (size_t i=0; i<count; ++i) {
+                    buffer[i] = &values[next++];
+                }
+                q.push_and_unreserve(buffer, count, reserved, 0);
+                if (enable_lock_free && q.size(0) > threshold) exceeded_threshold = true;
+            }
+        });
+    }
+    for (size_t c=0; c<consumer_count; ++c) {
+        threads.emplace_back([&]() {
+            size_t* buffer[chunksize];
+            while (consumed_count < values.size()) {
+                size_t count = q.pop_and_reserve(buffer, 1, chunksize, 0);
+                if (count == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t i=0; i<count; ++i) {
+                    seen[*buffer[i]]++;
+                }
+                consumed_count += count;
+                q.unreserve(count, 0);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    REQUIRE(!exceeded_threshold);
+    REQUIRE(consumed_count == values.size());
+    REQUIRE(q.size() == 0);
+    size_t wrong_count = 0;
+    for (auto& s : seen) {
+        if (s != 1) wrong_count++;
+    }
+    REQUIRE(wrong_count == 0);
+    REQUIRE(q.reserve(0, threshold, 0) == threshold); // No reservations were leaked
+}
+
+TEST_CASE("QueueTests_StressLocked") {
+    StressTestMailbox(false);
+}
+
+TEST_CASE("QueueTests_StressLockFree") {
+    StressTestMailbox(true);
+}
+
+TEST_CASE("QueueTests_RingBufferNonDefaultConstructible") {
+
+    struct Wrapper {
+        int value;
+        explicit Wrapper(int v) : value(v) {}
+    };
+    JRingBuffer<Wrapper> ring(3);
+    REQUIRE(ring.capacity() == 4);
+
+    Wrapper items[] = {Wrapper(1), Wrapper(2), Wrapper(3), Wrapper(4), Wrapper(5)};
+    REQUIRE(ring.try_push(items, 4) == true);
+    REQUIRE(ring.try_push(items+4, 1) == false); // Physically full
+    REQUIRE(ring.size() == 4);
+
+    std::vector<Wrapper> out;
+    size_t count = ring.try_consume(1, 3, [&](size_t, Wrapper&& w) { out.push_back(std::move(w)); });
+    REQUIRE(count == 3);
+    REQUIRE(out[2].value == 3);
+    REQUIRE(ring.try_push(items+4, 1) == true); // Wraps around
+    count = ring.try_consume(1, 10, [&](size_t, Wrapper&& w) { out.push_back(std::move(w)); });
+    REQUIRE(count == 2);
+    REQUIRE(out[3].value == 4);
+    REQUIRE(out[4].value == 5);
+}
+
+
+TEST_CASE("QueueTests_WorkStealing") {
+
+    int values[6] = {0,1,2,3,4,5};
+    int* items[6];
+
+    for (bool lock_free : {false, true}) {
+        for (int i=0; i<6; ++i) items[i] = &values[i]; // try_push() nulls these out
+        JMailbox<int*> q(10, 3, true, lock_free);
+
+        // Location 0 is nearer to location 2 than to location 1
+        q.set_location_distances({{0, 20, 10}, {20, 0, 10}, {10, 10, 0}});
+        REQUIRE(q.get_steal_order(0) == std::vector<size_t>{2, 1});
+        REQUIRE(q.get_steal_order(1) == std::vector<size_t>{2, 0});
+
+        REQUIRE(q.try_push(items, 2, 1));
+        REQUIRE(q.try_push(items+2, 2, 2));
+
+        int* stolen[6];
+        // Nothing local
+        REQUIRE(q.pop_and_reserve(stolen, 1, 6, 0) == 0);
+
+        // Nearest victim (location 2) is visited first
+        size_t count = q.steal_and_reserve(stolen, 1, 6, 0);
+        REQUIRE(count == 2);
+        REQUIRE(*stolen[0] == 2);
+        REQUIRE(*stolen[1] == 3);
+        REQUIRE(q.size(2) == 0);
+
+        // Stolen items are reserved against the thief's location
+        q.push_and_unreserve(stolen, 0, count, 0);
+        REQUIRE(q.reserve(0, 10, 0) == 10);
+        q.unreserve(10, 0);
+
+        count = q.steal_and_reserve(stolen, 1, 6, 0);
+        REQUIRE(count == 2);
+        REQUIRE(*stolen[0] == 0);
+        q.unreserve(count, 0);
+
+        REQUIRE(q.steal_and_reserve(stolen, 1, 6, 0) == 0);
+        REQUIRE(q.size() == 0);
+    }
+
+    JMailbox<int*> no_stealing(10, 2, false);
+    items[0] = &values[0];
+    REQUIRE(no_stealing.try_push(items, 1, 1));
+    int* stolen;
+    REQUIRE(no_stealing.steal_and_reserve(&stolen, 1, 1, 0) == 0);
+}
@@ -0,0 +1,157 @@
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <catch.hpp>
+#include <JANA/Utils/JArena.h>
+#include <JANA/Utils/JEventPool.h>
+#include <JANA/JApplication.h>
+#include <JANA/JFactoryT.h>
+
+#include <cstdint>
+#include <thread>
+
+namespace arenatests {
+
+struct Tracked {
+    static std::vector<int> destroyed;
+    int id;
+    explicit Tracked(int id) : id(id) {}
+    ~Tracked() { destroyed.push_back(id); }
+};
+std::vector<int> Tracked::destroyed;
+
+struct alignas(64) Overaligned { char c; };
+
+
+TEST_CASE("JArena_Basics") {
+    JArena arena(256);
+    Tracked::destroyed.clear();
+
+    SECTION("Objects are aligned and owned") {
+        auto* c = arena.Create<char>('x');
+        auto* o = arena.Create<Overaligned>();
+        auto* d = arena.Create<double>(22.0);
+        REQUIRE(*c == 'x');
+        REQUIRE(*d == 22.0);
+        REQUIRE(reinterpret_cast<uintptr_t>(o) % 64 == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(d) % alignof(double) == 0);
+        REQUIRE(arena.Owns(c));
+        REQUIRE(arena.Owns(d));
+        REQUIRE(arena.GetObjectCount() == 3);
+
+        int outside;
+        REQUIRE(!arena.Owns(&outside));
+    }
+
+    SECTION("Reset runs destructors newest first") {
+        arena.Create<Tracked>(1);
+        arena.Create<Tracked>(2);
+        arena.Create<Tracked>(3);
+        REQUIRE(Tracked::destroyed.empty());
+        arena.Reset();
+        REQUIRE(Tracked::destroyed == std::vector<int>{3, 2, 1});
+        REQUIRE(arena.GetBytesAllocated() == 0);
+        REQUIRE(arena.GetObjectCount() == 0);
+    }
+
+    SECTION("Chunks grow, then get merged and reused") {
+        for (int i=0; i<100; ++i) arena.Allocate(32);
+        REQUIRE(arena.GetChunkCount() > 1);
+        size_t capacity = arena.GetCapacity();
+        REQUIRE(capacity >= 3200);
+
+        arena.Reset();
+        REQUIRE(arena.GetChunkCount() == 1);
+        REQUIRE(arena.GetCapacity() == capacity);
+
+        // The next event of the same size fits without allocating
+        for (int i=0; i<100; ++i) arena.Allocate(32);
+        REQUIRE(arena.GetChunkCount() == 1);
+    }
+
+    SECTION("Allocations larger than a chunk") {
+        void* big = arena.Allocate(10000);
+        REQUIRE(arena.Owns(big));
+        REQUIRE(arena.Owns(static_cast<char*>(big) + 9999));
+    }
+}
+
+
+struct ArenaFactory : public JFactoryT<Tracked> {
+    int next_id = 0;
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        Insert(NewObject(next_id++));
+        Insert(NewObject(next_id++));
+    }
+};
+
+
+TEST_CASE("JArena_FactoryObjectsLiveInEventArena") {
+    JApplication app;
+    app.SetParameterValue("log:global", "OFF");
+    app.Initialize();
+    Tracked::destroyed.clear();
+
+    JEventPool pool {app.GetService<JComponentManager>(), 1, 1, true};
+    pool.init();
+    auto* event = pool.get();
+    REQUIRE(event != nullptr);
+
+    auto factory = new ArenaFactory;
+    bool use_arena = GENERATE(true, false);
+    factory->SetUseArena(use_arena);
+    (*event)->GetFactorySet()->Add(factory);
+    REQUIRE(factory->GetArena() == &(*event)->GetArena());
+
+    auto objects = (*event)->Get<Tracked>();
+    REQUIRE(objects.size() == 2);
+    REQUIRE((*event)->GetArena().Owns(objects[0]) == use_arena);
+    REQUIRE((*event)->GetArena().Owns(objects[1]) == use_arena);
+
+    // Recycling the event destroys each object exactly once, whether or not it came from the arena
+    pool.put(event);
+    REQUIRE(Tracked::destroyed.size() == 2);
+    REQUIRE((*event)->GetArena().GetObjectCount() == 0);
+}
+
+
+TEST_CASE("JArena_LocksOnlyInConcurrentCreateMode") {
+    auto event = std::make_shared<JEvent>();
+    JArena& arena = event->GetArena();
+    REQUIRE(!arena.IsThreadSafe());
+    arena.Create<Tracked>(1);
+
+    // Objects from a factory which didn't opt in are still deleted, even though the arena is in use
+    auto factory = new ArenaFactory;
+    event->GetFactorySet()->Add(factory);
+    REQUIRE(event->Get<Tracked>().size() == 2);
+    Tracked::destroyed.clear();
+    factory->ClearData();
+    REQUIRE(Tracked::destroyed.size() == 2);
+
+    event->GetFactorySet()->EnableConcurrentCreate();
+    REQUIRE(arena.IsThreadSafe());
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i=0; i<1000; ++i) arena.Create<Tracked>(i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(arena.GetObjectCount() == 4001);
+    arena.Reset();
+}
+
+
+TEST_CASE("JArena_PersistentFactoriesIgnoreArena") {
+    JEvent event;
+    auto factory = new ArenaFactory;
+    factory->SetUseArena(true);
+    factory->SetFactoryFlag(JFactory::PERSISTENT);
+    event.GetFactorySet()->Add(factory);
+    auto obj = factory->NewObject(7);
+    REQUIRE(!event.GetArena().Owns(obj));
+    delete obj;
+}
+
+} // namespace arenatests
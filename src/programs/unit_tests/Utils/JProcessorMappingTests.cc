@@ -0,0 +1,138 @@
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <catch.hpp>
+#include <JANA/Utils/JProcessorMapping.h>
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <unistd.h>
+
+namespace processormappingtests {
+
+namespace fs = std::filesystem;
+
+void write_file(const fs::path& path, const std::string& contents) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path);
+    out << contents << std::endl;
+}
+
+/// FakeSysfs builds a 2-socket machine with 8 physical cores and 16 hyperthreads under a temp directory.
+/// Cpus 0-7 are the first hyperthread of cores 0-7 and cpus 8-15 are their siblings, as on most x86 boxes.
+/// Each socket is its own NUMA domain and each pair of cores shares an L3.
+struct FakeSysfs {
+    fs::path root;
+
+    FakeSysfs() {
+        root = fs::temp_directory_path() / ("jana_fake_sysfs_" + std::to_string(getpid()));
+        fs::remove_all(root);
+        fs::path cpu_dir = root / "devices/system/cpu";
+        fs::path node_dir = root / "devices/system/node";
+        write_file(cpu_dir / "online", "0-15");
+        write_file(node_dir / "online", "0-1");
+        write_file(node_dir / "node0/cpulist", "0-3,8-11");
+        write_file(node_dir / "node1/cpulist", "4-7,12-15");
+        write_file(node_dir / "node0/distance", "10 21");
+        write_file(node_dir / "node1/distance", "21 10");
+
+        for (size_t cpu=0; cpu<16; ++cpu) {
+            size_t core = cpu % 8;
+            size_t first = (core / 2) * 2;
+            fs::path dir = cpu_dir / ("cpu" + std::to_string(cpu));
+            write_file(dir / "topology/physical_package_id", std::to_string(core / 4));
+            write_file(dir / "topology/core_id", std::to_string(core % 4));
+            write_file(dir / "cache/index0/level", "1");
+            write_file(dir / "cache/index0/shared_cpu_list", std::to_string(core) + "," + std::to_string(core+8));
+            write_file(dir / "cache/index1/level", "3");
+            write_file(dir / "cache/index1/shared_cpu_list",
+                       std::to_string(first) + "-" + std::to_string(first+1) + "," +
+                       std::to_string(first+8) + "-" + std::to_string(first+9));
+        }
+    }
+    ~FakeSysfs() {
+        fs::remove_all(root);
+    }
+};
+
+
+TEST_CASE("JProcessorMapping_ParseCpuList") {
+    REQUIRE(JProcessorMapping::parse_cpu_list("0") == std::vector<size_t>{0});
+    REQUIRE(JProcessorMapping::parse_cpu_list("0-3,8,10-11") == std::vector<size_t>{0,1,2,3,8,10,11});
+    REQUIRE(JProcessorMapping::parse_cpu_list("4-5,0-1") == std::vector<size_t>{0,1,4,5});
+    REQUIRE(JProcessorMapping::parse_cpu_list("").empty());
+}
+
+
+TEST_CASE("JProcessorMapping_Sysfs") {
+    FakeSysfs sysfs;
+    JProcessorMapping sut;
+    sut.set_sysfs_root(sysfs.root.string());
+
+    SECTION("NUMA-local locations") {
+        sut.initialize(JProcessorMapping::AffinityStrategy::MemoryBound, JProcessorMapping::LocalityStrategy::NumaDomainLocal);
+        REQUIRE(sut.is_initialized());
+        REQUIRE(sut.get_cpu_count() == 16);
+        REQUIRE(sut.get_loc_count() == 2);
+        auto cpus = sut.get_loc_cpus();
+        REQUIRE(cpus[0] == std::vector<size_t>{0,1,2,3,8,9,10,11});
+        REQUIRE(cpus[1] == std::vector<size_t>{4,5,6,7,12,13,14,15});
+        REQUIRE(sut.get_loc_distances()[0][1] > sut.get_loc_distances()[0][0]);
+    }
+
+    SECTION("L3-local locations") {
+        sut.initialize(JProcessorMapping::AffinityStrategy::None, JProcessorMapping::LocalityStrategy::CacheLocal);
+        REQUIRE(sut.get_loc_count() == 4);
+        auto cpus = sut.get_loc_cpus();
+        REQUIRE(cpus[0] == std::vector<size_t>{0,1,8,9});
+        REQUIRE(cpus[3] == std::vector<size_t>{6,7,14,15});
+        // Sharing a NUMA domain makes an L3 closer than one on the other socket
+        REQUIRE(sut.get_loc_distances()[0][1] < sut.get_loc_distances()[0][2]);
+    }
+
+    SECTION("Core-local locations use globally unique core ids") {
+        sut.initialize(JProcessorMapping::AffinityStrategy::None, JProcessorMapping::LocalityStrategy::CoreLocal);
+        REQUIRE(sut.get_loc_count() == 8);
+        REQUIRE(sut.get_loc_cpus()[4] == std::vector<size_t>{4,12});
+    }
+
+    SECTION("CacheBound packs workers by L3, physical cores first") {
+        sut.initialize(JProcessorMapping::AffinityStrategy::CacheBound, JProcessorMapping::LocalityStrategy::Global);
+        std::vector<size_t> order;
+        for (size_t worker=0; worker<16; ++worker) order.push_back(sut.get_cpu_id(worker));
+        REQUIRE(order == std::vector<size_t>{0,1,8,9, 2,3,10,11, 4,5,12,13, 6,7,14,15});
+    }
+
+    SECTION("Efficiency cores are scheduled last") {
+        write_file(sysfs.root / "devices/cpu_atom/cpus", "2-3,10-11");
+        sut.initialize(JProcessorMapping::AffinityStrategy::ComputeBound, JProcessorMapping::LocalityStrategy::Global);
+        REQUIRE(sut.get_cpu_id(0) == 0);
+        REQUIRE(sut.get_core_class(0) == 0);
+        for (size_t worker=12; worker<16; ++worker) {
+            REQUIRE(sut.get_core_class(worker) == 1);
+        }
+        REQUIRE(sut.get_cpu_id(12) == 2);
+    }
+
+    SECTION("Cgroup cpuset restricts the cpus and renumbers locations") {
+        write_file(sysfs.root / "fs/cgroup/cpuset.cpus.effective", "4-7");
+        sut.initialize(JProcessorMapping::AffinityStrategy::MemoryBound, JProcessorMapping::LocalityStrategy::NumaDomainLocal);
+        REQUIRE(sut.get_cpu_count() == 4);
+        REQUIRE(sut.get_loc_count() == 1);
+        REQUIRE(sut.get_loc_numa_domains()[0] == std::vector<size_t>{1});
+        std::set<size_t> cpus;
+        for (size_t worker=0; worker<4; ++worker) cpus.insert(sut.get_cpu_id(worker));
+        REQUIRE(cpus == std::set<size_t>{4,5,6,7});
+    }
+
+    SECTION("Missing sysfs is reported, not fatal") {
+        sut.set_sysfs_root((sysfs.root / "nonexistent").string());
+        sut.initialize(JProcessorMapping::AffinityStrategy::MemoryBound, JProcessorMapping::LocalityStrategy::NumaDomainLocal);
+        REQUIRE(!sut.is_initialized());
+        REQUIRE(sut.get_loc_count() == 1);
+        REQUIRE(sut.get_cpu_id(3) == 3);
+    }
+}
+
+} // namespace processormappingtests
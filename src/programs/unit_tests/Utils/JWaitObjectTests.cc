@@ -0,0 +1,79 @@
+// Copyright 2024, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <catch.hpp>
+#include <JANA/Utils/JWaitObject.h>
+#include <JANA/Topology/JMailbox.h>
+#include <JANA/Topology/JPool.h>
+#include <thread>
+
+
+TEST_CASE("JWaitObject_NotifyBeforeWait") {
+    JWaitObject w;
+    uint64_t epoch = w.prepare_wait();
+    w.notify();
+    // A notify() between registering and waiting must not be lost
+    REQUIRE(w.commit_wait(epoch, std::chrono::seconds(10)) == true);
+    REQUIRE(w.get_waiter_count() == 0);
+}
+
+TEST_CASE("JWaitObject_NoWaitersNoEpochBump") {
+    JWaitObject w;
+    uint64_t epoch = w.get_epoch();
+    w.notify();
+    REQUIRE(w.get_epoch() == epoch);
+
+    w.prepare_wait();
+    w.cancel_wait();
+    w.notify();
+    REQUIRE(w.get_epoch() == epoch);
+}
+
+TEST_CASE("JWaitObject_Timeout") {
+    JWaitObject w;
+    uint64_t epoch = w.prepare_wait();
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(w.commit_wait(epoch, std::chrono::milliseconds(5), 10) == false);
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5));
+    REQUIRE(w.get_waiter_count() == 0);
+}
+
+TEST_CASE("JWaitObject_WakesParkedThread") {
+    JWaitObject w;
+    bool woken = false;
+    std::thread waiter([&]() {
+        uint64_t epoch = w.prepare_wait();
+        woken = w.commit_wait(epoch, std::chrono::seconds(10));
+    });
+    while (w.get_waiter_count() == 0) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    w.notify();
+    waiter.join();
+    REQUIRE(woken);
+    // Nowhere near the 10s timeout
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST_CASE("JWaitObject_PlacesNotifyOnPush") {
+    SECTION("JMailbox") {
+        JMailbox<int*> mailbox {10, 1, false, GENERATE(false, true)};
+        int x = 22;
+        int* item = &x;
+        uint64_t epoch = mailbox.get_wait_object().prepare_wait();
+        REQUIRE(mailbox.reserve(1, 1, 0) == 1);
+        mailbox.push_and_unreserve(&item, 1, 1, 0);
+        REQUIRE(mailbox.get_wait_object().commit_wait(epoch, std::chrono::seconds(10)) == true);
+        REQUIRE(mailbox.pop(&item, 1, 1, 0) == 1);
+    }
+    SECTION("JPool") {
+        JPool<int> pool {2, 1, true};
+        pool.init();
+        int* item = nullptr;
+        REQUIRE(pool.pop(&item, 1, 1, 0) == 1);
+        uint64_t epoch = pool.get_wait_object().prepare_wait();
+        pool.push(&item, 1, 0);
+        REQUIRE(pool.get_wait_object().commit_wait(epoch, std::chrono::seconds(10)) == true);
+    }
+}